@@ -74,7 +74,7 @@ static void usage(const char* progname, int is_help) {
             "    -h: print all commands\n"
 #ifdef HAVE_JSON
             "    -V: print version info and supported extensions as JSON\n"
-            "    -I: print requested file info as JSON\n"
+            "    -I: print requested file info as JSON (IO stats go to stderr after decoding, or in the JSON with -m)\n"
 #endif
             , progname);
     if (!is_help)
@@ -93,6 +93,15 @@ static void usage(const char* progname, int is_help) {
             "    -T: print title (for title testing)\n"
             "    -D <max channels>: downmix to <max channels> (for plugin downmix testing)\n"
             "    -O: decode but don't write to file (for performance testing)\n"
+            "    -j N: decode channels with N threads, for codecs that allow it (-1 = all CPUs)\n"
+            "    -y N: pre-scan and save decoder state every N samples for faster seeks (for seek testing)\n"
+            "    -Y <dir>: with -y, load pre-scanned state from cache dir or save it there if missing (PCM/ADPCM only)\n"
+            "    -R: read files ahead in a background thread (for slow storage like network drives)\n"
+            "    -M: read files through memory mapping (for big banks that jump around)\n"
+            "    -X: load whole files into memory before decoding (for IO testing)\n"
+#ifdef HAVE_JSON
+            "    -J <file>: write per-format detection stats of all files as JSON (for performance testing)\n"
+#endif
     );
 
 }
@@ -114,6 +123,7 @@ typedef struct {
     int print_metaonly;
 #ifdef HAVE_JSON
     int print_metajson;
+    const char* probe_filename;
 #endif
     int print_adxencd;
     int print_oggenc;
@@ -138,14 +148,23 @@ typedef struct {
     int decode_only;
     int show_title;
     int downmix_channels;
+    int decode_threads;
+    int seek_interval;
+    const char* seek_cache_dir;
+    int readahead;
+    int use_mmap;
+    int use_memory;
 
     /* not quite config but eh */
     int lwav_loop_start;
     int lwav_loop_end;
+    dircache_t* dircache; /* shared by all files, to skip checking missing companion files */
 } cli_config;
 #ifdef HAVE_JSON
 static void print_json_version();
-static void print_json_info(VGMSTREAM* vgm, cli_config* cfg);
+static void print_json_info(VGMSTREAM* vgm, cli_config* cfg, STREAMFILE* sf);
+static void print_json_io_stats(STREAMFILE* sf);
+static void print_json_probe_profile(cli_config* cfg);
 #endif
 
 
@@ -163,9 +182,9 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
     optind = 1; /* reset getopt's ugly globals (needed in wasm that may call same main() multiple times) */
 
     /* read config */
-    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLEFrgb2:s:tTk:K:hOvD:S:"
+    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLEFrgb2:s:tTk:K:hOvD:S:j:y:Y:RMX"
 #ifdef HAVE_JSON
-        "VI"
+        "VIJ:"
 #endif
     )) != -1) {
         switch (opt) {
@@ -257,6 +276,24 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
             case 'D':
                 cfg->downmix_channels = atoi(optarg);
                 break;
+            case 'j':
+                cfg->decode_threads = atoi(optarg);
+                break;
+            case 'y':
+                cfg->seek_interval = atoi(optarg);
+                break;
+            case 'Y':
+                cfg->seek_cache_dir = optarg;
+                break;
+            case 'R':
+                cfg->readahead = 1;
+                break;
+            case 'M':
+                cfg->use_mmap = 1;
+                break;
+            case 'X':
+                cfg->use_memory = 1;
+                break;
             case 'h':
                 usage(argv[0], 1);
                 goto fail;
@@ -267,6 +304,9 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
             case 'I':
                 cfg->print_metajson = 1;
                 break;
+            case 'J':
+                cfg->probe_filename = optarg;
+                break;
 #endif
             case '?':
                 fprintf(stderr, "missing argument or unknown option -%c\n", optopt);
@@ -608,6 +648,12 @@ int main(int argc, char** argv) {
     res = validate_config(&cfg);
     if (!res) goto fail;
 
+    cfg.dircache = dircache_init(); /* optional */
+#ifdef HAVE_JSON
+    if (cfg.probe_filename)
+        vgmstream_set_probe_profile(1);
+#endif
+
     ok = 0;
     for (i = 0; i < cfg.infilenames_count; i++) {
         /* current name, to avoid passing params all the time */
@@ -627,6 +673,14 @@ int main(int argc, char** argv) {
         }
     }
 
+    dircache_free(cfg.dircache);
+#ifdef HAVE_JSON
+    if (cfg.probe_filename) {
+        print_json_probe_profile(&cfg);
+        vgmstream_set_probe_profile(0);
+    }
+#endif
+
     /* ok if at least one succeeds, for programs that check result code */
     if (!ok)
         goto fail;
@@ -675,8 +729,45 @@ fail:
 }
 
 
+/* companion files (.txth, .acb, etc) of loaded files are read from disk as usual */
+static STREAMFILE* open_memory_companion(void* user_data, const char* filename) {
+    return open_stdio_streamfile_dircache(filename, user_data);
+}
+
+/* loads the whole file and reads it through a memory SF (buffer is freed once all reopens are closed) */
+static STREAMFILE* open_memory_file(cli_config* cfg) {
+    STREAMFILE* sf = NULL;
+    uint8_t* data = NULL;
+    FILE* infile;
+    long size;
+
+    infile = fopen(cfg->infilename, "rb");
+    if (!infile) return NULL;
+
+    if (fseek(infile, 0, SEEK_END) != 0)
+        goto fail;
+    size = ftell(infile);
+    if (size <= 0 || fseek(infile, 0, SEEK_SET) != 0)
+        goto fail;
+
+    data = malloc(size);
+    if (!data) goto fail;
+    if (fread(data, 1, size, infile) != size)
+        goto fail;
+    fclose(infile);
+
+    sf = open_memory_streamfile_ex(data, size, cfg->infilename, free, open_memory_companion, cfg->dircache);
+    if (!sf) free(data);
+    return sf;
+fail:
+    free(data);
+    fclose(infile);
+    return NULL;
+}
+
 static int convert_file(cli_config* cfg) {
     VGMSTREAM* vgmstream = NULL;
+    STREAMFILE* sf = NULL;
     char outfilename_temp[PATH_LIMIT];
     int32_t len_samples;
 
@@ -699,15 +790,38 @@ static int convert_file(cli_config* cfg) {
 
     /* open streamfile and pass subsong */
     {
-        STREAMFILE* sf = open_stdio_streamfile(cfg->infilename);
+        /* decode threads read channels from reopened SFs at the same time, and stdio's may share positions.
+         * Otherwise the main file keeps a few pages, as banks often jump between header tables and data
+         * (channel reopens use regular sizes and get a single buffer). Mapped and loaded files can do both. */
+        if (cfg->use_memory)
+            sf = open_memory_file(cfg);
+        else if (cfg->use_mmap)
+            sf = open_mmap_streamfile_dircache(cfg->infilename, cfg->dircache);
+        else if (cfg->decode_threads)
+            sf = open_pread_streamfile_dircache(cfg->infilename, cfg->dircache);
+        else
+            sf = open_stdio_streamfile_paged(cfg->infilename, 0, 4, cfg->dircache);
         if (!sf) {
             fprintf(stderr, "file %s not found\n", cfg->infilename);
             goto fail;
         }
 
+        /* reopens (channels, companion files) read ahead too, sharing the same thread */
+        if (cfg->readahead) {
+            sf = open_readahead_streamfile_f(sf, 0, 0);
+            if (!sf) goto fail;
+        }
+
+#ifdef HAVE_JSON
+        /* count IO done by the format/codec (base SF is kept open until the end to read counters) */
+        if (cfg->print_metajson) {
+            sf = open_stats_streamfile_f(sf);
+            if (!sf) goto fail;
+        }
+#endif
+
         sf->stream_index = cfg->subsong_index;
         vgmstream = init_vgmstream_from_STREAMFILE(sf);
-        close_streamfile(sf);
 
         if (!vgmstream) {
             fprintf(stderr, "failed opening %s\n", cfg->infilename);
@@ -718,6 +832,7 @@ static int convert_file(cli_config* cfg) {
         if (cfg->subsong_end == -1) {
             cfg->subsong_end = vgmstream->num_streams;
             close_vgmstream(vgmstream);
+            close_streamfile(sf);
             return 1;
         }
     }
@@ -735,6 +850,20 @@ static int convert_file(cli_config* cfg) {
     }
     vgmstream_mixing_enable(vgmstream, SAMPLE_BUFFER_SIZE, NULL, NULL);
 
+    if (cfg->decode_threads) {
+        vgmstream_set_decode_threads(vgmstream, cfg->decode_threads);
+    }
+
+    if (cfg->seek_interval > 0) {
+        vgmstream_set_seek_table(vgmstream, cfg->seek_interval);
+
+        if (!cfg->seek_cache_dir || !vgmstream_load_seek_table(vgmstream, cfg->seek_cache_dir)) {
+            vgmstream_scan_seek_table(vgmstream);
+            if (cfg->seek_cache_dir)
+                vgmstream_save_seek_table(vgmstream, cfg->seek_cache_dir);
+        }
+    }
+
     /* get final play config */
     len_samples = vgmstream_get_samples(vgmstream);
     if (len_samples <= 0) {
@@ -804,7 +933,7 @@ static int convert_file(cli_config* cfg) {
 #ifdef HAVE_JSON
     }
     else {
-        print_json_info(vgmstream, cfg);
+        print_json_info(vgmstream, cfg, sf);
         printf("\n");
     }
 #endif
@@ -812,6 +941,7 @@ static int convert_file(cli_config* cfg) {
     /* prints done */
     if (cfg->print_metaonly) {
         close_vgmstream(vgmstream);
+        close_streamfile(sf);
         return 1;
     }
 
@@ -833,11 +963,20 @@ static int convert_file(cli_config* cfg) {
         write_file(vgmstream, cfg);
     }
 
+#ifdef HAVE_JSON
+    /* apart from info, as stdout may have the decoded .wav */
+    if (cfg->print_metajson) {
+        print_json_io_stats(sf);
+    }
+#endif
+
     close_vgmstream(vgmstream);
+    close_streamfile(sf);
     return 1;
 
 fail:
     close_vgmstream(vgmstream);
+    close_streamfile(sf);
     return 0;
 }
 
@@ -944,7 +1083,38 @@ fail:
 
 
 #ifdef HAVE_JSON
-static void print_json_info(VGMSTREAM* vgm, cli_config* cfg) {
+static json_t* get_json_io_stats(STREAMFILE* sf) {
+    streamfile_stats_t stats;
+
+    if (!get_streamfile_stats(sf, &stats))
+        return NULL;
+
+    return json_pack("{sIsIsIsIsIsI}",
+        "readCalls", (json_int_t)stats.read_calls,
+        "bytesRequested", (json_int_t)stats.bytes_requested,
+        "bytesRead", (json_int_t)stats.bytes_read,
+        "rebuffers", (json_int_t)stats.rebuffers,
+        "backwardJumps", (json_int_t)stats.backward_jumps,
+        "openCalls", (json_int_t)stats.open_calls
+    );
+}
+
+/* IO done by the format and codec, as a separate JSON line in stderr */
+static void print_json_io_stats(STREAMFILE* sf) {
+    json_t* io_stats = get_json_io_stats(sf);
+    json_t* final_object;
+
+    if (!io_stats)
+        return;
+
+    final_object = json_pack("{so}", "ioStats", io_stats);
+    json_dumpf(final_object, stderr, JSON_COMPACT);
+    fprintf(stderr, "\n");
+
+    json_decref(final_object);
+}
+
+static void print_json_info(VGMSTREAM* vgm, cli_config* cfg, STREAMFILE* sf) {
     json_t* version_string = json_string(VGMSTREAM_VERSION);
     vgmstream_info info;
     describe_vgmstream_info(vgm, &info);
@@ -986,6 +1156,13 @@ static void print_json_info(VGMSTREAM* vgm, cli_config* cfg) {
         json_object_set(stream_info, "name", json_null());
     }
 
+    /* when only printing meta, IO done so far (otherwise printed after decoding) */
+    json_t* io_stats = NULL;
+
+    if (cfg->print_metaonly) {
+        io_stats = get_json_io_stats(sf);
+    }
+
     json_t* final_object = json_pack(
         "{sssisiso?siso?so?sisssssisssiso?}",
         "version", version_string,
@@ -1012,10 +1189,64 @@ static void print_json_info(VGMSTREAM* vgm, cli_config* cfg) {
         json_object_set(final_object, "channelLayout", json_null());
     }
 
+    if (io_stats) {
+        json_object_set_new(final_object, "ioStats", io_stats);
+    }
+
     json_dumpf(final_object, stdout, JSON_COMPACT);
 
     json_decref(final_object);
 }
+
+/* stats of all metas that were tried or skipped (in detection order) */
+static void print_json_probe_profile(cli_config* cfg) {
+    const vgmstream_probe_stats_t* stats;
+    int i, count;
+    FILE* outfile;
+
+    outfile = fopen(cfg->probe_filename, "w");
+    if (!outfile) {
+        fprintf(stderr, "failed to open %s for output\n", cfg->probe_filename);
+        return;
+    }
+
+    stats = vgmstream_get_probe_profile(&count);
+
+    json_t* meta_list = json_array();
+    for (i = 0; i < count; i++) {
+        const vgmstream_probe_stats_t* meta = &stats[i];
+        if (!meta->name)
+            continue;
+
+        json_t* meta_info = json_pack("{sssisssssisisisfsfsIsIsIsIsI}",
+            "name", meta->name,
+            "index", i,
+            "exts", meta->exts ? meta->exts : "*",
+            "format", meta->format,
+            "accepts", meta->accepts,
+            "rejects", meta->rejects,
+            "skips", meta->skips,
+            "acceptTimeMs", meta->accept_time * 1000.0,
+            "rejectTimeMs", meta->reject_time * 1000.0,
+            "acceptReads", (json_int_t)meta->accept_reads,
+            "acceptBytes", (json_int_t)meta->accept_bytes,
+            "rejectReads", (json_int_t)meta->reject_reads,
+            "rejectBytes", (json_int_t)meta->reject_bytes,
+            "opens", (json_int_t)meta->opens
+        );
+        json_array_append_new(meta_list, meta_info);
+    }
+
+    json_t* final_object = json_pack("{siso}",
+        "files", cfg->infilenames_count,
+        "metas", meta_list
+    );
+
+    json_dumpf(final_object, outfile, JSON_COMPACT);
+
+    json_decref(final_object);
+    fclose(outfile);
+}
 #endif
 
 static void make_smpl_chunk(uint8_t* buf, int32_t loop_start, int32_t loop_end) {
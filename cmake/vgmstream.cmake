@@ -24,6 +24,8 @@ macro(setup_target TARGET)
 	if(NOT WIN32 AND LINK)
 		# Include libm on non-Windows systems
 		target_link_libraries(${TARGET} m)
+		# pthreads for background/parallel work
+		target_link_libraries(${TARGET} pthread)
 	endif()
 
 	target_compile_definitions(${TARGET} PRIVATE VGM_LOG_OUTPUT)
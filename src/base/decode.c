@@ -4,6 +4,8 @@
 #include "decode.h"
 #include "mixing.h"
 #include "plugins.h"
+#include "../util/sf_utils.h"
+#include "../util/thread_pool.h"
 
 /* custom codec handling, not exactly "decode" stuff but here to simplify adding new codecs */
 
@@ -116,6 +118,8 @@ void decode_free(VGMSTREAM* vgmstream) {
     if (vgmstream->coding_type == coding_NWA) {
         free_nwa(vgmstream->codec_data);
     }
+
+    decode_setup_threads(vgmstream, 0);
 }
 
 
@@ -765,6 +769,491 @@ int decode_get_shortframe_size(VGMSTREAM* vgmstream) {
     }
 }
 
+void decode_silence(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer) {
+    int ch;
+
+    if (!buffer) /* skipping */
+        return;
+
+    if (vgmstream->planar_size) {
+        for (ch = 0; ch < vgmstream->channels; ch++) {
+            memset(buffer + ch * vgmstream->planar_size + samples_written, 0, samples_to_do * sizeof(sample_t));
+        }
+    }
+    else {
+        memset(buffer + samples_written * vgmstream->channels, 0, samples_to_do * vgmstream->channels * sizeof(sample_t));
+    }
+}
+
+/* Planar render: decoders that only use channelspacing to write output (not to read data)
+ * can write each channel to its own plane directly. */
+int decode_can_planar(VGMSTREAM* vgmstream) {
+    switch (vgmstream->coding_type) {
+        case coding_SILENCE:
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+        case coding_NGC_DSP:
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+        case coding_PCM8:
+        case coding_PCM8_U:
+        case coding_PCM8_SB:
+        case coding_PCM24LE:
+        case coding_PCM24BE:
+        case coding_PCMFLOAT:
+        case coding_ULAW:
+        case coding_ALAW:
+        case coding_PSX:
+        case coding_PSX_badflags:
+        case coding_PSX_cfg:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Decodes channels first..last-1 for codecs in decode_can_planar, where channel N's samples go to
+ * buffer + N * ch_step, separated by channelspacing (interleaved: channels and 1, planar: 1 and plane). */
+static void decode_channels(VGMSTREAM* vgmstream, sample_t* buffer, int channelspacing, int ch_step, int first, int last, int32_t first_sample, int32_t samples_to_do) {
+    int ch;
+
+    switch (vgmstream->coding_type) {
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+            for (ch = first; ch < last; ch++) {
+                decode_adx(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do,
+                        vgmstream->interleave_block_size, vgmstream->coding_type);
+            }
+            break;
+        case coding_NGC_DSP:
+            ch = first + decode_ngc_dsp_multi(vgmstream->ch + first, buffer + first*ch_step,
+                    channelspacing, ch_step, last - first, first_sample, samples_to_do);
+            for (; ch < last; ch++) {
+                decode_ngc_dsp(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+
+        case coding_PCM16LE:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm16le(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM16BE:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm16be(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM8:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm8(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM8_U:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm8_unsigned(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM8_SB:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm8_sb(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM24LE:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm24le(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCM24BE:
+            for (ch = first; ch < last; ch++) {
+                decode_pcm24be(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_PCMFLOAT:
+            for (ch = first; ch < last; ch++) {
+                decode_pcmfloat(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do,
+                        vgmstream->codec_endian);
+            }
+            break;
+        case coding_ULAW:
+            for (ch = first; ch < last; ch++) {
+                decode_ulaw(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+        case coding_ALAW:
+            for (ch = first; ch < last; ch++) {
+                decode_alaw(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do);
+            }
+            break;
+
+        case coding_PSX:
+        case coding_PSX_badflags: {
+            int is_badflags = (vgmstream->coding_type == coding_PSX_badflags);
+            ch = first + decode_psx_multi(vgmstream->ch + first, buffer + first*ch_step,
+                    channelspacing, ch_step, last - first, first_sample, samples_to_do,
+                    is_badflags, vgmstream->codec_config);
+            for (; ch < last; ch++) {
+                decode_psx(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do,
+                        is_badflags, vgmstream->codec_config);
+            }
+            break;
+        }
+        case coding_PSX_cfg:
+            for (ch = first; ch < last; ch++) {
+                decode_psx_configurable(&vgmstream->ch[ch], buffer + ch*ch_step,
+                        channelspacing, first_sample, samples_to_do,
+                        vgmstream->frame_size, vgmstream->codec_config);
+            }
+            break;
+
+        default: /* coding_SILENCE, or not supported */
+            for (ch = first; ch < last; ch++) {
+                int32_t s;
+                for (s = 0; s < samples_to_do; s++) {
+                    buffer[ch*ch_step + s*channelspacing] = 0;
+                }
+            }
+            break;
+    }
+}
+
+/* THREADS
+ * Codecs in decode_can_planar keep all state in their VGMSTREAMCHANNEL and don't move offsets, so
+ * groups of channels can be decoded at the same time. Each group gets its own STREAMFILE (their
+ * buffers aren't thread-safe), and calls only use the pool when they have enough samples to be worth it. */
+
+#define DECODE_THREADS_MIN_SAMPLES  1024
+
+typedef struct {
+    vgm_pool_t* pool;
+    int groups;
+    int group_channels;
+} decode_threads_t;
+
+typedef struct {
+    VGMSTREAM* vgmstream;
+    decode_threads_t* threads;
+    sample_t* buffer;
+    int channelspacing;
+    int ch_step;
+    int32_t samples_to_do;
+    int32_t samples_this_block;
+    off_t block_skip;
+} decode_threads_job_t;
+
+/* makes sure channels of each group don't share STREAMFILEs with other groups; returns 0 on failure */
+static int setup_threads_streamfiles(VGMSTREAM* vgmstream, decode_threads_t* threads) {
+    int group, ch, i;
+
+    /* groups read at the same time, which only some SFs allow */
+    for (ch = 0; ch < vgmstream->channels; ch++) {
+        STREAMFILE* sf = vgmstream->ch[ch].streamfile;
+        if (sf && !is_threadsafe_streamfile(sf)) {
+            VGM_LOG("DECODE: streamfile can't be read by threads\n");
+            return 0;
+        }
+    }
+
+    for (group = 1; group < threads->groups; group++) {
+        int first = group * threads->group_channels;
+        int last = first + threads->group_channels;
+        if (last > vgmstream->channels)
+            last = vgmstream->channels;
+
+        for (ch = first; ch < last; ch++) {
+            STREAMFILE* sf = vgmstream->ch[ch].streamfile;
+            STREAMFILE* new_sf;
+            char filename[PATH_LIMIT];
+            int is_shared = 0;
+
+            if (!sf)
+                continue;
+            for (i = 0; i < vgmstream->channels; i++) {
+                STREAMFILE* other_sf = vgmstream->ch[i].streamfile;
+                if (i >= first && i < last)
+                    continue;
+                if (other_sf == sf)
+                    is_shared = 1;
+                else if (other_sf && is_shared_streamfile(other_sf, sf))
+                    return 0; /* different SFs over a common one: can't reopen only this group's */
+            }
+            if (!is_shared)
+                continue;
+
+            get_streamfile_name(sf, filename, sizeof(filename));
+            new_sf = open_streamfile(sf, filename);
+            if (!new_sf) return 0;
+
+            /* rest of the group may use it too (current channels and saved loop state) */
+            for (i = ch; i < last; i++) {
+                if (vgmstream->ch[i].streamfile == sf)
+                    vgmstream->ch[i].streamfile = new_sf;
+                if (vgmstream->loop_ch && vgmstream->loop_ch[i].streamfile == sf)
+                    vgmstream->loop_ch[i].streamfile = new_sf;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void decode_setup_threads(VGMSTREAM* vgmstream, int threads_count) {
+    decode_threads_t* threads = vgmstream->decode_threads;
+
+    if (threads) {
+        if (threads_count > 1 && vgm_pool_get_threads(threads->pool) == threads_count)
+            return;
+        vgm_pool_free(threads->pool);
+        free(threads);
+        vgmstream->decode_threads = NULL;
+    }
+
+    if (threads_count <= 1 || vgmstream->channels <= 1)
+        return;
+    if (vgmstream->coding_type == coding_SILENCE || !decode_can_planar(vgmstream))
+        return;
+    if (threads_count > vgmstream->channels)
+        threads_count = vgmstream->channels;
+
+    threads = calloc(1, sizeof(decode_threads_t));
+    if (!threads) goto fail;
+
+    threads->group_channels = (vgmstream->channels + threads_count - 1) / threads_count;
+    threads->groups = (vgmstream->channels + threads->group_channels - 1) / threads->group_channels;
+
+    threads->pool = vgm_pool_init(threads->groups);
+    if (!threads->pool) goto fail;
+
+    if (!setup_threads_streamfiles(vgmstream, threads))
+        goto fail;
+
+    vgmstream->decode_threads = threads;
+    return;
+fail:
+    VGM_LOG("DECODE: can't setup decode threads\n");
+    if (threads) vgm_pool_free(threads->pool);
+    free(threads);
+}
+
+static void decode_threads_group(void* arg, int group) {
+    decode_threads_job_t* job = arg;
+    VGMSTREAM* vgmstream = job->vgmstream;
+    int first = group * job->threads->group_channels;
+    int last = first + job->threads->group_channels;
+    int32_t samples_into_block = vgmstream->samples_into_block;
+    int32_t samples_done = 0;
+    int ch;
+
+    if (last > vgmstream->channels)
+        last = vgmstream->channels;
+
+    /* decode up to block ends, then move offsets like the layout would (only for this group) */
+    while (samples_done < job->samples_to_do) {
+        int32_t samples_to_do = job->samples_to_do - samples_done;
+        if (job->samples_this_block && samples_to_do > job->samples_this_block - samples_into_block)
+            samples_to_do = job->samples_this_block - samples_into_block;
+
+        decode_channels(vgmstream, job->buffer + samples_done * job->channelspacing, job->channelspacing, job->ch_step,
+                first, last, samples_into_block, samples_to_do);
+
+        samples_done += samples_to_do;
+        samples_into_block += samples_to_do;
+
+        if (job->samples_this_block && samples_into_block == job->samples_this_block) {
+            for (ch = first; ch < last; ch++) {
+                vgmstream->ch[ch].offset += job->block_skip;
+            }
+            samples_into_block = 0;
+        }
+    }
+}
+
+static void decode_threads_run(VGMSTREAM* vgmstream, sample_t* buffer, int32_t samples_to_do, int32_t samples_this_block, off_t block_skip) {
+    decode_threads_job_t job = {0};
+
+    job.vgmstream = vgmstream;
+    job.threads = vgmstream->decode_threads;
+    job.buffer = buffer;
+    if (vgmstream->planar_size) {
+        job.channelspacing = 1;
+        job.ch_step = vgmstream->planar_size;
+    }
+    else {
+        job.channelspacing = vgmstream->channels;
+        job.ch_step = 1;
+    }
+    job.samples_to_do = samples_to_do;
+    job.samples_this_block = samples_this_block;
+    job.block_skip = block_skip;
+
+    vgm_pool_run(job.threads->pool, decode_threads_group, &job, job.threads->groups);
+}
+
+int32_t decode_vgmstream_blocks(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer, int32_t samples_this_block, off_t block_skip) {
+    if (!vgmstream->decode_threads || samples_to_do < DECODE_THREADS_MIN_SAMPLES || !buffer)
+        return 0;
+
+    buffer += samples_written * (vgmstream->planar_size ? 1 : vgmstream->channels);
+    decode_threads_run(vgmstream, buffer, samples_to_do, samples_this_block, block_skip);
+    return samples_to_do;
+}
+
+/* same as decode_vgmstream, but channel N goes to buffer + N * planar_size (see decode_can_planar) */
+static void decode_vgmstream_planar(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer) {
+    int32_t plane = vgmstream->planar_size;
+
+    buffer += samples_written;
+
+    if (decode_pcm_frames(vgmstream, buffer, plane, vgmstream->samples_into_block, samples_to_do))
+        return;
+
+    if (vgmstream->decode_threads && samples_to_do >= DECODE_THREADS_MIN_SAMPLES) {
+        decode_threads_run(vgmstream, buffer, samples_to_do, 0, 0);
+        return;
+    }
+
+    if (vgmstream->coding_type == coding_SILENCE) {
+        decode_silence(vgmstream, 0, samples_to_do, buffer);
+        return;
+    }
+
+    if (!decode_can_planar(vgmstream)) {
+        VGM_LOG_ONCE("DECODE: planar decode not supported\n");
+        decode_silence(vgmstream, 0, samples_to_do, buffer);
+        return;
+    }
+
+    decode_channels(vgmstream, buffer, 1, plane, 0, vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+}
+
+
+/* Float render: codecs that decode to float internally can skip the int16 conversion
+ * (others are decoded as int16 and converted by the caller). */
+int decode_can_f32(VGMSTREAM* vgmstream) {
+    switch (vgmstream->coding_type) {
+#ifdef VGM_USE_VORBIS
+        case coding_OGG_VORBIS:
+#endif
+#ifdef VGM_USE_FFMPEG
+        case coding_FFmpeg:
+#endif
+        case coding_CRI_HCA:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* same as decode_vgmstream, but into float samples (see decode_can_f32) */
+void decode_vgmstream_f32(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, float* buffer) {
+
+    buffer += samples_written * vgmstream->channels;
+
+    switch (vgmstream->coding_type) {
+#ifdef VGM_USE_VORBIS
+        case coding_OGG_VORBIS:
+            decode_ogg_vorbis_f32(vgmstream->codec_data, buffer, samples_to_do, vgmstream->channels);
+            break;
+#endif
+#ifdef VGM_USE_FFMPEG
+        case coding_FFmpeg:
+            decode_ffmpeg_f32(vgmstream, buffer, samples_to_do, vgmstream->channels);
+            break;
+#endif
+        case coding_CRI_HCA:
+            decode_hca_f32(vgmstream->codec_data, buffer, samples_to_do);
+            break;
+
+        default:
+            VGM_LOG_ONCE("DECODE: float decode not supported\n");
+            memset(buffer, 0, samples_to_do * vgmstream->channels * sizeof(float));
+            break;
+    }
+}
+
+int decode_can_skip(VGMSTREAM* vgmstream) {
+    if (vgmstream->codec_data)
+        return 0;
+
+    switch (vgmstream->coding_type) {
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+        case coding_PCM16_int:
+        case coding_PCM8:
+        case coding_PCM8_int:
+        case coding_PCM8_U:
+        case coding_PCM8_U_int:
+        case coding_PCM8_SB:
+        case coding_ULAW:
+        case coding_ULAW_int:
+        case coding_ALAW:
+        case coding_PCMFLOAT:
+        case coding_PCM24LE:
+        case coding_PCM24BE:
+        case coding_NGC_DSP:
+        case coding_PSX:
+        case coding_PSX_badflags:
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void decode_skip_samples(VGMSTREAM* vgmstream, int samples_to_do) {
+    int ch;
+
+    switch (vgmstream->coding_type) {
+        case coding_NGC_DSP:
+            for (ch = 0; ch < vgmstream->channels; ch++) {
+                skip_ngc_dsp(&vgmstream->ch[ch], vgmstream->samples_into_block, samples_to_do);
+            }
+            break;
+        case coding_PSX:
+        case coding_PSX_badflags:
+            for (ch = 0; ch < vgmstream->channels; ch++) {
+                skip_psx(&vgmstream->ch[ch], vgmstream->samples_into_block, samples_to_do,
+                        vgmstream->coding_type == coding_PSX_badflags, vgmstream->codec_config);
+            }
+            break;
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+            for (ch = 0; ch < vgmstream->channels; ch++) {
+                skip_adx(&vgmstream->ch[ch], vgmstream->samples_into_block, samples_to_do,
+                        vgmstream->interleave_block_size, vgmstream->coding_type);
+            }
+            break;
+        default:
+            /* PCM reads from offset + first sample, so there is no state other than the layout's position */
+            break;
+    }
+}
+
 /* Decode samples into the buffer. Assume that we have written samples_written into the
  * buffer already, and we have samples_to_do consecutive samples ahead of us (won't call
  * more than one frame if configured above to do so).
@@ -772,8 +1261,28 @@ int decode_get_shortframe_size(VGMSTREAM* vgmstream) {
 void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer) {
     int ch;
 
+    if (!buffer) {
+        decode_skip_samples(vgmstream, samples_to_do);
+        return;
+    }
+
+    if (vgmstream->planar_size) {
+        decode_vgmstream_planar(vgmstream, samples_written, samples_to_do, buffer);
+        return;
+    }
+
     buffer += samples_written * vgmstream->channels; /* passed externally to simplify I guess */
 
+    /* interleaved PCM may be converted for all channels at once */
+    if (decode_pcm_frames(vgmstream, buffer, 1, vgmstream->samples_into_block, samples_to_do))
+        return;
+
+    /* big calls may be split into channel groups */
+    if (vgmstream->decode_threads && samples_to_do >= DECODE_THREADS_MIN_SAMPLES) {
+        decode_threads_run(vgmstream, buffer, samples_to_do, 0, 0);
+        return;
+    }
+
     switch (vgmstream->coding_type) {
         case coding_SILENCE:
             memset(buffer, 0, samples_to_do * vgmstream->channels * sizeof(sample_t));
@@ -791,7 +1300,9 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             }
             break;
         case coding_NGC_DSP:
-            for (ch = 0; ch < vgmstream->channels; ch++) {
+            ch = decode_ngc_dsp_multi(vgmstream->ch, buffer,
+                    vgmstream->channels, 1, vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+            for (; ch < vgmstream->channels; ch++) {
                 decode_ngc_dsp(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
@@ -981,14 +1492,20 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             break;
         }
         case coding_PSX:
-            for (ch = 0; ch < vgmstream->channels; ch++) {
+            ch = decode_psx_multi(vgmstream->ch, buffer,
+                    vgmstream->channels, 1, vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                    0, vgmstream->codec_config);
+            for (; ch < vgmstream->channels; ch++) {
                 decode_psx(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
                         0, vgmstream->codec_config);
             }
             break;
         case coding_PSX_badflags:
-            for (ch = 0; ch < vgmstream->channels; ch++) {
+            ch = decode_psx_multi(vgmstream->ch, buffer,
+                    vgmstream->channels, 1, vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                    1, vgmstream->codec_config);
+            for (; ch < vgmstream->channels; ch++) {
                 decode_psx(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
                         1, vgmstream->codec_config);
@@ -1488,6 +2005,28 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
 
 /* Calculate number of consecutive samples we can decode. Takes into account hitting
  * a loop start or end, or going past a single frame. */
+int decode_get_frames_per_call(VGMSTREAM* vgmstream) {
+    int frame_size;
+
+    switch (vgmstream->coding_type) {
+        case coding_NGC_DSP:
+        case coding_PSX:
+        case coding_PSX_badflags:
+        case coding_XA:
+        case coding_XA_EA:
+        case coding_XA8:
+        case coding_MSADPCM:
+        case coding_MSADPCM_int:
+        case coding_MSADPCM_ck:
+            frame_size = decode_get_frame_size(vgmstream);
+            if (frame_size <= 0 || frame_size > DECODE_BLOCK_BUFFER_SIZE)
+                return 1;
+            return DECODE_BLOCK_BUFFER_SIZE / frame_size;
+        default:
+            return 1;
+    }
+}
+
 int decode_get_samples_to_do(int samples_this_block, int samples_per_frame, VGMSTREAM* vgmstream) {
     int samples_to_do;
     int samples_left_this_block;
@@ -1519,8 +2058,72 @@ int decode_get_samples_to_do(int samples_this_block, int samples_per_frame, VGMS
     return samples_to_do;
 }
 
+int decode_get_seek_frame(VGMSTREAM* vgmstream, int* p_samples_per_frame, int* p_frame_size, int* p_moves_offset) {
+    int samples_per_frame, frame_size, moves_offset = 0;
+
+    if (vgmstream->codec_data)
+        return 0;
+
+    switch (vgmstream->coding_type) {
+        /* any sample */
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+        case coding_PCM16_int:
+        case coding_PCM8:
+        case coding_PCM8_int:
+        case coding_PCM8_U:
+        case coding_PCM8_U_int:
+        case coding_PCM8_SB:
+        case coding_ULAW:
+        case coding_ULAW_int:
+        case coding_ALAW:
+        case coding_PCMFLOAT:
+        case coding_PCM24LE:
+        case coding_PCM24BE:
+        /* frame header has all state (mid-frame calls use state from previous calls) */
+        case coding_XBOX_IMA:
+        case coding_XBOX_IMA_int:
+        case coding_MSADPCM:
+        case coding_MSADPCM_int:
+        case coding_MSADPCM_ck:
+            samples_per_frame = decode_get_samples_per_frame(vgmstream);
+            frame_size = decode_get_frame_size(vgmstream);
+            break;
+
+        /* decodes full frames every call, and moves offset after the last sample */
+        case coding_MS_IMA:
+        case coding_MS_IMA_mono: {
+            int frame_channels = (vgmstream->coding_type == coding_MS_IMA_mono || vgmstream->channels == 1) ? 1 : vgmstream->channels;
+            frame_size = vgmstream->frame_size;
+            samples_per_frame = ((frame_size - 0x04*frame_channels) * 2 / frame_channels) + 1; /* same as decoder */
+            moves_offset = 1;
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+    if (samples_per_frame <= 0 || frame_size <= 0)
+        return 0;
+
+    *p_samples_per_frame = samples_per_frame;
+    *p_frame_size = frame_size;
+    *p_moves_offset = moves_offset;
+    return 1;
+}
+
 /* Detect loop start and save values, or detect loop end and restore (loop back).
  * Returns 1 if loop was done. */
+int decode_keeps_loop_history(VGMSTREAM* vgmstream) {
+    /* against everything I hold sacred, preserve adpcm history before looping for certain types */
+    return vgmstream->meta_type == meta_DSP_STD ||
+           vgmstream->meta_type == meta_DSP_RS03 ||
+           vgmstream->meta_type == meta_DSP_CSTR ||
+           vgmstream->coding_type == coding_PSX ||
+           vgmstream->coding_type == coding_PSX_badflags;
+}
+
 int decode_do_loop(VGMSTREAM* vgmstream) {
     /*if (!vgmstream->loop_flag) return 0;*/
 
@@ -1535,12 +2138,7 @@ int decode_do_loop(VGMSTREAM* vgmstream) {
             return 0;
         }
 
-        /* against everything I hold sacred, preserve adpcm history before looping for certain types */
-        if (vgmstream->meta_type == meta_DSP_STD ||
-            vgmstream->meta_type == meta_DSP_RS03 ||
-            vgmstream->meta_type == meta_DSP_CSTR ||
-            vgmstream->coding_type == coding_PSX ||
-            vgmstream->coding_type == coding_PSX_badflags) {
+        if (decode_keeps_loop_history(vgmstream)) {
             int ch;
             for (ch = 0; ch < vgmstream->channels; ch++) {
                 vgmstream->loop_ch[ch].adpcm_history1_16 = vgmstream->ch[ch].adpcm_history1_16;
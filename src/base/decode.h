@@ -11,9 +11,45 @@ void decode_reset(VGMSTREAM* vgmstream);
  * buffer already, and we have samples_to_do consecutive samples ahead of us. */
 void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer);
 
+/* Returns 1 if current codec can update its state without decoding output (see decode_skip_samples) */
+int decode_can_skip(VGMSTREAM* vgmstream);
+
+/* Advances decoder state over samples_to_do samples as if decoded, but without output (for codecs in
+ * decode_can_skip). Layouts do this when decode_vgmstream is called with a NULL buffer. */
+void decode_skip_samples(VGMSTREAM* vgmstream, int samples_to_do);
+
+/* Silences samples_to_do samples (all channels) after samples_written, with the same buffer rules as decode_vgmstream */
+void decode_silence(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer);
+
+/* Returns 1 if current codec can decode into planes (set with vgmstream->planar_size) */
+int decode_can_planar(VGMSTREAM* vgmstream);
+
+/* Sets a pool of N threads to decode groups of channels in parallel on big calls (<= 1 removes it).
+ * Only for codecs in decode_can_planar, otherwise does nothing. */
+void decode_setup_threads(VGMSTREAM* vgmstream, int threads);
+
+/* With decode threads, decodes samples_to_do over consecutive blocks of samples_this_block samples, moving
+ * channel offsets by block_skip after each block (like the interleave layout). Returns 0 if not possible
+ * (no threads or too few samples), so caller must decode normally. */
+int32_t decode_vgmstream_blocks(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer, int32_t samples_this_block, off_t block_skip);
+
+/* Returns 1 if current codec can decode float samples directly with decode_vgmstream_f32 */
+int decode_can_f32(VGMSTREAM* vgmstream);
+
+/* Same as decode_vgmstream, but into float samples (-1.0..1.0) */
+void decode_vgmstream_f32(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, float* buffer);
+
 /* Detect loop start and save values, or detect loop end and restore (loop back). Returns 1 if loop was done. */
 int decode_do_loop(VGMSTREAM* vgmstream);
 
+/* Returns 1 if ADPCM history is kept when looping (so state after looping isn't the same as the first time) */
+int decode_keeps_loop_history(VGMSTREAM* vgmstream);
+
+/* Returns 1 if frames of current codec decode without any previous state (PCM, or ADPCM with full state in frame
+ * headers), so decoding may start from any frame. Sets samples and bytes per frame, and if decoder moves offsets
+ * after each frame (otherwise frames are read from offset + first sample). */
+int decode_get_seek_frame(VGMSTREAM* vgmstream, int* p_samples_per_frame, int* p_frame_size, int* p_moves_offset);
+
 /* Calculate number of consecutive samples to do (taking into account stopping for loop start and end) */
 int decode_get_samples_to_do(int samples_this_block, int samples_per_frame, VGMSTREAM* vgmstream);
 
@@ -21,6 +57,11 @@ int decode_get_samples_to_do(int samples_this_block, int samples_per_frame, VGMS
 /* Get the number of samples of a single frame (smallest self-contained sample group, 1/N channels) */
 int decode_get_samples_per_frame(VGMSTREAM* vgmstream);
 
+/* Get the max number of frames decoders can handle per call (most do 1, but some read and decode
+ * multiple frames at once from memory, much faster than frame by frame). Layouts that call decode_vgmstream
+ * may pass N frames as samples_per_frame to decode_get_samples_to_do. */
+int decode_get_frames_per_call(VGMSTREAM* vgmstream);
+
 /* Get the number of bytes of a single frame (smallest self-contained byte group, 1/N channels) */
 int decode_get_frame_size(VGMSTREAM* vgmstream);
 
@@ -369,6 +369,8 @@ static int get_vgmstream_file_bitrate_main(VGMSTREAM* vgmstream, bitrate_info_t*
         int uniques = 0;
         segmented_layout_data *data = (segmented_layout_data *) vgmstream->layout_data;
         for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i]) /* closed deferred segment */
+                continue;
             bitrate += get_vgmstream_file_bitrate_main(data->segments[i], br, &uniques);
         }
         if (uniques)
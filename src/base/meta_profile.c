@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include "meta_profile.h"
+
+#if defined(_WIN32) || defined(WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/* Global (like log config), since probing happens deep inside init without any context to pass.
+ * Not thread-safe: meant for tools that open files one by one. */
+static int profile_enabled = 0;
+static vgmstream_probe_stats_t* profile_stats = NULL;
+static int profile_count = 0;
+
+
+void meta_profile_set_enabled(int enabled) {
+    free(profile_stats);
+    profile_stats = NULL;
+    profile_count = 0;
+    profile_enabled = enabled;
+}
+
+int meta_profile_is_enabled(void) {
+    return profile_enabled;
+}
+
+double meta_profile_get_time(void) {
+#if defined(_WIN32) || defined(WIN32)
+    LARGE_INTEGER freq, counter;
+    if (!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&counter))
+        return 0.0;
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#else
+    return (double)clock() / CLOCKS_PER_SEC; /* CPU time, close enough */
+#endif
+}
+
+static vgmstream_probe_stats_t* get_stats(int index, const char* name, const char* exts) {
+    vgmstream_probe_stats_t* stats;
+
+    if (!profile_enabled || index < 0)
+        return NULL;
+
+    /* grow as needed (index is the meta's position, so it's also the final order) */
+    if (index >= profile_count) {
+        int new_count = index + 1;
+        vgmstream_probe_stats_t* new_stats = realloc(profile_stats, new_count * sizeof(vgmstream_probe_stats_t));
+        if (!new_stats) return NULL;
+        memset(new_stats + profile_count, 0, (new_count - profile_count) * sizeof(vgmstream_probe_stats_t));
+        profile_stats = new_stats;
+        profile_count = new_count;
+    }
+
+    stats = &profile_stats[index];
+    stats->name = name;
+    stats->exts = exts;
+    return stats;
+}
+
+void meta_profile_skip(int index, const char* name, const char* exts) {
+    vgmstream_probe_stats_t* stats = get_stats(index, name, exts);
+    if (!stats) return;
+
+    stats->skips++;
+}
+
+void meta_profile_add(int index, const char* name, const char* exts, VGMSTREAM* vgmstream, double time, STREAMFILE* sf_stats) {
+    vgmstream_probe_stats_t* stats = get_stats(index, name, exts);
+    streamfile_stats_t io = {0};
+
+    if (!stats) return;
+
+    get_streamfile_stats(sf_stats, &io);
+
+    if (vgmstream) {
+        stats->accepts++;
+        stats->accept_time += time;
+        stats->accept_reads += io.read_calls;
+        stats->accept_bytes += io.bytes_requested;
+        get_vgmstream_meta_description(vgmstream, stats->format, sizeof(stats->format));
+        stats->format[sizeof(stats->format) - 1] = '\0';
+    }
+    else {
+        stats->rejects++;
+        stats->reject_time += time;
+        stats->reject_reads += io.read_calls;
+        stats->reject_bytes += io.bytes_requested;
+    }
+    stats->opens += io.open_calls;
+}
+
+const vgmstream_probe_stats_t* meta_profile_get(int* p_count) {
+    *p_count = profile_count;
+    return profile_stats;
+}
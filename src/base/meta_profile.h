@@ -0,0 +1,24 @@
+#ifndef _META_PROFILE_H_
+#define _META_PROFILE_H_
+
+#include "../streamfile.h"
+#include "../vgmstream.h"
+#include "plugins.h"
+
+/* Per-meta detection profiling (see vgmstream_set_probe_profile). */
+
+void meta_profile_set_enabled(int enabled);
+int meta_profile_is_enabled(void);
+
+/* monotonic time in seconds */
+double meta_profile_get_time(void);
+
+/* registers a meta that wasn't called (ext/magic didn't match) */
+void meta_profile_skip(int index, const char* name, const char* exts);
+
+/* registers a meta call and its result (stats SF is optional, should wrap the SF passed to the meta) */
+void meta_profile_add(int index, const char* name, const char* exts, VGMSTREAM* vgmstream, double time, STREAMFILE* sf_stats);
+
+const vgmstream_probe_stats_t* meta_profile_get(int* p_count);
+
+#endif
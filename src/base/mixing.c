@@ -260,7 +260,8 @@ fail:
     return 0;
 }
 
-void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+/* mixes int16 outbuf or float outbuf_f32 (only one is set) */
+static void mix_process(VGMSTREAM* vgmstream, sample_t *outbuf, float* outbuf_f32, int32_t sample_count) {
     mixing_data *data = vgmstream->mixing_data;
     int ch, s, m, ok;
 
@@ -268,9 +269,12 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
     float temp_f, temp_min, temp_max, cur_vol = 0.0f;
     float *temp_mixbuf;
     sample_t *temp_outbuf;
+    float *temp_outbuf_f32;
+    int ch_step, s_step;
 
-    const float limiter_max = 32767.0f;
-    const float limiter_min = -32768.0f;
+    /* floats are in the -1.0..1.0 range rather than int16's */
+    const float limiter_max = outbuf_f32 ? 32767.0f / 32768.0f : 32767.0f;
+    const float limiter_min = outbuf_f32 ? -1.0f : -32768.0f;
 
     /* no support or not need to apply */
     if (!data || !data->mixing_on || data->mixing_count == 0)
@@ -287,9 +291,20 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
     }
 
 
+    /* planar: channel N at outbuf[N*plane + s], interleaved: at outbuf[s*channels + N] (floats are always interleaved) */
+    if (vgmstream->planar_size && !outbuf_f32) {
+        ch_step = vgmstream->planar_size;
+        s_step = 1;
+    }
+    else {
+        ch_step = 1;
+        s_step = vgmstream->channels;
+    }
+
     /* use advancing buffer pointers to simplify logic */
     temp_mixbuf = data->mixbuf;
     temp_outbuf = outbuf;
+    temp_outbuf_f32 = outbuf_f32;
 
     /* apply mixes in order per channel */
     for (s = 0; s < sample_count; s++) {
@@ -297,8 +312,15 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
         float *stpbuf = temp_mixbuf;
         int step_channels = vgmstream->channels;
 
-        for (ch = 0; ch < step_channels; ch++) {
-            stpbuf[ch] = temp_outbuf[ch]; /* copy current 'lane' */
+        if (outbuf_f32) {
+            for (ch = 0; ch < step_channels; ch++) {
+                stpbuf[ch] = temp_outbuf_f32[ch]; /* copy current 'lane' */
+            }
+        }
+        else {
+            for (ch = 0; ch < step_channels; ch++) {
+                stpbuf[ch] = temp_outbuf[ch * ch_step]; /* copy current 'lane' */
+            }
         }
 
         for (m = 0; m < data->mixing_count; m++) {
@@ -403,7 +425,28 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
         current_subpos++;
 
         temp_mixbuf += step_channels;
-        temp_outbuf += vgmstream->channels;
+        if (outbuf_f32)
+            temp_outbuf_f32 += vgmstream->channels;
+        else
+            temp_outbuf += s_step;
+    }
+
+    if (outbuf_f32) {
+        /* no clamping, caller gets the full mix */
+        memcpy(outbuf_f32, data->mixbuf, sample_count * data->output_channels * sizeof(float));
+        return;
+    }
+
+    if (vgmstream->planar_size) {
+        /* same as below, but into planes */
+        for (ch = 0; ch < data->output_channels; ch++) {
+            sample_t* plane = outbuf + ch * vgmstream->planar_size;
+            float* mixbuf = data->mixbuf + ch;
+            for (s = 0; s < sample_count; s++) {
+                plane[s] = clamp16( (int32_t)mixbuf[s * data->output_channels] );
+            }
+        }
+        return;
     }
 
     /* copy resulting mix to output
@@ -422,6 +465,14 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
     }
 }
 
+void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    mix_process(vgmstream, outbuf, NULL, sample_count);
+}
+
+void mix_vgmstream_f32(float* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    mix_process(vgmstream, NULL, outbuf, sample_count);
+}
+
 /* ******************************************************************* */
 
 void mixing_init(VGMSTREAM* vgmstream) {
@@ -6,6 +6,8 @@
 /* Applies mixing commands to the sample buffer. Mixing must be externally enabled and
  * outbuf must big enough to hold output_channels*samples_to_do */
 void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream);
+/* Same for float samples (-1.0..1.0, interleaved), without clamping the result */
+void mix_vgmstream_f32(float* outbuf, int32_t sample_count, VGMSTREAM* vgmstream);
 
 /* internal mixing pre-setup for vgmstream (doesn't imply usage).
  * If init somehow fails next calls are ignored. */
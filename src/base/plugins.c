@@ -4,6 +4,7 @@
 #include "../util/reader_text.h"
 #include "plugins.h"
 #include "mixing.h"
+#include "meta_profile.h"
 
 
 /* ****************************************** */
@@ -573,3 +574,15 @@ void vgmstream_set_log_callback(int level, void* callback) {
 void vgmstream_set_log_stdout(int level) {
     vgm_log_set_callback(NULL, level, 1, NULL);
 }
+
+/* ****************************************** */
+/* PROFILE: per-meta detection stats          */
+/* ****************************************** */
+
+void vgmstream_set_probe_profile(int enabled) {
+    meta_profile_set_enabled(enabled);
+}
+
+const vgmstream_probe_stats_t* vgmstream_get_probe_profile(int* p_count) {
+    return meta_profile_get(p_count);
+}
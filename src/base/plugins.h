@@ -49,6 +49,23 @@ void vgmstream_apply_config(VGMSTREAM* vgmstream, vgmstream_cfg_t* pcfg);
 int32_t vgmstream_get_samples(VGMSTREAM* vgmstream);
 int vgmstream_get_play_forever(VGMSTREAM* vgmstream);
 void vgmstream_set_play_forever(VGMSTREAM* vgmstream, int enabled);
+/* Decodes groups of channels in parallel with N threads (<= 1 disables, -1 uses all CPUs) for codecs
+ * with independent channels (DSP, PSX, ADX, PCM, etc), in big enough renders. Call before rendering.
+ * Groups read from reopened SFs at the same time, so threads are only used when the base SF allows that
+ * (pread/mmap/memory SFs, while stdio SFs share file positions between reopens). */
+void vgmstream_set_decode_threads(VGMSTREAM* vgmstream, int threads);
+/* Saves decoder state every N samples while decoding (<= 0 disables), so seeks can restore the closest saved
+ * point and decode less. Only for codecs whose state can be copied (PCM, most ADPCM), others seek as usual.
+ * Points are kept over resets and saved only once, so table grows up to the furthest decoded sample. Call before rendering. */
+void vgmstream_set_seek_table(VGMSTREAM* vgmstream, int32_t interval);
+/* Decodes the whole stream once to fill the seek table, then resets. */
+void vgmstream_scan_seek_table(VGMSTREAM* vgmstream);
+/* Saves seek tables to (or loads from) files in an existing cache dir, keyed by file, subsong, etc. Loading
+ * replaces the current table (and enables it), so call before rendering too. Same codecs as above: those with
+ * their own decoder state (Vorbis, MPEG, EA MicroTalk, etc) aren't cached and still decode up to the seek point.
+ * Return 1 if all tables were saved/loaded (streams that can't use seek tables count as done). */
+int vgmstream_save_seek_table(VGMSTREAM* vgmstream, const char* cache_dir);
+int vgmstream_load_seek_table(VGMSTREAM* vgmstream, const char* cache_dir);
 
 
 typedef struct {
@@ -71,6 +88,37 @@ void vgmstream_set_log_callback(int level, void* callback);
 void vgmstream_set_log_stdout(int level);
 
 
+/* ****************************************** */
+/* PROFILE: per-meta detection stats          */
+/* ****************************************** */
+
+typedef struct {
+    const char* name;           /* meta's init function (NULL if never tried or skipped) */
+    const char* exts;           /* extensions the meta is tried with (NULL: any) */
+    char format[128];           /* description of the last file the meta accepted (empty if none) */
+    int accepts;                /* calls that returned a VGMSTREAM */
+    int rejects;                /* calls that failed */
+    int skips;                  /* times not called (file's extension or header id didn't match) */
+    double accept_time;         /* seconds spent in accepts */
+    double reject_time;         /* seconds spent in rejects */
+    uint64_t accept_reads;      /* STREAMFILE reads done in accepts (including companion files) */
+    uint64_t accept_bytes;      /* bytes requested in those reads */
+    uint64_t reject_reads;
+    uint64_t reject_bytes;
+    uint64_t opens;             /* files opened (reopens and companion files) */
+} vgmstream_probe_stats_t;
+
+/* Enables or disables profiling metas during detection (off by default), and resets stats.
+ * Stats are global and aggregated over all inits. Not thread-safe (meant for tools that open files
+ * one by one), and while enabled metas read through a counting wrapper (slower, IO may be different, and accepted
+ * metas keep the wrapper for playback, though it stops counting and buffering). */
+void vgmstream_set_probe_profile(int enabled);
+
+/* Returns stats of each meta, in detection order (may be NULL), valid until next inits or reset.
+ * Metas are in the same order as in vgmstream.c (positions may change between versions), unused ones are zeroed. */
+const vgmstream_probe_stats_t* vgmstream_get_probe_profile(int* p_count);
+
+
 /* ****************************************** */
 /* TAGS: loads key=val tags from a file       */
 /* ****************************************** */
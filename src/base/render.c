@@ -4,6 +4,9 @@
 #include "decode.h"
 #include "mixing.h"
 #include "plugins.h"
+#include "seek_table.h"
+#include "../util/samples_ops.h"
+#include "../util/thread.h"
 
 
 /* VGMSTREAM RENDERING
@@ -60,6 +63,39 @@ void vgmstream_set_play_forever(VGMSTREAM* vgmstream, int enabled) {
     setup_vgmstream(vgmstream); /* update config */
 }
 
+void vgmstream_set_decode_threads(VGMSTREAM* vgmstream, int threads) {
+    int i;
+
+    if (threads < 0)
+        threads = vgm_thread_get_cpus();
+
+    /* sub-VGMSTREAMs decode on their own */
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        data->decode_threads = threads; /* for deferred segments */
+        for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i])
+                continue;
+            vgmstream_set_decode_threads(data->segments[i], threads);
+        }
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        /* layers render in parallel, so each gets a share of threads for its channels */
+        setup_layout_layered_threads(data, threads);
+        for (i = 0; i < data->layer_count; i++) {
+            vgmstream_set_decode_threads(data->layers[i], threads / data->layer_count);
+        }
+    }
+    else {
+        decode_setup_threads(vgmstream, threads);
+    }
+
+    setup_vgmstream(vgmstream); /* save for reset */
+}
+
 int32_t vgmstream_get_samples(VGMSTREAM* vgmstream) {
     if (!vgmstream->config_enabled || !vgmstream->config.config_set)
         return vgmstream->num_samples;
@@ -224,6 +260,8 @@ void setup_state_vgmstream(VGMSTREAM* vgmstream) {
 
 void render_free(VGMSTREAM* vgmstream) {
 
+    seek_table_free(vgmstream->seek_table);
+
     if (vgmstream->layout_type == layout_segmented) {
         free_layout_segmented(vgmstream->layout_data);
     }
@@ -244,16 +282,14 @@ void render_reset(VGMSTREAM* vgmstream) {
     }
 }
 
-int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+static int render_layout_part(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
 
     /* current_sample goes between loop points (if looped) or up to max samples,
      * must detect beyond that decoders would encounter garbage data */
 
     /* not ">=" to allow layouts to loop in some cases when == happens */
     if (vgmstream->current_sample > vgmstream->num_samples) {
-        int channels = vgmstream->channels;
-
-        memset(buf, 0, sample_count * sizeof(sample_t) * channels);
+        decode_silence(vgmstream, 0, sample_count, buf);
         return sample_count;
     }
 
@@ -315,8 +351,10 @@ int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
             break;
     }
 
+    if (vgmstream->seek_table)
+        seek_table_save(vgmstream);
+
     if (vgmstream->current_sample > vgmstream->num_samples) {
-        int channels = vgmstream->channels;
         int32_t excess, decoded;
 
         excess = (vgmstream->current_sample - vgmstream->num_samples);
@@ -324,43 +362,158 @@ int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
             excess = sample_count;
         decoded = sample_count - excess;
 
-        memset(buf + decoded * channels, 0, excess * sizeof(sample_t) * channels);
+        decode_silence(vgmstream, decoded, excess, buf);
         return sample_count;
     }
 
     return sample_count;
 }
 
+int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    /* buf has input channels here, in planes or interleaved (NULL when skipping) */
+    int sample_step = vgmstream->planar_size ? 1 : vgmstream->channels;
+    int32_t samples_done = 0;
+
+    if (!vgmstream->seek_table)
+        return render_layout_part(buf, sample_count, vgmstream);
+
+    /* stop on each checkpoint, as state is only saved between renders */
+    while (samples_done < sample_count) {
+        int32_t to_do = sample_count - samples_done;
+        int32_t samples_to_next = seek_table_get_samples_to_next(vgmstream);
+        if (samples_to_next > 0 && to_do > samples_to_next)
+            to_do = samples_to_next;
+
+        render_layout_part(buf ? buf + samples_done * sample_step : NULL, to_do, vgmstream);
+        samples_done += to_do;
+    }
 
-static void render_trim(VGMSTREAM* vgmstream) {
-    sample_t* tmpbuf = vgmstream->tmpbuf;
-    size_t tmpbuf_size = vgmstream->tmpbuf_size;
-    int32_t buf_samples = tmpbuf_size / vgmstream->channels; /* base channels, no need to apply mixing */
+    return sample_count;
+}
+
+/* float version of render_layout, where float decoders and layouts output directly while others
+ * render int16 in tmpbuf chunks that are converted once */
+static int render_layout_f32(float* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    int channels = vgmstream->channels;
+
+    if (vgmstream->current_sample > vgmstream->num_samples) {
+        memset(buf, 0, sample_count * channels * sizeof(float));
+        return sample_count;
+    }
+
+    if (vgmstream->layout_type == layout_none && decode_can_f32(vgmstream)) {
+        int32_t samples_done = 0;
+
+        /* stop on each checkpoint, like render_layout */
+        while (samples_done < sample_count) {
+            int32_t to_do = sample_count - samples_done;
+            int32_t samples_to_next = seek_table_get_samples_to_next(vgmstream);
+            if (samples_to_next > 0 && to_do > samples_to_next)
+                to_do = samples_to_next;
+
+            render_vgmstream_flat_f32(buf + samples_done * channels, to_do, vgmstream);
+            if (vgmstream->seek_table)
+                seek_table_save(vgmstream);
+            samples_done += to_do;
+        }
+    }
+    else if (vgmstream->layout_type == layout_segmented) {
+        render_vgmstream_segmented_f32(buf, sample_count, vgmstream);
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        render_vgmstream_layered_f32(buf, sample_count, vgmstream);
+    }
+    else {
+        int32_t buf_samples = vgmstream->tmpbuf_size / channels;
+        int32_t samples_done = 0;
+
+        while (samples_done < sample_count) {
+            int32_t to_do = sample_count - samples_done;
+            if (to_do > buf_samples)
+                to_do = buf_samples;
+
+            render_layout(vgmstream->tmpbuf, to_do, vgmstream);
+            samples_s16_to_f32(buf + samples_done * channels, vgmstream->tmpbuf, to_do * channels);
+            samples_done += to_do;
+        }
+        return sample_count; /* excess is already silenced */
+    }
+
+    if (vgmstream->current_sample > vgmstream->num_samples) {
+        int32_t excess, decoded;
+
+        excess = (vgmstream->current_sample - vgmstream->num_samples);
+        if (excess > sample_count)
+            excess = sample_count;
+        decoded = sample_count - excess;
+
+        memset(buf + decoded * channels, 0, excess * channels * sizeof(float));
+        return sample_count;
+    }
+
+    return sample_count;
+}
+
+
+/* silences samples in buf after mixing (output channels), interleaved or planar (or float, always interleaved) */
+static void render_silence(VGMSTREAM* vgmstream, sample_t* buf, float* buf_f32, int32_t start, int32_t count) {
+    int channels = vgmstream->pstate.output_channels;
+    int ch;
 
-    while (vgmstream->pstate.trim_begin_left) {
-        int to_do = vgmstream->pstate.trim_begin_left;
+    if (buf_f32) {
+        memset(buf_f32 + start * channels, 0, count * sizeof(float) * channels);
+    }
+    else if (vgmstream->planar_size) {
+        for (ch = 0; ch < channels; ch++) {
+            memset(buf + ch * vgmstream->planar_size + start, 0, count * sizeof(sample_t));
+        }
+    }
+    else {
+        memset(buf + start * channels, 0, count * sizeof(sample_t) * channels);
+    }
+}
+
+void render_skip(VGMSTREAM* vgmstream, int32_t sample_count) {
+    sample_t* buf = vgmstream->tmpbuf;
+    int32_t buf_samples = vgmstream->tmpbuf_size / vgmstream->channels; /* base channels, no need to apply mixing */
+    int32_t planar_size = vgmstream->planar_size;
+
+    /* NULL buffer makes layouts update decoder state only (see decode_skip_samples) */
+    if ((vgmstream->layout_type == layout_none || vgmstream->layout_type == layout_interleave) && decode_can_skip(vgmstream))
+        buf = NULL;
+
+    /* still in chunks, as some state is saved between calls (see seek_table_save) */
+    vgmstream->planar_size = 0; /* tmpbuf is interleaved */
+    while (sample_count > 0) {
+        int to_do = sample_count;
         if (to_do > buf_samples)
             to_do = buf_samples;
 
-        render_layout(tmpbuf, to_do, vgmstream);
+        render_layout(buf, to_do, vgmstream);
         /* no mixing */
-        vgmstream->pstate.trim_begin_left -= to_do;
+        sample_count -= to_do;
     }
+    vgmstream->planar_size = planar_size;
 }
 
-static int render_pad_begin(VGMSTREAM* vgmstream, sample_t* buf, int samples_to_do) {
-    int channels = vgmstream->pstate.output_channels;
+static void render_trim(VGMSTREAM* vgmstream) {
+    /* same as seeking forward, so it may jump or skip decoding */
+    seek_force_decode(vgmstream, vgmstream->pstate.trim_begin_left);
+    vgmstream->pstate.trim_begin_left = 0;
+}
+
+static int render_pad_begin(VGMSTREAM* vgmstream, sample_t* buf, float* buf_f32, int samples_to_do) {
     int to_do = vgmstream->pstate.pad_begin_left;
     if (to_do > samples_to_do)
         to_do = samples_to_do;
 
-    memset(buf, 0, to_do * sizeof(sample_t) * channels);
+    render_silence(vgmstream, buf, buf_f32, 0, to_do);
     vgmstream->pstate.pad_begin_left -= to_do;
 
     return to_do;
 }
 
-static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
+static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, float* buf_f32, int samples_left) {
     play_state_t* ps = &vgmstream->pstate;
     //play_config_t* pc = &vgmstream->config;
 
@@ -370,7 +523,7 @@ static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
     //    return;
 
     {
-        int s, ch,  start, fade_pos;
+        int s, ch,  start, fade_pos, ch_step, s_step;
         int channels = ps->output_channels;
         int32_t to_do = ps->fade_left;
 
@@ -386,25 +539,44 @@ static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
         if (to_do > samples_left - start)
             to_do = samples_left - start;
 
+        /* planar: channel N at buf[N*plane + s], interleaved: at buf[s*channels + N] */
+        if (vgmstream->planar_size) {
+            ch_step = vgmstream->planar_size;
+            s_step = 1;
+        }
+        else {
+            ch_step = 1;
+            s_step = channels;
+        }
+
         //TODO: use delta fadedness to improve performance?
-        for (s = start; s < start + to_do; s++, fade_pos++) {
-            double fadedness = (double)(ps->fade_duration - fade_pos) / ps->fade_duration;
-            for (ch = 0; ch < channels; ch++) {
-                buf[s*channels + ch] = (sample_t)buf[s*channels + ch] * fadedness;
+        if (buf_f32) {
+            for (s = start; s < start + to_do; s++, fade_pos++) {
+                double fadedness = (double)(ps->fade_duration - fade_pos) / ps->fade_duration;
+                for (ch = 0; ch < channels; ch++) {
+                    buf_f32[s*channels + ch] = buf_f32[s*channels + ch] * fadedness;
+                }
+            }
+        }
+        else {
+            for (s = start; s < start + to_do; s++, fade_pos++) {
+                double fadedness = (double)(ps->fade_duration - fade_pos) / ps->fade_duration;
+                for (ch = 0; ch < channels; ch++) {
+                    buf[s*s_step + ch*ch_step] = (sample_t)buf[s*s_step + ch*ch_step] * fadedness;
+                }
             }
         }
 
         ps->fade_left -= to_do;
 
         /* next samples after fade end would be pad end/silence, so we can just memset */
-        memset(buf + (start + to_do) * channels, 0, (samples_left - to_do - start) * sizeof(sample_t) * channels);
+        render_silence(vgmstream, buf, buf_f32, start + to_do, samples_left - to_do - start);
         return start + to_do;
     }
 }
 
-static int render_pad_end(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
+static int render_pad_end(VGMSTREAM* vgmstream, sample_t* buf, float* buf_f32, int samples_left) {
     play_state_t* ps = &vgmstream->pstate;
-    int channels = vgmstream->pstate.output_channels;
     int skip = 0;
     int32_t to_do;
 
@@ -422,25 +594,34 @@ static int render_pad_end(VGMSTREAM* vgmstream, sample_t* buf, int samples_left)
     if (to_do > samples_left - skip)
         to_do = samples_left - skip;
 
-    memset(buf + (skip * channels), 0, to_do * sizeof(sample_t) * channels);
+    render_silence(vgmstream, buf, buf_f32, skip, to_do);
     return skip + to_do;
 }
 
 
 /* Decode data into sample buffer. Controls the "external" part of the decoding,
- * while layout/decode control the "internal" part. */
-int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+ * while layout/decode control the "internal" part. Renders to buf, or to buf_f32 if set. */
+static int render_main(sample_t* buf, float* buf_f32, int32_t sample_count, VGMSTREAM* vgmstream) {
     play_state_t* ps = &vgmstream->pstate;
     int samples_to_do = sample_count;
     int samples_done = 0;
     int done;
     sample_t* tmpbuf = buf;
+    float* tmpbuf_f32 = buf_f32;
+    /* buf position moves 1 per sample in planes, or all channels when interleaved (as if mixed) */
+    int sample_step = vgmstream->planar_size ? 1 : vgmstream->pstate.output_channels;
 
 
     /* simple mode with no settings (just skip everything below) */
     if (!vgmstream->config_enabled) {
-        render_layout(buf, samples_to_do, vgmstream);
-        mix_vgmstream(buf, samples_to_do, vgmstream);
+        if (buf_f32) {
+            render_layout_f32(buf_f32, samples_to_do, vgmstream);
+            mix_vgmstream_f32(buf_f32, samples_to_do, vgmstream);
+        }
+        else {
+            render_layout(buf, samples_to_do, vgmstream);
+            mix_vgmstream(buf, samples_to_do, vgmstream);
+        }
         return samples_to_do;
     }
 
@@ -452,43 +633,52 @@ int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream)
 
     /* adds empty samples to buf */
     if (ps->pad_begin_left) {
-        done = render_pad_begin(vgmstream, tmpbuf, samples_to_do);
+        done = render_pad_begin(vgmstream, tmpbuf, tmpbuf_f32, samples_to_do);
         samples_done += done;
         samples_to_do -= done;
-        tmpbuf += done * vgmstream->pstate.output_channels; /* as if mixed */
+        if (buf_f32)
+            tmpbuf_f32 += done * sample_step;
+        else
+            tmpbuf += done * sample_step;
     }
 
     /* end padding (before to avoid decoding if possible, but must be inside pad region) */
     if (!vgmstream->config.play_forever
             && ps->play_position /*+ samples_to_do*/ >= ps->pad_end_start
             && samples_to_do) {
-        done = render_pad_end(vgmstream, tmpbuf, samples_to_do);
+        done = render_pad_end(vgmstream, tmpbuf, tmpbuf_f32, samples_to_do);
         samples_done += done;
         samples_to_do -= done;
-        tmpbuf += done * vgmstream->pstate.output_channels; /* as if mixed */
+        if (buf_f32)
+            tmpbuf_f32 += done * sample_step;
+        else
+            tmpbuf += done * sample_step;
     }
 
     /* main decode */
     { //if (samples_to_do)  /* 0 ok, less likely */
-        done = render_layout(tmpbuf, samples_to_do, vgmstream);
-
-        mix_vgmstream(tmpbuf, done, vgmstream);
+        if (buf_f32) {
+            done = render_layout_f32(tmpbuf_f32, samples_to_do, vgmstream);
+            mix_vgmstream_f32(tmpbuf_f32, done, vgmstream);
+        }
+        else {
+            done = render_layout(tmpbuf, samples_to_do, vgmstream);
+            mix_vgmstream(tmpbuf, done, vgmstream);
+        }
 
         samples_done += done;
 
         if (!vgmstream->config.play_forever) {
             /* simple fadeout */
             if (ps->fade_left && ps->play_position + done >= ps->fade_start) {
-                render_fade(vgmstream, tmpbuf, done);
+                render_fade(vgmstream, tmpbuf, tmpbuf_f32, done);
             }
 
             /* silence leftover buf samples (rarely used when no fade is set) */
             if (ps->play_position + done >= ps->pad_end_start) {
-                render_pad_end(vgmstream, tmpbuf, done);
+                render_pad_end(vgmstream, tmpbuf, tmpbuf_f32, done);
             }
         }
-
-        tmpbuf += done * vgmstream->pstate.output_channels;
     }
 
 
@@ -508,3 +698,68 @@ int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream)
 
     return samples_done;
 }
+
+int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    return render_main(buf, NULL, sample_count, vgmstream);
+}
+
+int render_vgmstream_f32(float* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    int32_t samples_done;
+    int32_t planar_size = vgmstream->planar_size;
+
+    vgmstream->planar_size = 0; /* float buf is always interleaved */
+    samples_done = render_main(NULL, buf, sample_count, vgmstream);
+    vgmstream->planar_size = planar_size;
+    return samples_done;
+}
+
+/* planar rendering needs layouts that call decode_vgmstream directly (layers/segments
+ * have their own interleaved buffers) and codecs that can write planes */
+static int render_can_planar(VGMSTREAM* vgmstream) {
+    int input_channels, output_channels;
+
+    if (vgmstream->layout_type == layout_segmented || vgmstream->layout_type == layout_layered)
+        return 0;
+
+    /* decoders write all input planes, that wouldn't fit a buffer of output planes when downmixing */
+    mixing_info(vgmstream, &input_channels, &output_channels);
+    if (input_channels > output_channels)
+        return 0;
+
+    return decode_can_planar(vgmstream);
+}
+
+int render_vgmstream_planar(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    int32_t samples_done = 0;
+    int input_channels, output_channels, max_channels;
+    int32_t buf_samples;
+
+    /* decode, mix and fade in planes directly */
+    if (render_can_planar(vgmstream)) {
+        vgmstream->planar_size = sample_count;
+        samples_done = render_vgmstream(buf, sample_count, vgmstream);
+        vgmstream->planar_size = 0;
+        return samples_done;
+    }
+
+    /* others render interleaved in chunks, then split
+     * (tmpbuf is also used by trims, but those are done before the render writes anything) */
+    mixing_info(vgmstream, &input_channels, &output_channels);
+    max_channels = input_channels > output_channels ? input_channels : output_channels;
+    buf_samples = vgmstream->tmpbuf_size / max_channels;
+
+    while (samples_done < sample_count) {
+        int32_t done, to_do = sample_count - samples_done;
+        if (to_do > buf_samples)
+            to_do = buf_samples;
+
+        done = render_vgmstream(vgmstream->tmpbuf, to_do, vgmstream);
+        deinterleave_samples(buf + samples_done, vgmstream->tmpbuf, output_channels, sample_count, done);
+
+        samples_done += done;
+        if (done < to_do)
+            break;
+    }
+
+    return samples_done;
+}
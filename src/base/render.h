@@ -7,5 +7,11 @@ void render_free(VGMSTREAM* vgmstream);
 void render_reset(VGMSTREAM* vgmstream);
 int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream);
 
+/* Decodes and discards samples (no mixing), skipping actual decoding when the codec allows it */
+void render_skip(VGMSTREAM* vgmstream, int32_t sample_count);
+
+/* Advances decoder N samples from current, jumping directly or from saved states where possible (see seek.c) */
+void seek_force_decode(VGMSTREAM* vgmstream, int samples);
+
 
 #endif
@@ -4,6 +4,8 @@
 #include "decode.h"
 #include "mixing.h"
 #include "plugins.h"
+#include "seek_table.h"
+#include "../util/sf_utils.h"
 
 
 static void seek_force_loop(VGMSTREAM* vgmstream, int loop_count) {
@@ -17,20 +19,158 @@ static void seek_force_loop(VGMSTREAM* vgmstream, int loop_count) {
     decode_do_loop(vgmstream);
 }
 
-static void seek_force_decode(VGMSTREAM* vgmstream, int samples) {
-    sample_t* tmpbuf = vgmstream->tmpbuf;
-    size_t tmpbuf_size = vgmstream->tmpbuf_size;
-    int32_t buf_samples = tmpbuf_size / vgmstream->channels; /* base channels, no need to apply mixing */
+/* segments can seek internally, so jump to the target segment rather than decoding all samples before */
+static int seek_force_segmented(VGMSTREAM* vgmstream, int samples) {
+    int32_t seek_sample = vgmstream->current_sample + samples;
+
+    if (seek_sample >= vgmstream->num_samples)
+        return 0;
+    /* simple seeks may need to loop a few times */
+    if (vgmstream->loop_flag && seek_sample > vgmstream->loop_end_sample)
+        return 0;
+
+    /* loop state must be saved when passing loop start, as when decoding */
+    if (vgmstream->loop_flag && !vgmstream->hit_loop
+            && vgmstream->current_sample <= vgmstream->loop_start_sample && seek_sample > vgmstream->loop_start_sample) {
+        seek_layout_segmented(vgmstream, vgmstream->loop_start_sample);
+        decode_do_loop(vgmstream);
+    }
+
+    seek_layout_segmented(vgmstream, seek_sample);
+    return 1;
+}
+
+/* codecs with independent frames can jump to the target frame directly (decoding only the rest of the frame) */
+static int seek_force_frame(VGMSTREAM* vgmstream, int32_t seek_sample) {
+    switch (vgmstream->layout_type) {
+        case layout_none:
+            return seek_layout_flat(vgmstream, seek_sample);
+        case layout_interleave:
+            return seek_layout_interleave(vgmstream, seek_sample);
+        default:
+            return 0;
+    }
+}
+
+static int seek_force_can_jump(VGMSTREAM* vgmstream) {
+    int samples_per_frame, frame_size, moves_offset;
+
+    if (vgmstream->seek_table)
+        return 1;
+    if (vgmstream->layout_type != layout_none && vgmstream->layout_type != layout_interleave)
+        return 0;
+    return decode_get_seek_frame(vgmstream, &samples_per_frame, &frame_size, &moves_offset);
+}
+
+/* move decoder closer to seek sample without decoding (returns 1 if moved) */
+static int seek_force_jump(VGMSTREAM* vgmstream, int32_t seek_sample) {
+
+    if (seek_sample >= vgmstream->num_samples)
+        return 0;
+    /* simple seeks may need to loop a few times */
+    if (vgmstream->loop_flag && seek_sample > vgmstream->loop_end_sample)
+        return 0;
+
+    if (seek_force_frame(vgmstream, seek_sample))
+        return 1;
+    /* restore closest saved decoder state */
+    return seek_table_load(vgmstream, seek_sample);
+}
 
-    while (samples) {
-        int to_do = samples;
-        if (to_do > buf_samples)
-            to_do = buf_samples;
+/* skip as much decoding as possible, directly or with checkpoints (returns samples left) */
+static int seek_force_skip(VGMSTREAM* vgmstream, int samples) {
+    int32_t seek_sample = vgmstream->current_sample + samples;
 
-        render_layout(tmpbuf, to_do, vgmstream);
-        /* no mixing */
-        samples -= to_do;
+    /* loop state must be saved when passing loop start, as when decoding */
+    if (vgmstream->loop_flag && !vgmstream->hit_loop && seek_sample > vgmstream->loop_start_sample) {
+        if (vgmstream->current_sample > vgmstream->loop_start_sample) /* shouldn't happen */
+            return samples;
+
+        seek_force_jump(vgmstream, vgmstream->loop_start_sample);
+        render_skip(vgmstream, vgmstream->loop_start_sample - vgmstream->current_sample);
+        decode_do_loop(vgmstream);
     }
+
+    seek_force_jump(vgmstream, seek_sample);
+    return seek_sample - vgmstream->current_sample;
+}
+
+void seek_force_decode(VGMSTREAM* vgmstream, int samples) {
+
+    if (samples > 0 && vgmstream->layout_type == layout_segmented) {
+        if (seek_force_segmented(vgmstream, samples))
+            return;
+    }
+
+    if (samples > 0 && seek_force_can_jump(vgmstream)) {
+        samples = seek_force_skip(vgmstream, samples);
+    }
+
+    render_skip(vgmstream, samples);
+}
+
+void vgmstream_set_seek_table(VGMSTREAM* vgmstream, int32_t interval) {
+    int i;
+
+    /* sub-VGMSTREAMs seek on their own */
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        data->seek_interval = interval; /* for deferred segments */
+        for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i])
+                continue;
+            vgmstream_set_seek_table(data->segments[i], interval);
+        }
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->layer_count; i++) {
+            vgmstream_set_seek_table(data->layers[i], interval);
+        }
+    }
+    else {
+        seek_table_free(vgmstream->seek_table);
+        vgmstream->seek_table = NULL;
+
+        if (interval > 0 && seek_table_is_supported(vgmstream))
+            vgmstream->seek_table = seek_table_init(interval, vgmstream->channels);
+    }
+
+    setup_vgmstream(vgmstream); /* save for reset */
+}
+
+void vgmstream_scan_seek_table(VGMSTREAM* vgmstream) {
+    int i;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i]) /* closed deferred segment, saves points when played */
+                continue;
+            vgmstream_scan_seek_table(data->segments[i]);
+        }
+        return;
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->layer_count; i++) {
+            vgmstream_scan_seek_table(data->layers[i]);
+        }
+        return;
+    }
+
+    if (!vgmstream->seek_table)
+        return;
+
+    /* whole file without looping, as points past loop end may be used with loop targets (restored on reset) */
+    reset_vgmstream(vgmstream);
+    vgmstream->loop_flag = 0;
+    render_skip(vgmstream, vgmstream->num_samples);
+    reset_vgmstream(vgmstream);
 }
 
 void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample) {
@@ -49,17 +189,10 @@ void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample) {
     if (vgmstream->config_enabled && seek_sample > ps->play_duration && !play_forever)
         seek_sample = ps->play_duration;
 
+    /* segmented layouts seek internally when decoding (see seek_force_decode) */
 #if 0 //todo move below, needs to clamp in decode part
     /* optimize as layouts can seek faster internally */
-    if (vgmstream->layout_type == layout_segmented) {
-        seek_layout_segmented(vgmstream, seek_sample);
-
-        if (vgmstream->config_enabled) {
-            vgmstream->pstate.play_position = seek_sample;
-        }
-        return;
-    }
-    else if (vgmstream->layout_type == layout_layered) {
+    if (vgmstream->layout_type == layout_layered) {
         seek_layout_layered(vgmstream, seek_sample);
 
         if (vgmstream->config_enabled) {
@@ -243,3 +376,127 @@ void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample) {
 
     vgmstream->pstate.play_position = seek_sample;
 }
+
+
+/* Stream identity for cached tables: same file data/subsong/start should decode the same. File dates
+ * aren't available in STREAMFILEs, so a hash of the first data bytes catches replaced files instead.
+ * Loops and play config are included too, as they change how far the first pass (where points are saved) goes. */
+static int get_seek_cache_key(VGMSTREAM* vgmstream, char* key, size_t key_size) {
+    VGMSTREAMCHANNEL* start_ch = vgmstream->start_ch;
+    play_config_t* cfg = &vgmstream->config;
+    STREAMFILE* sf = start_ch[0].streamfile;
+    char filename[PATH_LIMIT];
+    uint8_t buf[0x800];
+    uint32_t data_hash = 0x811C9DC5;
+    int i, bytes;
+
+    if (!sf)
+        return 0;
+
+    get_streamfile_name(sf, filename, sizeof(filename));
+    bytes = read_streamfile(buf, start_ch[0].offset, sizeof(buf), sf);
+    for (i = 0; i < bytes; i++) {
+        data_hash = (data_hash ^ buf[i]) * 0x01000193; /* FNV-1a */
+    }
+
+    snprintf(key, key_size, "%s|%x|%i|%x|%x|%i|%i|%i|%i|%i|%i:%i:%i|%i:%i:%i:%i:%i:%i:%i:%i",
+            filename, (uint32_t)get_streamfile_size(sf), vgmstream->stream_index, (uint32_t)start_ch[0].offset, data_hash,
+            vgmstream->num_samples, vgmstream->channels, vgmstream->coding_type, vgmstream->layout_type, vgmstream->meta_type,
+            vgmstream->loop_flag, vgmstream->loop_start_sample, vgmstream->loop_end_sample,
+            vgmstream->config_enabled, cfg->ignore_loop, cfg->force_loop, cfg->really_force_loop,
+            cfg->pad_begin, cfg->trim_begin, cfg->body_time, cfg->trim_end);
+    return 1;
+}
+
+static void get_seek_cache_path(const char* cache_dir, const char* key, char* path, size_t path_size) {
+    uint32_t hash1 = 0x811C9DC5, hash2 = 0;
+    int i;
+
+    for (i = 0; key[i] != '\0'; i++) {
+        hash1 = (hash1 ^ (uint8_t)key[i]) * 0x01000193;
+        hash2 = hash2 * 31 + (uint8_t)key[i];
+    }
+
+    snprintf(path, path_size, "%s/%08x%08x.vgmseek", cache_dir, hash1, hash2);
+}
+
+int vgmstream_save_seek_table(VGMSTREAM* vgmstream, const char* cache_dir) {
+    char key[PATH_LIMIT + 0x100];
+    char path[PATH_LIMIT];
+    int i, ok = 1;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i]) /* closed deferred segment */
+                continue;
+            ok &= vgmstream_save_seek_table(data->segments[i], cache_dir);
+        }
+        return ok;
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->layer_count; i++) {
+            ok &= vgmstream_save_seek_table(data->layers[i], cache_dir);
+        }
+        return ok;
+    }
+
+    if (!vgmstream->seek_table)
+        return 1; /* nothing to save */
+    if (!get_seek_cache_key(vgmstream, key, sizeof(key)))
+        return 0;
+
+    get_seek_cache_path(cache_dir, key, path, sizeof(path));
+    return seek_table_write_file(vgmstream->seek_table, path, key);
+}
+
+int vgmstream_load_seek_table(VGMSTREAM* vgmstream, const char* cache_dir) {
+    char key[PATH_LIMIT + 0x100];
+    char path[PATH_LIMIT];
+    seek_table_t* table;
+    int i, ok = 1;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->segment_count; i++) {
+            if (!data->segments[i])
+                continue;
+            ok &= vgmstream_load_seek_table(data->segments[i], cache_dir);
+        }
+        return ok;
+    }
+    else if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->layer_count; i++) {
+            ok &= vgmstream_load_seek_table(data->layers[i], cache_dir);
+        }
+        return ok;
+    }
+
+    if (!seek_table_is_supported(vgmstream))
+        return 1; /* seeks as usual */
+    if (!get_seek_cache_key(vgmstream, key, sizeof(key)))
+        return 0;
+
+    get_seek_cache_path(cache_dir, key, path, sizeof(path));
+    table = seek_table_read_file(path, key, vgmstream);
+    if (!table)
+        return 0;
+
+    /* current table may have more points if it was used before loading */
+    if (seek_table_get_count(vgmstream->seek_table) >= seek_table_get_count(table)) {
+        seek_table_free(table);
+        return 1;
+    }
+
+    seek_table_free(vgmstream->seek_table);
+    vgmstream->seek_table = table;
+
+    setup_vgmstream(vgmstream); /* save for reset */
+    return 1;
+}
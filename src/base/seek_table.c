@@ -0,0 +1,511 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "seek_table.h"
+#include "decode.h"
+
+/* SEEK TABLE
+ * Seeking normally resets and decodes (discarding samples) up to the seek point. Instead, decoder state can be
+ * saved every N samples while decoding (playback, seeks or a pre-scan), so seeks restore the closest checkpoint
+ * and only decode the remainder.
+ *
+ * Only for codecs that keep all their state in VGMSTREAM/VGMSTREAMCHANNEL (most PCM/ADPCM), as codec_data
+ * can't be copied. This includes cache files: codecs without random access that would benefit most (custom
+ * Vorbis, EALayer3, UTK, etc) aren't covered. Layouts with sub-VGMSTREAMs save their own tables per segment/layer.
+ *
+ * Points are only saved the first time decoding goes through a sample (before any loop) and always in order,
+ * since after looping state may be a bit different (see decode_keeps_loop_history).
+ */
+
+#define SEEK_TABLE_MIN_INTERVAL  4096  /* smaller intervals don't save much decoding vs memory/copy overhead */
+#define SEEK_TABLE_FILE_ID       0x4B534756  /* "VGSK" */
+#define SEEK_TABLE_FILE_VERSION  2
+#define SEEK_TABLE_MAX_KEY       0x1000
+#define SEEK_TABLE_MAX_COUNT     0x1000000
+
+/* block/layout state, as saved on loop start (see decode_do_loop) */
+typedef struct {
+    int32_t current_sample;
+    int32_t samples_into_block;
+    int64_t current_block_offset;
+    int64_t current_block_size;
+    int32_t current_block_samples;
+    int32_t ws_output_size;
+    int64_t next_block_offset;
+    int64_t full_block_size;
+} seek_point_t;
+
+/* VGMSTREAMCHANNEL fields that change while decoding (others are set by the meta and stay the same),
+ * as fixed size values so tables don't depend on the build's struct layout. */
+typedef struct {
+    int64_t offset;
+    int64_t frame_header_offset;
+    int32_t samples_left_in_frame;
+    int32_t adpcm_history1_32;          /* also 16-bit history (same union) */
+    int32_t adpcm_history2_32;
+    int32_t adpcm_history3_32;
+    int32_t adpcm_history4_32;
+    int32_t adpcm_step_index;
+    int32_t adpcm_scale;
+    int16_t adpcm_coef[16];             /* set per frame/block in some codecs/layouts (MSADPCM, THP) */
+    int32_t g72x_yl;
+    int16_t g72x_yu;
+    int16_t g72x_dms;
+    int16_t g72x_dml;
+    int16_t g72x_ap;
+    int16_t g72x_a[2];
+    int16_t g72x_b[6];
+    int16_t g72x_pk[2];
+    int16_t g72x_dq[6];
+    int16_t g72x_sr[2];
+    int16_t g72x_td;
+    uint16_t adx_xor;
+} seek_channel_t;
+
+struct seek_table_t {
+    int32_t interval;
+    int channels;
+
+    seek_point_t* points;       /* ordered by current_sample */
+    seek_channel_t* chs;        /* channels per point */
+    int count;
+    int max;
+};
+
+static void save_channel(seek_channel_t* state, VGMSTREAMCHANNEL* ch) {
+    int i;
+
+    state->offset = ch->offset;
+    state->frame_header_offset = ch->frame_header_offset;
+    state->samples_left_in_frame = ch->samples_left_in_frame;
+    state->adpcm_history1_32 = ch->adpcm_history1_32;
+    state->adpcm_history2_32 = ch->adpcm_history2_32;
+    state->adpcm_history3_32 = ch->adpcm_history3_32;
+    state->adpcm_history4_32 = ch->adpcm_history4_32;
+    state->adpcm_step_index = ch->adpcm_step_index;
+    state->adpcm_scale = ch->adpcm_scale;
+    memcpy(state->adpcm_coef, ch->adpcm_coef, sizeof(state->adpcm_coef));
+    state->g72x_yl = ch->g72x_state.yl;
+    state->g72x_yu = ch->g72x_state.yu;
+    state->g72x_dms = ch->g72x_state.dms;
+    state->g72x_dml = ch->g72x_state.dml;
+    state->g72x_ap = ch->g72x_state.ap;
+    for (i = 0; i < 2; i++) {
+        state->g72x_a[i] = ch->g72x_state.a[i];
+        state->g72x_pk[i] = ch->g72x_state.pk[i];
+        state->g72x_sr[i] = ch->g72x_state.sr[i];
+    }
+    for (i = 0; i < 6; i++) {
+        state->g72x_b[i] = ch->g72x_state.b[i];
+        state->g72x_dq[i] = ch->g72x_state.dq[i];
+    }
+    state->g72x_td = ch->g72x_state.td;
+    state->adx_xor = ch->adx_xor;
+}
+
+static void load_channel(VGMSTREAMCHANNEL* ch, seek_channel_t* state) {
+    int i;
+
+    ch->offset = state->offset;
+    ch->frame_header_offset = state->frame_header_offset;
+    ch->samples_left_in_frame = state->samples_left_in_frame;
+    ch->adpcm_history1_32 = state->adpcm_history1_32;
+    ch->adpcm_history2_32 = state->adpcm_history2_32;
+    ch->adpcm_history3_32 = state->adpcm_history3_32;
+    ch->adpcm_history4_32 = state->adpcm_history4_32;
+    ch->adpcm_step_index = state->adpcm_step_index;
+    ch->adpcm_scale = state->adpcm_scale;
+    memcpy(ch->adpcm_coef, state->adpcm_coef, sizeof(state->adpcm_coef));
+    ch->g72x_state.yl = state->g72x_yl;
+    ch->g72x_state.yu = state->g72x_yu;
+    ch->g72x_state.dms = state->g72x_dms;
+    ch->g72x_state.dml = state->g72x_dml;
+    ch->g72x_state.ap = state->g72x_ap;
+    for (i = 0; i < 2; i++) {
+        ch->g72x_state.a[i] = state->g72x_a[i];
+        ch->g72x_state.pk[i] = state->g72x_pk[i];
+        ch->g72x_state.sr[i] = state->g72x_sr[i];
+    }
+    for (i = 0; i < 6; i++) {
+        ch->g72x_state.b[i] = state->g72x_b[i];
+        ch->g72x_state.dq[i] = state->g72x_dq[i];
+    }
+    ch->g72x_state.td = state->g72x_td;
+    ch->adx_xor = state->adx_xor;
+}
+
+
+seek_table_t* seek_table_init(int32_t interval, int channels) {
+    seek_table_t* table;
+
+    if (interval <= 0 || channels <= 0)
+        return NULL;
+    if (interval < SEEK_TABLE_MIN_INTERVAL)
+        interval = SEEK_TABLE_MIN_INTERVAL;
+
+    table = calloc(1, sizeof(seek_table_t));
+    if (!table) return NULL;
+
+    table->interval = interval;
+    table->channels = channels;
+    return table;
+}
+
+void seek_table_free(seek_table_t* table) {
+    if (!table)
+        return;
+    free(table->points);
+    free(table->chs);
+    free(table);
+}
+
+int seek_table_is_supported(VGMSTREAM* vgmstream) {
+    /* custom state (also for layouts, that save their own tables) */
+    if (vgmstream->codec_data || vgmstream->layout_data)
+        return 0;
+    return 1;
+}
+
+static int grow_table(seek_table_t* table) {
+    seek_point_t* points_re;
+    seek_channel_t* chs_re;
+    int max = table->max ? table->max * 2 : 64;
+
+    points_re = realloc(table->points, max * sizeof(seek_point_t));
+    if (!points_re) return 0;
+    table->points = points_re;
+
+    chs_re = realloc(table->chs, (size_t)max * table->channels * sizeof(seek_channel_t));
+    if (!chs_re) return 0;
+    table->chs = chs_re;
+
+    table->max = max;
+    return 1;
+}
+
+/* points aren't saved after looping or past the end (where decoders just output silence) */
+static int is_first_pass(VGMSTREAM* vgmstream) {
+    return vgmstream->loop_count == 0 && vgmstream->current_sample < vgmstream->num_samples;
+}
+
+static int32_t get_last_sample(seek_table_t* table) {
+    return table->count ? table->points[table->count - 1].current_sample : 0;
+}
+
+int32_t seek_table_get_samples_to_next(VGMSTREAM* vgmstream) {
+    seek_table_t* table = vgmstream->seek_table;
+    int32_t samples_to_next;
+
+    if (!table || table->channels != vgmstream->channels || !is_first_pass(vgmstream))
+        return 0;
+    if (!seek_table_is_supported(vgmstream))
+        return 0;
+
+    /* past the next point means one is due after current render */
+    samples_to_next = get_last_sample(table) + table->interval - vgmstream->current_sample;
+    if (samples_to_next <= 0)
+        return 0;
+    return samples_to_next;
+}
+
+void seek_table_save(VGMSTREAM* vgmstream) {
+    seek_table_t* table = vgmstream->seek_table;
+    seek_point_t* point;
+    int ch;
+
+    if (!table || table->channels != vgmstream->channels || !is_first_pass(vgmstream))
+        return;
+
+    if (vgmstream->current_sample < get_last_sample(table) + table->interval)
+        return;
+
+    if (!seek_table_is_supported(vgmstream))
+        return;
+    if (table->count == table->max && !grow_table(table))
+        return;
+
+    point = &table->points[table->count];
+    point->current_sample = vgmstream->current_sample;
+    point->samples_into_block = vgmstream->samples_into_block;
+    point->current_block_offset = vgmstream->current_block_offset;
+    point->current_block_size = vgmstream->current_block_size;
+    point->current_block_samples = vgmstream->current_block_samples;
+    point->next_block_offset = vgmstream->next_block_offset;
+    point->full_block_size = vgmstream->full_block_size;
+    point->ws_output_size = vgmstream->ws_output_size;
+    for (ch = 0; ch < vgmstream->channels; ch++) {
+        save_channel(&table->chs[table->count * table->channels + ch], &vgmstream->ch[ch]);
+    }
+
+    table->count++;
+}
+
+int seek_table_load(VGMSTREAM* vgmstream, int32_t seek_sample) {
+    seek_table_t* table = vgmstream->seek_table;
+    seek_point_t* point;
+    seek_channel_t* chs;
+    int lo, hi, ch;
+
+    if (!table || table->channels != vgmstream->channels || !table->count)
+        return 0;
+    if (!seek_table_is_supported(vgmstream))
+        return 0;
+    /* points are from the first pass */
+    if (vgmstream->loop_count > 0 && decode_keeps_loop_history(vgmstream))
+        return 0;
+
+    /* find last point <= seek sample */
+    lo = 0;
+    hi = table->count - 1;
+    if (table->points[lo].current_sample > seek_sample)
+        return 0;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (table->points[mid].current_sample <= seek_sample)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    point = &table->points[lo];
+    if (point->current_sample <= vgmstream->current_sample)
+        return 0; /* decoding from current is closer */
+
+    vgmstream->current_sample = point->current_sample;
+    vgmstream->samples_into_block = point->samples_into_block;
+    vgmstream->current_block_offset = point->current_block_offset;
+    vgmstream->current_block_size = point->current_block_size;
+    vgmstream->current_block_samples = point->current_block_samples;
+    vgmstream->next_block_offset = point->next_block_offset;
+    vgmstream->full_block_size = point->full_block_size;
+    vgmstream->ws_output_size = point->ws_output_size;
+
+    /* only decoder state (streamfiles may have changed since saved, like when setting decode threads) */
+    chs = &table->chs[lo * table->channels];
+    for (ch = 0; ch < vgmstream->channels; ch++) {
+        load_channel(&vgmstream->ch[ch], &chs[ch]);
+    }
+
+    return 1;
+}
+
+int seek_table_get_count(seek_table_t* table) {
+    return table ? table->count : 0;
+}
+
+int32_t seek_table_get_interval(seek_table_t* table) {
+    return table ? table->interval : 0;
+}
+
+
+/* Cache files are meant to be read by the same build on the same machine, so values are written as is
+ * (in native endianness). The header stores version and struct sizes, and the stored key includes them as
+ * well, so files from other versions are just ignored (and rewritten). Since cache files may come from
+ * anywhere, offsets, sample positions and codec state used as table indexes are validated on load too. */
+typedef struct {
+    uint32_t id;
+    uint32_t version;
+    uint32_t point_size;
+    uint32_t channel_size;
+    uint32_t key_size;
+    int32_t interval;
+    int32_t channels;
+    int32_t count;
+} seek_table_file_t;
+
+static void init_file_header(seek_table_file_t* hdr, const char* key) {
+    memset(hdr, 0, sizeof(seek_table_file_t));
+    hdr->id = SEEK_TABLE_FILE_ID;
+    hdr->version = SEEK_TABLE_FILE_VERSION;
+    hdr->point_size = sizeof(seek_point_t);
+    hdr->channel_size = sizeof(seek_channel_t);
+    hdr->key_size = strlen(key);
+}
+
+/* caller's key (stream identity) plus table format */
+static int get_file_key(char* file_key, size_t file_key_size, const char* key) {
+    int len = snprintf(file_key, file_key_size, "%x|%x|%x|%s",
+            SEEK_TABLE_FILE_VERSION, (uint32_t)sizeof(seek_point_t), (uint32_t)sizeof(seek_channel_t), key);
+    return len > 0 && (size_t)len < file_key_size;
+}
+
+int seek_table_write_file(seek_table_t* table, const char* path, const char* key) {
+    seek_table_file_t hdr;
+    char file_key[SEEK_TABLE_MAX_KEY];
+    char temp_path[PATH_LIMIT];
+    FILE* file = NULL;
+    size_t chs_count;
+
+    if (!table || !table->count || !get_file_key(file_key, sizeof(file_key), key))
+        return 0;
+
+    init_file_header(&hdr, file_key);
+    hdr.interval = table->interval;
+    hdr.channels = table->channels;
+    hdr.count = table->count;
+    chs_count = (size_t)table->count * table->channels;
+
+    /* written apart then renamed, so other processes never read partial files */
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    file = fopen(temp_path, "wb");
+    if (!file) goto fail;
+
+    if (fwrite(&hdr, sizeof(seek_table_file_t), 1, file) != 1)
+        goto fail;
+    if (fwrite(file_key, 1, hdr.key_size, file) != hdr.key_size)
+        goto fail;
+    if (fwrite(table->points, sizeof(seek_point_t), table->count, file) != (size_t)table->count)
+        goto fail;
+    if (fwrite(table->chs, sizeof(seek_channel_t), chs_count, file) != chs_count)
+        goto fail;
+
+    if (fclose(file) != 0) {
+        file = NULL;
+        goto fail;
+    }
+    file = NULL;
+
+    if (rename(temp_path, path) != 0) {
+        remove(path); /* Windows can't rename over existing files */
+        if (rename(temp_path, path) != 0)
+            goto fail;
+    }
+
+    return 1;
+fail:
+    if (file) fclose(file);
+    remove(temp_path);
+    return 0;
+}
+
+/* checks loaded points make sense for the stream, so bad files can't make decoders jump anywhere */
+/* max step_index usable by each codec, as decoders index their tables with it directly (values from
+ * headers are clamped while parsing, but restored state isn't) */
+static int get_max_step_index(coding_t coding_type) {
+    switch (coding_type) {
+        case coding_TGC:
+            return 7;
+        case coding_MTAF:
+            return 31;
+        case coding_OKI16:
+        case coding_OKI4S:
+            return 48;
+        case coding_MC3:
+            return 63;
+        case coding_AICA:
+        case coding_AICA_int:
+        case coding_ASKA:
+        case coding_NXAP:
+        case coding_CP_YM:
+            return 0x6000; /* step size rather than index */
+        default:
+            return 88; /* IMA and others that don't use it (stays 0) */
+    }
+}
+
+static int is_table_valid(seek_table_t* table, VGMSTREAM* vgmstream) {
+    int32_t last_sample = 0;
+    int max_step_index = get_max_step_index(vgmstream->coding_type);
+    int i;
+
+    if (table->channels != vgmstream->channels)
+        return 0;
+
+    for (i = 0; i < table->count; i++) {
+        seek_point_t* point = &table->points[i];
+
+        /* saved in order, with at least interval samples between points */
+        if (point->current_sample < last_sample + table->interval || point->current_sample >= vgmstream->num_samples)
+            return 0;
+        if (point->samples_into_block < 0 || point->current_block_offset < 0 || point->next_block_offset < 0)
+            return 0;
+        if (point->current_block_size < 0 || point->ws_output_size < 0)
+            return 0;
+        last_sample = point->current_sample;
+    }
+
+    for (i = 0; i < table->count * table->channels; i++) {
+        seek_channel_t* state = &table->chs[i];
+
+        if (state->offset < 0 || state->frame_header_offset < 0 || state->samples_left_in_frame < 0)
+            return 0;
+        if (state->adpcm_step_index < 0 || state->adpcm_step_index > max_step_index)
+            return 0;
+        /* used as a shift */
+        if (vgmstream->coding_type == coding_CIRCUS_ADPCM && (state->adpcm_scale < 0 || state->adpcm_scale > 8))
+            return 0;
+    }
+
+    return 1;
+}
+
+seek_table_t* seek_table_read_file(const char* path, const char* key, VGMSTREAM* vgmstream) {
+    seek_table_file_t hdr, exp;
+    seek_table_t* table = NULL;
+    char file_key[SEEK_TABLE_MAX_KEY];
+    char exp_key[SEEK_TABLE_MAX_KEY];
+    FILE* file = NULL;
+    size_t chs_count;
+    long file_size, data_size;
+
+    if (!get_file_key(exp_key, sizeof(exp_key), key))
+        return NULL;
+
+    file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0)
+        goto fail;
+    file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0)
+        goto fail;
+
+    init_file_header(&exp, exp_key);
+    if (fread(&hdr, sizeof(seek_table_file_t), 1, file) != 1)
+        goto fail;
+    if (hdr.id != exp.id || hdr.version != exp.version || hdr.point_size != exp.point_size
+            || hdr.channel_size != exp.channel_size || hdr.key_size != exp.key_size)
+        goto fail;
+    if (hdr.channels <= 0 || hdr.channels > VGMSTREAM_MAX_CHANNELS || hdr.count <= 0 || hdr.count > SEEK_TABLE_MAX_COUNT)
+        goto fail;
+    if (hdr.interval < SEEK_TABLE_MIN_INTERVAL)
+        goto fail;
+
+    /* sizes must match the file exactly (also avoids big allocs from bad counts) */
+    chs_count = (size_t)hdr.count * (size_t)hdr.channels;
+    if (chs_count / hdr.channels != (size_t)hdr.count || chs_count > SIZE_MAX / sizeof(seek_channel_t))
+        goto fail;
+    data_size = file_size - (long)sizeof(seek_table_file_t) - (long)hdr.key_size;
+    if (data_size < 0 || (size_t)data_size != hdr.count * sizeof(seek_point_t) + chs_count * sizeof(seek_channel_t))
+        goto fail;
+
+    /* hash collisions or renamed files */
+    if (fread(file_key, 1, hdr.key_size, file) != hdr.key_size)
+        goto fail;
+    if (memcmp(file_key, exp_key, hdr.key_size) != 0)
+        goto fail;
+
+    table = seek_table_init(hdr.interval, hdr.channels);
+    if (!table) goto fail;
+
+    while (table->max < hdr.count) {
+        if (!grow_table(table))
+            goto fail;
+    }
+
+    if (fread(table->points, sizeof(seek_point_t), hdr.count, file) != (size_t)hdr.count)
+        goto fail;
+    if (fread(table->chs, sizeof(seek_channel_t), chs_count, file) != chs_count)
+        goto fail;
+    table->count = hdr.count;
+
+    if (!is_table_valid(table, vgmstream))
+        goto fail;
+
+    fclose(file);
+    return table;
+fail:
+    seek_table_free(table);
+    fclose(file);
+    return NULL;
+}
@@ -0,0 +1,37 @@
+#ifndef _SEEK_TABLE_H_
+#define _SEEK_TABLE_H_
+
+#include "../vgmstream.h"
+
+/* Decoder state checkpoints for faster seeks (see vgmstream_set_seek_table). */
+
+typedef struct seek_table_t seek_table_t;
+
+seek_table_t* seek_table_init(int32_t interval, int channels);
+void seek_table_free(seek_table_t* table);
+
+/* Returns 1 if current codec/layout state can be saved and restored with the table. */
+int seek_table_is_supported(VGMSTREAM* vgmstream);
+
+/* Saves current decoder state if interval samples have passed since last saved point (called after rendering). */
+void seek_table_save(VGMSTREAM* vgmstream);
+
+/* Returns samples to render before the next point should be saved, or 0 if no limit (renders stop there so
+ * points are saved every interval rather than on whatever sizes callers use). */
+int32_t seek_table_get_samples_to_next(VGMSTREAM* vgmstream);
+
+/* Restores closest saved state after current sample and up to seek_sample. Returns 1 if restored
+ * (decoder is then at some point between current and seek sample). */
+int seek_table_load(VGMSTREAM* vgmstream, int32_t seek_sample);
+
+/* Writes table to a cache file, along with a key that identifies the stream (file, subsong, etc). Returns 1 if ok. */
+int seek_table_write_file(seek_table_t* table, const char* path, const char* key);
+
+/* Reads table from a cache file written with the same key and build. Returns NULL if missing, different
+ * or invalid for the stream. */
+seek_table_t* seek_table_read_file(const char* path, const char* key, VGMSTREAM* vgmstream);
+
+int seek_table_get_count(seek_table_t* table);
+int32_t seek_table_get_interval(seek_table_t* table);
+
+#endif
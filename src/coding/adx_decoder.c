@@ -1,7 +1,8 @@
 #include "coding.h"
 #include "../util.h"
 
-void decode_adx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int32_t frame_size, coding_t coding_type) {
+/* decodes samples of one frame (or just updates state if outbuf is NULL) */
+static void decode_adx_frame(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int32_t frame_size, coding_t coding_type) {
     uint8_t frame[0x12] = {0};
     off_t frame_offset;
     int i, frames_in, sample_count = 0;
@@ -72,8 +73,10 @@ void decode_adx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
         sample = sample * scale + (coef1 * hist1 >> 12) + (coef2 * hist2 >> 12);
         sample = clamp16(sample);
 
-        outbuf[sample_count] = sample;
-        sample_count += channelspacing;
+        if (outbuf) {
+            outbuf[sample_count] = sample;
+            sample_count += channelspacing;
+        }
 
         hist2 = hist1;
         hist1 = sample;
@@ -89,6 +92,26 @@ void decode_adx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
     }
 }
 
+void decode_adx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int32_t frame_size, coding_t coding_type) {
+    decode_adx_frame(stream, outbuf, channelspacing, first_sample, samples_to_do, frame_size, coding_type);
+}
+
+/* Advances history (and key) over samples_to_do samples without output, as if decoded (for skips). */
+void skip_adx(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, int32_t frame_size, coding_t coding_type) {
+    int32_t samples_per_frame = (frame_size - 0x02) * 2;
+
+    while (samples_to_do > 0) {
+        int32_t samples_frame = samples_per_frame - first_sample % samples_per_frame;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
+
+        decode_adx_frame(stream, NULL, 0, first_sample, samples_frame, frame_size, coding_type);
+
+        first_sample += samples_frame;
+        samples_to_do -= samples_frame;
+    }
+}
+
 void adx_next_key(VGMSTREAMCHANNEL* stream) {
     stream->adx_xor = (stream->adx_xor * stream->adx_mult + stream->adx_add) & 0x7fff;
 }
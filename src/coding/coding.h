@@ -7,8 +7,13 @@
 //todo remove
 #include "hca_decoder_clhca.h"
 
+/* Some decoders (DSP, PSX, MSADPCM, XA) may be called with samples from multiple frames, and read them
+ * into a local buffer of this size at once (rather than frame by frame), then decode from memory. */
+#define DECODE_BLOCK_BUFFER_SIZE  0x1000
+
 /* adx_decoder */
 void decode_adx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int32_t frame_bytes, coding_t coding_type);
+void skip_adx(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, int32_t frame_bytes, coding_t coding_type);
 void adx_next_key(VGMSTREAMCHANNEL* stream);
 
 
@@ -54,6 +59,8 @@ int xbox_check_format(STREAMFILE* sf, uint32_t offset, uint32_t max, int channel
 
 /* ngc_dsp_decoder */
 void decode_ngc_dsp(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
+int decode_ngc_dsp_multi(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int channels, int32_t first_sample, int32_t samples_to_do);
+void skip_ngc_dsp(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do);
 void decode_ngc_dsp_subint(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int interleave);
 size_t dsp_bytes_to_samples(size_t bytes, int channels);
 int32_t dsp_nibbles_to_samples(int32_t nibbles);
@@ -96,6 +103,8 @@ void decode_alaw(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
 void decode_pcmfloat(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian);
 void decode_pcm24le(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
 void decode_pcm24be(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
+int decode_pcm_frames(VGMSTREAM* vgmstream, sample_t* outbuf, int ch_step, int32_t first_sample, int32_t samples_to_do);
+int pcm_get_frame_sample_size(VGMSTREAM* vgmstream);
 int32_t pcm_bytes_to_samples(size_t bytes, int channels, int bits_per_sample);
 int32_t pcm24_bytes_to_samples(size_t bytes, int channels);
 int32_t pcm16_bytes_to_samples(size_t bytes, int channels);
@@ -104,6 +113,8 @@ int32_t pcm8_bytes_to_samples(size_t bytes, int channels);
 
 /* psx_decoder */
 void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config);
+int decode_psx_multi(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int channels, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config);
+void skip_psx(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config);
 void decode_psx_configurable(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size, int config);
 void decode_psx_pivotal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size);
 int ps_find_loop_offsets(STREAMFILE* sf, off_t start_offset, size_t data_size, int channels, size_t interleave, int32_t* out_loop_start, int32_t* out_loop_end);
@@ -329,6 +340,7 @@ typedef struct hca_codec_data hca_codec_data;
 
 hca_codec_data* init_hca(STREAMFILE* sf);
 void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do);
+void decode_hca_f32(hca_codec_data* data, float* outbuf, int32_t samples_to_do);
 void reset_hca(hca_codec_data* data);
 void loop_hca(hca_codec_data* data, int32_t num_sample);
 void free_hca(hca_codec_data* data);
@@ -388,6 +400,7 @@ typedef struct { //todo simplify
 
 ogg_vorbis_codec_data* init_ogg_vorbis(STREAMFILE* sf, off_t start, off_t size, ogg_vorbis_io* io);
 void decode_ogg_vorbis(ogg_vorbis_codec_data* data, sample_t* outbuf, int32_t samples_to_do, int channels);
+void decode_ogg_vorbis_f32(ogg_vorbis_codec_data* data, float* outbuf, int32_t samples_to_do, int channels);
 void reset_ogg_vorbis(ogg_vorbis_codec_data* data);
 void seek_ogg_vorbis(ogg_vorbis_codec_data* data, int32_t num_sample);
 void free_ogg_vorbis(ogg_vorbis_codec_data* data);
@@ -604,6 +617,7 @@ ffmpeg_codec_data* init_ffmpeg_header_offset(STREAMFILE* sf, uint8_t* header, ui
 ffmpeg_codec_data* init_ffmpeg_header_offset_subsong(STREAMFILE* sf, uint8_t* header, uint64_t header_size, uint64_t start, uint64_t size, int target_subsong);
 
 void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels);
+void decode_ffmpeg_f32(VGMSTREAM* vgmstream, float* outbuf, int32_t samples_to_do, int channels);
 void reset_ffmpeg(ffmpeg_codec_data* data);
 void seek_ffmpeg(ffmpeg_codec_data* data, int32_t num_sample);
 void free_ffmpeg(ffmpeg_codec_data* data);
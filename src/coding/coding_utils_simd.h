@@ -0,0 +1,91 @@
+#ifndef _CODING_UTILS_SIMD_H_
+#define _CODING_UTILS_SIMD_H_
+
+/* Minimal int32/float vector helpers, for decoders that handle N channels at once (one per lane).
+ * Chosen at compile time: AVX2 (8 lanes) when the build targets it, SSE2 (4 lanes) on x86/x64,
+ * otherwise VGM_SIMD_LANES isn't defined and callers must use their scalar code.
+ * VGM_SIMD_SSE2 is also defined when plain SSE2 intrinsics can be used (for simpler memory-bound loops). */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#define VGM_SIMD_LANES  8
+#define VGM_SIMD_SSE2
+
+typedef __m256i simd_i32;
+typedef __m256  simd_f32;
+
+static inline simd_i32 simd_i32_load(const int32_t* p)         { return _mm256_loadu_si256((const __m256i*)p); }
+static inline void     simd_i32_store(int32_t* p, simd_i32 a)  { _mm256_storeu_si256((__m256i*)p, a); }
+static inline simd_i32 simd_i32_set1(int32_t x)                { return _mm256_set1_epi32(x); }
+static inline simd_i32 simd_i32_add(simd_i32 a, simd_i32 b)    { return _mm256_add_epi32(a, b); }
+static inline simd_i32 simd_i32_and(simd_i32 a, simd_i32 b)    { return _mm256_and_si256(a, b); }
+static inline simd_i32 simd_i32_or(simd_i32 a, simd_i32 b)     { return _mm256_or_si256(a, b); }
+/* a.lo16*b.lo16 + a.hi16*b.hi16 per lane */
+static inline simd_i32 simd_i32_madd16(simd_i32 a, simd_i32 b) { return _mm256_madd_epi16(a, b); }
+
+static inline simd_i32 simd_i32_clamp16(simd_i32 a) {
+    return _mm256_max_epi32(_mm256_min_epi32(a, _mm256_set1_epi32(32767)), _mm256_set1_epi32(-32768));
+}
+
+/* stores lanes as int16 (values must be clamped) */
+static inline void simd_i32_store16(int16_t* p, simd_i32 a) {
+    __m256i s16 = _mm256_packs_epi32(a, a); /* packs per 128-bit half: 0123 0123 4567 4567 */
+    s16 = _mm256_permute4x64_epi64(s16, 0xD8);
+    _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(s16));
+}
+
+static inline simd_f32 simd_f32_load(const float* p)           { return _mm256_loadu_ps(p); }
+static inline simd_f32 simd_f32_set1(float x)                  { return _mm256_set1_ps(x); }
+static inline simd_f32 simd_f32_add(simd_f32 a, simd_f32 b)    { return _mm256_add_ps(a, b); }
+static inline simd_f32 simd_f32_mul(simd_f32 a, simd_f32 b)    { return _mm256_mul_ps(a, b); }
+static inline simd_f32 simd_f32_from_i32(simd_i32 a)           { return _mm256_cvtepi32_ps(a); }
+/* truncates, like C casts */
+static inline simd_i32 simd_i32_from_f32(simd_f32 a)           { return _mm256_cvttps_epi32(a); }
+
+#define simd_i32_slli(a, n)     _mm256_slli_epi32(a, n)
+#define simd_i32_srai(a, n)     _mm256_srai_epi32(a, n)
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+#define VGM_SIMD_LANES  4
+#define VGM_SIMD_SSE2
+
+typedef __m128i simd_i32;
+typedef __m128  simd_f32;
+
+static inline simd_i32 simd_i32_load(const int32_t* p)         { return _mm_loadu_si128((const __m128i*)p); }
+static inline void     simd_i32_store(int32_t* p, simd_i32 a)  { _mm_storeu_si128((__m128i*)p, a); }
+static inline simd_i32 simd_i32_set1(int32_t x)                { return _mm_set1_epi32(x); }
+static inline simd_i32 simd_i32_add(simd_i32 a, simd_i32 b)    { return _mm_add_epi32(a, b); }
+static inline simd_i32 simd_i32_and(simd_i32 a, simd_i32 b)    { return _mm_and_si128(a, b); }
+static inline simd_i32 simd_i32_or(simd_i32 a, simd_i32 b)     { return _mm_or_si128(a, b); }
+/* a.lo16*b.lo16 + a.hi16*b.hi16 per lane */
+static inline simd_i32 simd_i32_madd16(simd_i32 a, simd_i32 b) { return _mm_madd_epi16(a, b); }
+
+/* no min/max_epi32 in SSE2: saturate to int16 and sign-extend back */
+static inline simd_i32 simd_i32_clamp16(simd_i32 a) {
+    __m128i s16 = _mm_packs_epi32(a, a);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+}
+
+/* stores lanes as int16 (values must be clamped) */
+static inline void simd_i32_store16(int16_t* p, simd_i32 a) {
+    _mm_storel_epi64((__m128i*)p, _mm_packs_epi32(a, a));
+}
+
+static inline simd_f32 simd_f32_load(const float* p)           { return _mm_loadu_ps(p); }
+static inline simd_f32 simd_f32_set1(float x)                  { return _mm_set1_ps(x); }
+static inline simd_f32 simd_f32_add(simd_f32 a, simd_f32 b)    { return _mm_add_ps(a, b); }
+static inline simd_f32 simd_f32_mul(simd_f32 a, simd_f32 b)    { return _mm_mul_ps(a, b); }
+static inline simd_f32 simd_f32_from_i32(simd_i32 a)           { return _mm_cvtepi32_ps(a); }
+/* truncates, like C casts */
+static inline simd_i32 simd_i32_from_f32(simd_f32 a)           { return _mm_cvttps_epi32(a); }
+
+#define simd_i32_slli(a, n)     _mm_slli_epi32(a, n)
+#define simd_i32_srai(a, n)     _mm_srai_epi32(a, n)
+
+#endif
+
+#endif
@@ -6,7 +6,7 @@ struct hca_codec_data {
     STREAMFILE* sf;
     clHCA_stInfo info;
 
-    signed short* sample_buffer;
+    float* sample_buffer;
     size_t samples_filled;
     size_t samples_consumed;
     size_t samples_to_discard;
@@ -54,7 +54,7 @@ hca_codec_data* init_hca(STREAMFILE* sf) {
     data->data_buffer = malloc(data->info.blockSize);
     if (!data->data_buffer) goto fail;
 
-    data->sample_buffer = malloc(sizeof(signed short) * data->info.channelCount * data->info.samplesPerBlock);
+    data->sample_buffer = malloc(sizeof(float) * data->info.channelCount * data->info.samplesPerBlock);
     if (!data->sample_buffer) goto fail;
 
     /* load streamfile for reads */
@@ -71,7 +71,24 @@ fail:
     return NULL;
 }
 
-void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
+/* same conversion as clHCA_ReadSamples16 */
+static void samples_hca_to_s16(sample_t* obuf, const float* ibuf, int count) {
+    const float scale_f = 32768.0f;
+    signed int s;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        s = (signed int)(ibuf[i] * scale_f);
+        if (s > 32767)
+            s = 32767;
+        else if (s < -32768)
+            s = -32768;
+        obuf[i] = (sample_t)s;
+    }
+}
+
+/* decodes to int16 outbuf or float outbuf_f32 (only one is set) */
+static void decode_hca_internal(hca_codec_data* data, sample_t* outbuf, float* outbuf_f32, int32_t samples_to_do) {
     int samples_done = 0;
     const unsigned int channels = data->info.channelCount;
     const unsigned int blockSize = data->info.blockSize;
@@ -93,9 +110,16 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
                 if (samples_to_get > samples_to_do - samples_done)
                     samples_to_get = samples_to_do - samples_done;
 
-                memcpy(outbuf + samples_done*channels,
-                       data->sample_buffer + data->samples_consumed*channels,
-                       samples_to_get*channels * sizeof(sample));
+                if (outbuf_f32) {
+                    memcpy(outbuf_f32 + samples_done*channels,
+                           data->sample_buffer + data->samples_consumed*channels,
+                           samples_to_get*channels * sizeof(float));
+                }
+                else {
+                    samples_hca_to_s16(outbuf + samples_done*channels,
+                           data->sample_buffer + data->samples_consumed*channels,
+                           samples_to_get*channels);
+                }
                 samples_done += samples_to_get;
             }
 
@@ -110,7 +134,10 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
 
             /* EOF/error */
             if (data->current_block >= data->info.blockCount) {
-                memset(outbuf, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
+                if (outbuf_f32)
+                    memset(outbuf_f32, 0, (samples_to_do - samples_done) * channels * sizeof(float));
+                else
+                    memset(outbuf, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
                 break;
             }
 
@@ -131,7 +158,7 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
             }
 
             /* extract samples */
-            clHCA_ReadSamples16(data->handle, data->sample_buffer);
+            clHCA_ReadSamplesFloat(data->handle, data->sample_buffer);
 
             data->samples_consumed = 0;
             data->samples_filled += data->info.samplesPerBlock;
@@ -139,6 +166,14 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
     }
 }
 
+void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
+    decode_hca_internal(data, outbuf, NULL, samples_to_do);
+}
+
+void decode_hca_f32(hca_codec_data* data, float* outbuf, int32_t samples_to_do) {
+    decode_hca_internal(data, NULL, outbuf, samples_to_do);
+}
+
 void reset_hca(hca_codec_data* data) {
     if (!data) return;
 
@@ -350,6 +350,18 @@ void clHCA_ReadSamples16(clHCA* hca, signed short *samples) {
     }
 }
 
+void clHCA_ReadSamplesFloat(clHCA* hca, float *samples) {
+    unsigned int i, j, k;
+
+    for (i = 0; i < HCA_SUBFRAMES; i++) {
+        for (j = 0; j < HCA_SAMPLES_PER_SUBFRAME; j++) {
+            for (k = 0; k < hca->channels; k++) {
+                *samples++ = hca->channel[k].wave[i][j];
+            }
+        }
+    }
+}
+
 
 //--------------------------------------------------
 // Allocation and creation
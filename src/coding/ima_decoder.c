@@ -35,7 +35,7 @@ static const int IMA_IndexTable[16] = {
 
 
 /* Original IMA expansion, using shift+ADDs to avoid MULs (slow back then) */
-static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble_byte(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
     /* simplified through math from:
@@ -44,7 +44,7 @@ static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
      *    > diff = (step * nibble / 4) + (step / 8)
      * final diff = [signed] (step / 8) + (step / 4) + (step / 2) + (step) [when code = 4+2+1] */
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf; /* ADPCM code */
+    sample_nibble = (byte >> nibble_shift)&0xf; /* ADPCM code */
     sample_decoded = *hist1; /* predictor value */
     step = ADPCMTable[*step_index]; /* current step */
 
@@ -61,6 +61,10 @@ static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
     if (*step_index > 88) *step_index=88;
 }
 
+static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+    std_ima_expand_nibble_byte(read_u8(byte_offset,stream->streamfile), nibble_shift, hist1, step_index);
+}
+
 /* Apple's IMA variation. Exactly the same except it uses 16b history (probably more sensitive to overflow/sign extend?) */
 static void std_ima_expand_nibble_16(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int16_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
@@ -347,6 +351,10 @@ static void cd_ima_expand_nibble(uint8_t byte, int shift, int32_t* hist1, int32_
  * Configurable: stereo or mono/interleave nibbles, and high or low nibble first.
  * For vgmstream, low nibble is called "IMA ADPCM" and high nibble is "DVI IMA ADPCM" (same thing though). */
 void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int is_stereo, int is_high_first) {
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block = NULL;
+    off_t block_offset = 0, last_offset;
+    size_t block_size = 0;
     int i, sample_count = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
@@ -357,6 +365,10 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
     if (step_index < 0) step_index=0;
     if (step_index > 88) step_index=88;
 
+    last_offset = is_stereo ?
+            stream->offset + (first_sample + samples_to_do - 1) :
+            stream->offset + (first_sample + samples_to_do - 1)/2;
+
     /* decode nibbles (layout: varies) */
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = is_stereo ?
@@ -366,7 +378,16 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
                 is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
                 is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        /* read all bytes needed at once (in chunks), rather than one by one */
+        if (byte_offset >= block_offset + block_size) {
+            block_offset = byte_offset;
+            block_size = last_offset + 1 - byte_offset;
+            if (block_size > sizeof(block_buf))
+                block_size = sizeof(block_buf);
+            block = peek_streamfile_pad(block_buf, block_offset, block_size, stream->streamfile); /* ignore EOF errors */
+        }
+
+        std_ima_expand_nibble_byte(block[byte_offset - block_offset], nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -564,6 +585,8 @@ void decode_blitz_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channels
  * so to simplify calcs this decodes full frames, thus hist doesn't need to be mantained.
  * Officially defined in "Microsoft Multimedia Standards Update" doc (RIFFNEW.pdf). */
 void decode_ms_ima(VGMSTREAM* vgmstream, VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
+    uint8_t frame_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* frame = NULL;
     int i, samples_read = 0, samples_done = 0, max_samples;
     int32_t hist1;// = stream->adpcm_history1_32;
     int step_index;// = stream->adpcm_step_index;
@@ -574,12 +597,20 @@ void decode_ms_ima(VGMSTREAM* vgmstream, VGMSTREAMCHANNEL* stream, sample_t* out
     int block_samples = ((vgmstream->frame_size - 0x04*frame_channels) * 2 / frame_channels) + 1;
     first_sample = first_sample % block_samples;
 
+    /* read the whole frame at once if possible (channel data is mixed), rather than byte by byte */
+    if (vgmstream->frame_size > 0 && vgmstream->frame_size <= sizeof(frame_buf))
+        frame = peek_streamfile_pad(frame_buf, stream->offset, vgmstream->frame_size, stream->streamfile); /* ignore EOF errors */
+
     /* normal header (hist+step+reserved), per channel */
     { //if (first_sample == 0) {
         off_t header_offset = stream->offset + 0x04*frame_channel;
 
-        hist1 =   read_s16le(header_offset+0x00,stream->streamfile);
-        step_index = read_u8(header_offset+0x02,stream->streamfile); /* 0x03: reserved */
+        hist1 = frame ?
+                get_s16le(frame + 0x04*frame_channel + 0x00) :
+                read_s16le(header_offset+0x00,stream->streamfile);
+        step_index = frame ?
+                get_u8(frame + 0x04*frame_channel + 0x02) :
+                read_u8(header_offset+0x02,stream->streamfile); /* 0x03: reserved */
         if (step_index < 0) step_index = 0;
         if (step_index > 88) step_index = 88;
 
@@ -600,7 +631,10 @@ void decode_ms_ima(VGMSTREAM* vgmstream, VGMSTREAMCHANNEL* stream, sample_t* out
         off_t byte_offset = stream->offset + 0x04*frame_channels + 0x04*frame_channel + 0x04*frame_channels*(i/8) + (i%8)/2;
         int nibble_shift = (i&1?4:0); /* low nibble first */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index); /* original expand */
+        if (frame) /* original expand */
+            std_ima_expand_nibble_byte(frame[byte_offset - stream->offset], nibble_shift, &hist1, &step_index);
+        else
+            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
 
         if (samples_read >= first_sample && samples_done < samples_to_do) {
             outbuf[samples_done * channelspacing] = (short)(hist1);
@@ -680,6 +714,8 @@ void decode_ref_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
 /* MS-IMA with fixed frame size, and outputs an even number of samples per frame (skips last nibble).
  * Defined in Xbox's SDK. Usable in mono or stereo modes (both suitable for interleaved multichannel). */
 void decode_xbox_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int is_stereo) {
+    uint8_t frame_buf[0x24*2];
+    const uint8_t* frame;
     int i, frames_in, sample_pos = 0, block_samples, frame_size;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
@@ -692,15 +728,16 @@ void decode_xbox_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
     frame_size = is_stereo ? 0x24*2 : 0x24;
 
     frame_offset = stream->offset + frame_size*frames_in;
+    frame = peek_streamfile_pad(frame_buf, frame_offset, frame_size, stream->streamfile); /* ignore EOF errors */
 
     /* normal header (hist+step+reserved), stereo/mono */
     if (first_sample == 0) {
         off_t header_offset = is_stereo ?
-                frame_offset + 0x04*(channel % 2) :
-                frame_offset + 0x00;
+                0x04*(channel % 2) :
+                0x00;
 
-        hist1   = read_16bitLE(header_offset+0x00,stream->streamfile);
-        step_index = read_8bit(header_offset+0x02,stream->streamfile);
+        hist1   = get_s16le(frame + header_offset+0x00);
+        step_index = get_s8(frame + header_offset+0x02);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
 
@@ -714,13 +751,13 @@ void decode_xbox_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
     /* decode nibbles (layout: straight in mono or 4 bytes per channel in stereo) */
     for (i = first_sample; i < first_sample + samples_to_do; i++) {
         off_t byte_offset = is_stereo ?
-                frame_offset + 0x04*2 + 0x04*(channel % 2) + 0x04*2*((i-1)/8) + ((i-1)%8)/2 :
-                frame_offset + 0x04   + (i-1)/2;
+                0x04*2 + 0x04*(channel % 2) + 0x04*2*((i-1)/8) + ((i-1)%8)/2 :
+                0x04   + (i-1)/2;
         int nibble_shift = (!((i-1)&1)   ? 0:4);   /* low first */
 
         /* must skip last nibble per spec, rarely needed though (ex. Gauntlet Dark Legacy) */
         if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble_byte(frame[byte_offset], nibble_shift, &hist1, &step_index);
             outbuf[sample_pos] = (short)(hist1);
             sample_pos += channelspacing;
         }
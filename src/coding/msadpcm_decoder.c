@@ -80,25 +80,14 @@ static int16_t msadpcm_adpcm_expand_nibble_div(VGMSTREAMCHANNEL* stream, uint8_t
 }
 
 
-void decode_msadpcm_stereo(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t first_sample, int32_t samples_to_do) {
+/* decodes one frame from memory (first_sample/samples_to_do within frame) */
+static void decode_msadpcm_stereo_frame(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame) {
     VGMSTREAMCHANNEL *stream1, *stream2;
-    uint8_t frame[MSADPCM_MAX_BLOCK_SIZE] = {0};
-    int i, frames_in;
-    size_t bytes_per_frame, samples_per_frame;
-    off_t frame_offset;
+    int i;
 
     stream1 = &vgmstream->ch[0];
     stream2 = &vgmstream->ch[1];
 
-    /* external interleave (variable size), stereo */
-    bytes_per_frame = vgmstream->frame_size;
-    samples_per_frame = (vgmstream->frame_size - 0x07*vgmstream->channels)*2 / vgmstream->channels + 2;
-    frames_in = first_sample / samples_per_frame;
-    first_sample = first_sample % samples_per_frame;
-
-    frame_offset = stream1->offset + frames_in * bytes_per_frame;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream1->streamfile); /* ignore EOF errors */
-
     /* parse frame header (ADPCMBLOCKHEADER) */
     if (first_sample == 0) {
         stream1->adpcm_coef[0] = msadpcm_coefs[get_u8(frame+0x00) & 0x07][0]; /* bPredictor[0] index > iCoef1 */
@@ -138,23 +127,10 @@ void decode_msadpcm_stereo(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t first
     }
 }
 
-void decode_msadpcm_mono(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int config) {
-    VGMSTREAMCHANNEL* stream = &vgmstream->ch[channel];
-    uint8_t frame[MSADPCM_MAX_BLOCK_SIZE] = {0};
-    int i, frames_in;
-    size_t bytes_per_frame, samples_per_frame;
-    off_t frame_offset;
+static void decode_msadpcm_mono_frame(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame, int config) {
+    int i;
     int is_shr = (config == 0);
 
-    /* external interleave (variable size), mono */
-    bytes_per_frame = vgmstream->frame_size;
-    samples_per_frame = (vgmstream->frame_size - 0x07)*2 + 2;
-    frames_in = first_sample / samples_per_frame;
-    first_sample = first_sample % samples_per_frame;
-
-    frame_offset = stream->offset + frames_in * bytes_per_frame;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
-
     /* parse frame header */
     if (first_sample == 0) {
         stream->adpcm_coef[0] = msadpcm_coefs[get_u8(frame+0x00) & 0x07][0];
@@ -192,21 +168,8 @@ void decode_msadpcm_mono(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspac
 
 /* Cricket Audio's MSADPCM, same thing with reversed hist and nibble order, reverse engineered from the exe.
  * (their tools may convert to float/others but internally it's all PCM16). */
-void decode_msadpcm_ck(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    VGMSTREAMCHANNEL* stream = &vgmstream->ch[channel];
-    uint8_t frame[MSADPCM_MAX_BLOCK_SIZE] = {0};
-    int i, frames_in;
-    size_t bytes_per_frame, samples_per_frame;
-    off_t frame_offset;
-
-    /* external interleave (variable size), mono */
-    bytes_per_frame = vgmstream->frame_size;
-    samples_per_frame = (vgmstream->frame_size - 0x07)*2 + 2;
-    frames_in = first_sample / samples_per_frame;
-    first_sample = first_sample % samples_per_frame;
-
-    frame_offset = stream->offset + frames_in * bytes_per_frame;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
+static void decode_msadpcm_ck_frame(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame) {
+    int i;
 
     /* parse frame header */
     if (first_sample == 0) {
@@ -241,6 +204,132 @@ void decode_msadpcm_ck(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspacin
     }
 }
 
+void decode_msadpcm_stereo(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t first_sample, int32_t samples_to_do) {
+    VGMSTREAMCHANNEL* stream1 = &vgmstream->ch[0];
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    int i, frames_in, frames_to_do, samples_frame;
+    int bytes_per_frame, samples_per_frame;
+    off_t frame_offset;
+
+    /* external interleave (variable size), stereo */
+    bytes_per_frame = vgmstream->frame_size;
+    samples_per_frame = (vgmstream->frame_size - 0x07*vgmstream->channels)*2 / vgmstream->channels + 2;
+    if (bytes_per_frame <= 0 || bytes_per_frame > sizeof(block_buf) || samples_per_frame <= 0) /* shouldn't happen */
+        return;
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream1->offset + frames_in * bytes_per_frame;
+
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        /* ignore EOF errors */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream1->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            decode_msadpcm_stereo_frame(vgmstream, outbuf, first_sample, samples_frame, block + i * bytes_per_frame);
+
+            outbuf += samples_frame * 2;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+void decode_msadpcm_mono(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int config) {
+    VGMSTREAMCHANNEL* stream = &vgmstream->ch[channel];
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    int i, frames_in, frames_to_do, samples_frame;
+    int bytes_per_frame, samples_per_frame;
+    off_t frame_offset;
+
+    /* external interleave (variable size), mono */
+    bytes_per_frame = vgmstream->frame_size;
+    samples_per_frame = (vgmstream->frame_size - 0x07)*2 + 2;
+    if (bytes_per_frame <= 0 || bytes_per_frame > sizeof(block_buf) || samples_per_frame <= 0) /* shouldn't happen */
+        return;
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream->offset + frames_in * bytes_per_frame;
+
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        /* ignore EOF errors */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            decode_msadpcm_mono_frame(stream, outbuf, channelspacing, first_sample, samples_frame, block + i * bytes_per_frame, config);
+
+            outbuf += samples_frame * channelspacing;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+void decode_msadpcm_ck(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
+    VGMSTREAMCHANNEL* stream = &vgmstream->ch[channel];
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    int i, frames_in, frames_to_do, samples_frame;
+    int bytes_per_frame, samples_per_frame;
+    off_t frame_offset;
+
+    /* external interleave (variable size), mono */
+    bytes_per_frame = vgmstream->frame_size;
+    samples_per_frame = (vgmstream->frame_size - 0x07)*2 + 2;
+    if (bytes_per_frame <= 0 || bytes_per_frame > sizeof(block_buf) || samples_per_frame <= 0) /* shouldn't happen */
+        return;
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream->offset + frames_in * bytes_per_frame;
+
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        /* ignore EOF errors */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            decode_msadpcm_ck_frame(stream, outbuf, channelspacing, first_sample, samples_frame, block + i * bytes_per_frame);
+
+            outbuf += samples_frame * channelspacing;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
 long msadpcm_bytes_to_samples(long bytes, int block_size, int channels) {
     if (block_size <= 0 || channels <= 0) return 0;
     return (bytes / block_size) * (block_size - (7-1)*channels) * 2 / channels
@@ -1,11 +1,11 @@
 #include "coding.h"
+#include "coding_utils_simd.h"
 #include "../util.h"
 
 
-void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    uint8_t frame[0x08] = {0};
-    off_t frame_offset;
-    int i, frames_in, sample_count = 0;
+/* decodes one frame from memory */
+static void decode_ngc_dsp_frame(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
+    int i, sample_count = 0;
     size_t bytes_per_frame, samples_per_frame;
     int coef_index, scale, coef1, coef2;
     int32_t hist1 = stream->adpcm_history1_16;
@@ -15,16 +15,14 @@ void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     /* external interleave (fixed size), mono */
     bytes_per_frame = 0x08;
     samples_per_frame = (bytes_per_frame - 0x01) * 2; /* always 14 */
-    frames_in = first_sample / samples_per_frame;
     first_sample = first_sample % samples_per_frame;
+    VGM_ASSERT_ONCE(first_sample + samples_to_do > samples_per_frame, "DSP: layout error, too many samples\n");
 
     /* parse frame header */
-    frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
     scale = 1 << ((frame[0] >> 0) & 0xf);
     coef_index  = (frame[0] >> 4) & 0xf;
 
-    VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs at %x\n", (uint32_t)frame_offset);
+    VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs\n");
     //if (coef_index > 8) //todo not correctly clamped in original decoder?
     //    coef_index = 8;
 
@@ -55,30 +53,57 @@ void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     stream->adpcm_history2_16 = hist2;
 }
 
-
-/* read from memory rather than a file */
-static void decode_ngc_dsp_subint_internal(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, uint8_t * frame) {
-    int i, sample_count = 0;
+void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    off_t frame_offset;
+    int i, frames_in, frames_to_do, samples_frame;
     size_t bytes_per_frame, samples_per_frame;
-    int coef_index, scale, coef1, coef2;
-    int32_t hist1 = stream->adpcm_history1_16;
-    int32_t hist2 = stream->adpcm_history2_16;
 
 
     /* external interleave (fixed size), mono */
     bytes_per_frame = 0x08;
     samples_per_frame = (bytes_per_frame - 0x01) * 2; /* always 14 */
+    frames_in = first_sample / samples_per_frame;
     first_sample = first_sample % samples_per_frame;
-    VGM_ASSERT_ONCE(samples_to_do > samples_per_frame, "DSP: layout error, too many samples\n");
+    frame_offset = stream->offset + bytes_per_frame * frames_in;
 
-    /* parse frame header */
-    scale = 1 << ((frame[0] >> 0) & 0xf);
-    coef_index  = (frame[0] >> 4) & 0xf;
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
 
-    VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs\n");
-    //if (coef_index > 8) //todo not correctly clamped in original decoder?
-    //    coef_index = 8;
+        /* ignore EOF errors (partial data) */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
 
+            decode_ngc_dsp_frame(stream, outbuf, channelspacing, first_sample, samples_frame, block + i * bytes_per_frame);
+
+            outbuf += samples_frame * channelspacing;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+/* same as decode_ngc_dsp_frame, but only updates history (no output) */
+static void skip_ngc_dsp_frame(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame) {
+    int i;
+    int coef_index, scale, coef1, coef2;
+    int32_t hist1 = stream->adpcm_history1_16;
+    int32_t hist2 = stream->adpcm_history2_16;
+
+    first_sample = first_sample % 14;
+
+    scale = 1 << ((frame[0] >> 0) & 0xf);
+    coef_index  = (frame[0] >> 4) & 0xf;
     coef1 = stream->adpcm_coef[coef_index*2 + 0];
     coef2 = stream->adpcm_coef[coef_index*2 + 1];
 
@@ -93,9 +118,6 @@ static void decode_ngc_dsp_subint_internal(VGMSTREAMCHANNEL * stream, sample_t *
         sample = (sample + 1024 + coef1*hist1 + coef2*hist2) >> 11;
         sample = clamp16(sample);
 
-        outbuf[sample_count] = sample;
-        sample_count += channelspacing;
-
         hist2 = hist1;
         hist1 = sample;
     }
@@ -104,6 +126,181 @@ static void decode_ngc_dsp_subint_internal(VGMSTREAMCHANNEL * stream, sample_t *
     stream->adpcm_history2_16 = hist2;
 }
 
+/* Advances history over samples_to_do samples without output, as if decoded (for skips). */
+void skip_ngc_dsp(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do) {
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    off_t frame_offset;
+    int i, frames_in, frames_to_do, samples_frame;
+    size_t bytes_per_frame, samples_per_frame;
+
+
+    bytes_per_frame = 0x08;
+    samples_per_frame = (bytes_per_frame - 0x01) * 2; /* always 14 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream->offset + bytes_per_frame * frames_in;
+
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            skip_ngc_dsp_frame(stream, first_sample, samples_frame, block + i * bytes_per_frame);
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+#ifdef VGM_SIMD_LANES
+
+/* decodes N channels in lockstep, one per vector lane, with the same int ops as decode_ngc_dsp_frame
+ * (bit-exact). Lanes over 'lanes' repeat the first channel and are discarded.
+ * Each lane's channel is written at outbuf + lane * ch_step (1 = interleaved, else planar). */
+static void decode_ngc_dsp_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int lanes, int32_t first_sample, int32_t samples_to_do) {
+    uint8_t block_buf[VGM_SIMD_LANES][DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block[VGM_SIMD_LANES];
+    int32_t nibbles_buf[14][VGM_SIMD_LANES];
+    int32_t lane_buf[VGM_SIMD_LANES];
+    sample_t sample_buf[VGM_SIMD_LANES];
+    simd_i32 hist1, hist2, coefs, sample;
+    const simd_i32 mask16 = simd_i32_set1(0xFFFF);
+    const simd_i32 round = simd_i32_set1(1024);
+    off_t frame_offset;
+    int i, l, f, frames_in, frames_to_do, samples_frame;
+    size_t bytes_per_frame, samples_per_frame;
+
+
+    bytes_per_frame = 0x08;
+    samples_per_frame = (bytes_per_frame - 0x01) * 2; /* always 14 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = bytes_per_frame * frames_in;
+
+    for (l = 0; l < VGM_SIMD_LANES; l++) {
+        lane_buf[l] = stream[l < lanes ? l : 0].adpcm_history1_16;
+    }
+    hist1 = simd_i32_load(lane_buf);
+    for (l = 0; l < VGM_SIMD_LANES; l++) {
+        lane_buf[l] = stream[l < lanes ? l : 0].adpcm_history2_16;
+    }
+    hist2 = simd_i32_load(lane_buf);
+
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > DECODE_BLOCK_BUFFER_SIZE / bytes_per_frame)
+            frames_to_do = DECODE_BLOCK_BUFFER_SIZE / bytes_per_frame;
+
+        /* channels may share a streamfile, so data is copied (ignore EOF errors) */
+        for (l = 0; l < lanes; l++) {
+            read_streamfile_pad(block_buf[l], stream[l].offset + frame_offset, frames_to_do * bytes_per_frame, stream[l].streamfile);
+            block[l] = block_buf[l];
+        }
+        for (l = lanes; l < VGM_SIMD_LANES; l++) {
+            block[l] = block_buf[0];
+        }
+
+        for (f = 0; f < frames_to_do; f++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            /* parse frame headers and expand nibbles per lane */
+            for (l = 0; l < VGM_SIMD_LANES; l++) {
+                VGMSTREAMCHANNEL* ch = &stream[l < lanes ? l : 0];
+                const uint8_t* frame = block[l] + f * bytes_per_frame;
+                int scale = 1 << ((frame[0] >> 0) & 0xf);
+                int coef_index = (frame[0] >> 4) & 0xf;
+
+                VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs\n");
+
+                /* coef1/coef2 as int16 pairs, to match hist1/hist2 pairs in madd */
+                lane_buf[l] = (int32_t)((uint16_t)ch->adpcm_coef[coef_index*2 + 0] | ((uint32_t)(uint16_t)ch->adpcm_coef[coef_index*2 + 1] << 16));
+
+                for (i = first_sample; i < first_sample + samples_frame; i++) {
+                    uint8_t nibbles = frame[0x01 + i/2];
+                    int32_t nibble = i&1 ? /* high nibble first */
+                            get_low_nibble_signed(nibbles) :
+                            get_high_nibble_signed(nibbles);
+                    nibbles_buf[i][l] = ((nibble * scale) << 11);
+                }
+            }
+            coefs = simd_i32_load(lane_buf);
+
+            for (i = first_sample; i < first_sample + samples_frame; i++) {
+                simd_i32 hists = simd_i32_or(simd_i32_and(hist1, mask16), simd_i32_slli(hist2, 16));
+
+                sample = simd_i32_load(nibbles_buf[i]);
+                sample = simd_i32_add(simd_i32_add(sample, round), simd_i32_madd16(hists, coefs));
+                sample = simd_i32_srai(sample, 11);
+                sample = simd_i32_clamp16(sample);
+
+                if (lanes == VGM_SIMD_LANES && ch_step == 1) {
+                    simd_i32_store16(outbuf, sample);
+                }
+                else {
+                    simd_i32_store16(sample_buf, sample);
+                    for (l = 0; l < lanes; l++) {
+                        outbuf[l * ch_step] = sample_buf[l];
+                    }
+                }
+                outbuf += channelspacing;
+
+                hist2 = hist1;
+                hist1 = sample;
+            }
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+
+    simd_i32_store(lane_buf, hist1);
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history1_16 = lane_buf[l];
+    }
+    simd_i32_store(lane_buf, hist2);
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history2_16 = lane_buf[l];
+    }
+}
+#endif
+
+/* decodes several channels at once when possible (same output as decode_ngc_dsp), returns channels done.
+ * Channel N is written at outbuf + N * ch_step (1 = interleaved, else planar). */
+int decode_ngc_dsp_multi(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int channels, int32_t first_sample, int32_t samples_to_do) {
+#ifdef VGM_SIMD_LANES
+    int ch = 0;
+
+    /* scalar DSP is cheap enough that a few lanes aren't worth the setup */
+    while (channels - ch >= 4) {
+        int lanes = channels - ch;
+        if (lanes > VGM_SIMD_LANES)
+            lanes = VGM_SIMD_LANES;
+
+        decode_ngc_dsp_lanes(stream + ch, outbuf + ch * ch_step, channelspacing, ch_step, lanes, first_sample, samples_to_do);
+        ch += lanes;
+    }
+    return ch;
+#else
+    return 0;
+#endif
+}
+
+
 /* decode DSP with byte-interleaved frames (ex. 0x08: 1122112211221122) */
 void decode_ngc_dsp_subint(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int interleave) {
     uint8_t frame[0x08];
@@ -120,7 +317,7 @@ void decode_ngc_dsp_subint(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int cha
                 + interleave * channel, stream->streamfile);
     }
 
-    decode_ngc_dsp_subint_internal(stream, outbuf, channelspacing, first_sample, samples_to_do, frame);
+    decode_ngc_dsp_frame(stream, outbuf, channelspacing, first_sample, samples_to_do, frame);
 }
 
 
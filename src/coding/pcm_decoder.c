@@ -1,5 +1,8 @@
 #include "coding.h"
+#include "coding_utils_simd.h"
 #include "../util.h"
+#include "../util/samples_ops.h"
+#include <float.h>
 #include <math.h>
 
 void decode_pcm16le(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
@@ -238,6 +241,252 @@ void decode_pcm24le(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspaci
     }
 }
 
+/* ************************************************************************* */
+/* PCM frames: some layouts read all channels at consecutive offsets (frame interleave, or _int codecs),
+ * and as output is also interleaved N frames can be converted for all channels in one pass from memory */
+
+static void convert_pcm16(sample_t* outbuf, const uint8_t* buf, int count, int big_endian) {
+    int i = 0;
+
+#ifdef VGM_SIMD_SSE2 /* x86 = little endian */
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(buf + i*2));
+        if (big_endian)
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(outbuf + i), v);
+    }
+#endif
+    for (; i < count; i++) {
+        outbuf[i] = big_endian ? get_s16be(buf + i*2) : get_s16le(buf + i*2);
+    }
+}
+
+static void convert_pcm8(sample_t* outbuf, const uint8_t* buf, int count, int is_unsigned) {
+    int i = 0;
+
+#ifdef VGM_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sign = _mm_set1_epi8(is_unsigned ? (char)0x80 : 0x00);
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(buf + i)), sign);
+        /* byte to upper byte = *0x100 */
+        _mm_storeu_si128((__m128i*)(outbuf + i + 0), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i*)(outbuf + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+#endif
+    for (; i < count; i++) {
+        outbuf[i] = is_unsigned ?
+                buf[i]*0x100 - 0x8000 :
+                (int8_t)buf[i]*0x100;
+    }
+}
+
+static void convert_pcm24(sample_t* outbuf, const uint8_t* buf, int count, int big_endian) {
+    int i;
+
+    /* same as (v >> 8) of the 24-bit value */
+    for (i = 0; i < count; i++) {
+        outbuf[i] = big_endian ? get_s16be(buf + i*3 + 0x00) : get_s16le(buf + i*3 + 0x01);
+    }
+}
+
+static void convert_ulaw(sample_t* outbuf, const uint8_t* buf, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        outbuf[i] = expand_ulaw(buf[i]);
+    }
+}
+
+static void convert_alaw(sample_t* outbuf, const uint8_t* buf, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        outbuf[i] = expand_alaw(buf[i]);
+    }
+}
+
+static void convert_pcmfloat(sample_t* outbuf, const uint8_t* buf, int count, int big_endian) {
+    int i = 0;
+
+    /* same float ops and rounding as decode_pcmfloat (including x86's out-of-range/NaN conversions) */
+#if defined(VGM_SIMD_SSE2) && defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0 && !defined(__FMA__)
+    const __m128 scale = _mm_set1_ps(32767.f);
+    const __m128 half = _mm_set1_ps(.5f);
+    const __m128i invalid = _mm_set1_epi32(INT32_MIN);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(buf + i*4 + 0x00));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(buf + i*4 + 0x10));
+        __m128i s0, s1;
+
+        if (big_endian) {
+            v0 = _mm_or_si128(_mm_slli_epi16(v0, 8), _mm_srli_epi16(v0, 8));
+            v0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v0, 0xB1), 0xB1);
+            v1 = _mm_or_si128(_mm_slli_epi16(v1, 8), _mm_srli_epi16(v1, 8));
+            v1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v1, 0xB1), 0xB1);
+        }
+
+        /* floor = truncate, then -1 if truncated went up (negatives), unless conversion was invalid */
+        {
+            __m128 f = _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(v0), scale), half);
+            __m128i t = _mm_cvttps_epi32(f);
+            __m128i fix = _mm_castps_si128(_mm_cmplt_ps(f, _mm_cvtepi32_ps(t)));
+            fix = _mm_andnot_si128(_mm_cmpeq_epi32(t, invalid), fix);
+            s0 = _mm_add_epi32(t, fix);
+        }
+        {
+            __m128 f = _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(v1), scale), half);
+            __m128i t = _mm_cvttps_epi32(f);
+            __m128i fix = _mm_castps_si128(_mm_cmplt_ps(f, _mm_cvtepi32_ps(t)));
+            fix = _mm_andnot_si128(_mm_cmpeq_epi32(t, invalid), fix);
+            s1 = _mm_add_epi32(t, fix);
+        }
+
+        _mm_storeu_si128((__m128i*)(outbuf + i), _mm_packs_epi32(s0, s1)); /* clamp16 */
+    }
+#endif
+    for (; i < count; i++) {
+        float sample_float = big_endian ? get_f32be(buf + i*4) : get_f32le(buf + i*4);
+        int sample_pcm = (int)floor(sample_float * 32767.f + .5f);
+
+        outbuf[i] = clamp16(sample_pcm);
+    }
+}
+
+/* returns bytes per sample if frames can be converted for all channels at once, 0 otherwise */
+int pcm_get_frame_sample_size(VGMSTREAM* vgmstream) {
+    int ch, sample_size, is_int = 0;
+
+    switch(vgmstream->coding_type) {
+        case coding_PCM16_int:
+            is_int = 1;
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+            sample_size = 0x02;
+            break;
+        case coding_PCM8_int:
+        case coding_PCM8_U_int:
+        case coding_ULAW_int:
+            is_int = 1;
+        case coding_PCM8:
+        case coding_PCM8_U:
+        case coding_ULAW:
+        case coding_ALAW:
+            sample_size = 0x01;
+            break;
+        case coding_PCM24LE:
+        case coding_PCM24BE:
+            sample_size = 0x03;
+            break;
+        case coding_PCMFLOAT:
+            sample_size = 0x04;
+            break;
+        default:
+            return 0;
+    }
+
+    /* non-int decoders read each channel from its offset, so multichannel only works with frame interleave
+     * (mono reads the same in any layout) */
+    if (vgmstream->channels > 1 && !is_int) {
+        if (vgmstream->layout_type != layout_interleave)
+            return 0;
+        if (vgmstream->interleave_block_size != sample_size ||
+                vgmstream->interleave_first_block_size || vgmstream->interleave_last_block_size)
+            return 0;
+    }
+
+    if (sample_size * vgmstream->channels > DECODE_BLOCK_BUFFER_SIZE)
+        return 0;
+
+    for (ch = 1; ch < vgmstream->channels; ch++) {
+        if (vgmstream->ch[ch].streamfile != vgmstream->ch[0].streamfile ||
+                vgmstream->ch[ch].offset != vgmstream->ch[0].offset + ch * sample_size)
+            return 0;
+    }
+
+    return sample_size;
+}
+
+/* converts N frames (all channels) if possible, returns 0 if not so per-channel decoders must be used.
+ * Channel N is written at outbuf + N * ch_step (1 = interleaved, else planar). */
+int decode_pcm_frames(VGMSTREAM* vgmstream, sample_t* outbuf, int ch_step, int32_t first_sample, int32_t samples_to_do) {
+    uint8_t buf[DECODE_BLOCK_BUFFER_SIZE];
+    sample_t planar_buf[DECODE_BLOCK_BUFFER_SIZE];
+    sample_t* convbuf;
+    VGMSTREAMCHANNEL* stream = &vgmstream->ch[0];
+    int channels = vgmstream->channels;
+    int sample_size, frames_to_do, count;
+    size_t frame_size, bytes, bytes_done;
+    off_t offset;
+
+
+    sample_size = pcm_get_frame_sample_size(vgmstream);
+    if (!sample_size)
+        return 0;
+
+    frame_size = sample_size * channels;
+    offset = stream->offset + (off_t)first_sample * frame_size;
+
+    while (samples_to_do > 0) {
+        frames_to_do = sizeof(buf) / frame_size;
+        if (frames_to_do > samples_to_do)
+            frames_to_do = samples_to_do;
+        bytes = frames_to_do * frame_size;
+        count = frames_to_do * channels;
+
+        bytes_done = read_streamfile(buf, offset, bytes, stream->streamfile);
+        if (bytes_done < bytes) {
+            /* mimic per-sample readers, that return -1 on EOF (PCM24BE only reads the first 2 bytes) */
+            if (!(vgmstream->coding_type == coding_PCM24BE && bytes_done % sample_size == 0x02))
+                bytes_done -= bytes_done % sample_size;
+            if (vgmstream->coding_type == coding_PCMFLOAT) {
+                for (; bytes_done < bytes; bytes_done += 0x04) {
+                    if (vgmstream->codec_endian)
+                        put_u32be(buf + bytes_done, 0xBF800000); /* -1.0f */
+                    else
+                        put_u32le(buf + bytes_done, 0xBF800000);
+                }
+            }
+            else {
+                memset(buf + bytes_done, 0xFF, bytes - bytes_done);
+            }
+        }
+
+        /* planar output is converted interleaved first, then split (count always fits) */
+        convbuf = (ch_step == 1) ? outbuf : planar_buf;
+
+        switch(vgmstream->coding_type) {
+            case coding_PCM16LE:    convert_pcm16(convbuf, buf, count, 0); break;
+            case coding_PCM16BE:    convert_pcm16(convbuf, buf, count, 1); break;
+            case coding_PCM16_int:  convert_pcm16(convbuf, buf, count, vgmstream->codec_endian); break;
+            case coding_PCM8:
+            case coding_PCM8_int:   convert_pcm8(convbuf, buf, count, 0); break;
+            case coding_PCM8_U:
+            case coding_PCM8_U_int: convert_pcm8(convbuf, buf, count, 1); break;
+            case coding_PCM24LE:    convert_pcm24(convbuf, buf, count, 0); break;
+            case coding_PCM24BE:    convert_pcm24(convbuf, buf, count, 1); break;
+            case coding_ULAW:
+            case coding_ULAW_int:   convert_ulaw(convbuf, buf, count); break;
+            case coding_ALAW:       convert_alaw(convbuf, buf, count); break;
+            case coding_PCMFLOAT:   convert_pcmfloat(convbuf, buf, count, vgmstream->codec_endian); break;
+            default: break;
+        }
+
+        if (ch_step == 1) {
+            outbuf += count;
+        }
+        else {
+            deinterleave_samples(outbuf, planar_buf, channels, ch_step, frames_to_do);
+            outbuf += frames_to_do;
+        }
+        offset += bytes;
+        samples_to_do -= frames_to_do;
+    }
+
+    return 1;
+}
+
+
 int32_t pcm_bytes_to_samples(size_t bytes, int channels, int bits_per_sample) {
     if (channels <= 0 || bits_per_sample <= 0) return 0;
     return ((int64_t)bytes * 8) / channels / bits_per_sample;
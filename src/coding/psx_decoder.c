@@ -1,4 +1,6 @@
+#include <float.h>
 #include "coding.h"
+#include "coding_utils_simd.h"
 
 
 /* PS-ADPCM table, defined as rational numbers (as in the spec) */
@@ -54,27 +56,15 @@ static const int ps_adpcm_coefs_i[5][2] = {
  * depend on platform, PS3 games use floats, etc). There are rounding diffs between implementations.
  */
 
-/* standard PS-ADPCM (float math version) */
-void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config) {
-    uint8_t frame[0x10] = {0};
-    off_t frame_offset;
-    int i, frames_in, sample_count = 0;
-    size_t bytes_per_frame, samples_per_frame;
+/* standard PS-ADPCM (float math version), decodes one frame from memory */
+static void decode_psx_frame(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame, off_t frame_offset, int is_badflags, int extended_mode) {
+    int i, sample_count = 0;
     uint8_t coef_index, shift_factor, flag;
     int32_t hist1 = stream->adpcm_history1_32;
     int32_t hist2 = stream->adpcm_history2_32;
-    int extended_mode = (config == 1);
 
 
-    /* external interleave (fixed size), mono */
-    bytes_per_frame = 0x10;
-    samples_per_frame = (bytes_per_frame - 0x02) * 2; /* always 28 */
-    frames_in = first_sample / samples_per_frame;
-    first_sample = first_sample % samples_per_frame;
-
     /* parse frame header */
-    frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
     coef_index   = (frame[0] >> 4) & 0xf;
     shift_factor = (frame[0] >> 0) & 0xf;
     flag = frame[1]; /* only lower nibble needed */
@@ -119,13 +109,296 @@ void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
     stream->adpcm_history2_32 = hist2;
 }
 
+void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config) {
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    off_t frame_offset;
+    int i, frames_in, frames_to_do, samples_frame;
+    size_t bytes_per_frame, samples_per_frame;
+    int extended_mode = (config == 1);
+
+
+    /* external interleave (fixed size), mono */
+    bytes_per_frame = 0x10;
+    samples_per_frame = (bytes_per_frame - 0x02) * 2; /* always 28 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream->offset + bytes_per_frame * frames_in;
+
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        /* ignore EOF errors (partial data) */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            decode_psx_frame(stream, outbuf, channelspacing, first_sample, samples_frame,
+                    block + i * bytes_per_frame, frame_offset + i * bytes_per_frame, is_badflags, extended_mode);
+
+            outbuf += samples_frame * channelspacing;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+/* same as decode_psx_frame, but only updates history (no output) */
+static void skip_psx_frame(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, const uint8_t* frame, int is_badflags, int extended_mode) {
+    int i;
+    uint8_t coef_index, shift_factor, flag;
+    int32_t hist1 = stream->adpcm_history1_32;
+    int32_t hist2 = stream->adpcm_history2_32;
+
+    coef_index   = (frame[0] >> 4) & 0xf;
+    shift_factor = (frame[0] >> 0) & 0xf;
+    flag = frame[1];
+
+    if (!extended_mode) {
+        if (coef_index > 5)
+            coef_index = 0;
+        if (shift_factor > 12)
+            shift_factor = 9;
+    }
+
+    if (is_badflags)
+        flag = 0;
+
+    shift_factor = 20 - shift_factor;
+    for (i = first_sample; i < first_sample + samples_to_do; i++) {
+        int32_t sample = 0;
+
+        if (flag < 0x07) {
+            uint8_t nibbles = frame[0x02 + i/2];
+
+            sample = (i&1 ?
+                    get_high_nibble_signed(nibbles):
+                    get_low_nibble_signed(nibbles)) << shift_factor;
+            sample = sample + (int32_t)((ps_adpcm_coefs_f[coef_index][0]*hist1 + ps_adpcm_coefs_f[coef_index][1]*hist2) * 256.0f);
+            sample >>= 8;
+        }
+
+        hist2 = hist1;
+        hist1 = sample;
+    }
+
+    stream->adpcm_history1_32 = hist1;
+    stream->adpcm_history2_32 = hist2;
+}
+
+/* Advances history over samples_to_do samples without output, as if decoded (for skips). */
+void skip_psx(VGMSTREAMCHANNEL* stream, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config) {
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    off_t frame_offset;
+    int i, frames_in, frames_to_do, samples_frame;
+    size_t bytes_per_frame, samples_per_frame;
+    int extended_mode = (config == 1);
+
+
+    bytes_per_frame = 0x10;
+    samples_per_frame = (bytes_per_frame - 0x02) * 2; /* always 28 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = stream->offset + bytes_per_frame * frames_in;
+
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, stream->streamfile);
+
+        for (i = 0; i < frames_to_do; i++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            skip_psx_frame(stream, first_sample, samples_frame, block + i * bytes_per_frame, is_badflags, extended_mode);
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+}
+
+/* float lanes must round like the scalar code, so not with x87 extended precision or contracted multiply-adds */
+#if defined(VGM_SIMD_LANES) && defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0 && !defined(__FMA__)
+#define PSX_SIMD_LANES VGM_SIMD_LANES
+
+/* decodes N channels in lockstep, one per vector lane, with the same float ops as decode_psx_frame
+ * (bit-exact). Lanes over 'lanes' repeat the first channel and are discarded.
+ * Each lane's channel is written at outbuf + lane * ch_step (1 = interleaved, else planar). */
+static void decode_psx_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int lanes, int32_t first_sample, int32_t samples_to_do, int is_badflags, int extended_mode) {
+    uint8_t block_buf[PSX_SIMD_LANES][DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block[PSX_SIMD_LANES];
+    int32_t nibbles_buf[28][PSX_SIMD_LANES];
+    int32_t lane_buf[PSX_SIMD_LANES];
+    float coef1_buf[PSX_SIMD_LANES], coef2_buf[PSX_SIMD_LANES];
+    sample_t sample_buf[PSX_SIMD_LANES];
+    simd_i32 hist1, hist2, mask, sample;
+    simd_f32 coef1, coef2, predicted;
+    const simd_f32 scale = simd_f32_set1(256.0f);
+    off_t frame_offset;
+    int i, l, f, frames_in, frames_to_do, samples_frame;
+    size_t bytes_per_frame, samples_per_frame;
+
+
+    bytes_per_frame = 0x10;
+    samples_per_frame = (bytes_per_frame - 0x02) * 2; /* always 28 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+    frame_offset = bytes_per_frame * frames_in;
+
+    for (l = 0; l < PSX_SIMD_LANES; l++) {
+        lane_buf[l] = stream[l < lanes ? l : 0].adpcm_history1_32;
+    }
+    hist1 = simd_i32_load(lane_buf);
+    for (l = 0; l < PSX_SIMD_LANES; l++) {
+        lane_buf[l] = stream[l < lanes ? l : 0].adpcm_history2_32;
+    }
+    hist2 = simd_i32_load(lane_buf);
+
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > DECODE_BLOCK_BUFFER_SIZE / bytes_per_frame)
+            frames_to_do = DECODE_BLOCK_BUFFER_SIZE / bytes_per_frame;
+
+        /* channels may share a streamfile, so data is copied (ignore EOF errors) */
+        for (l = 0; l < lanes; l++) {
+            read_streamfile_pad(block_buf[l], stream[l].offset + frame_offset, frames_to_do * bytes_per_frame, stream[l].streamfile);
+            block[l] = block_buf[l];
+        }
+        for (l = lanes; l < PSX_SIMD_LANES; l++) {
+            block[l] = block_buf[0];
+        }
+
+        for (f = 0; f < frames_to_do; f++) {
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            /* parse frame headers and expand nibbles per lane */
+            for (l = 0; l < PSX_SIMD_LANES; l++) {
+                const uint8_t* frame = block[l] + f * bytes_per_frame;
+                uint8_t coef_index   = (frame[0] >> 4) & 0xf;
+                uint8_t shift_factor = (frame[0] >> 0) & 0xf;
+                uint8_t flag = frame[1]; /* only lower nibble needed */
+
+                if (!extended_mode) {
+                    VGM_ASSERT_ONCE(coef_index > 5 || shift_factor > 12, "PS-ADPCM: incorrect coefs/shift at %x\n",
+                            (uint32_t)(stream[l < lanes ? l : 0].offset + frame_offset + f * bytes_per_frame));
+                    if (coef_index > 5)
+                        coef_index = 0;
+                    if (shift_factor > 12)
+                        shift_factor = 9;
+                }
+
+                if (is_badflags)
+                    flag = 0;
+                VGM_ASSERT_ONCE(flag > 7,"PS-ADPCM: unknown flag at %x\n",
+                        (uint32_t)(stream[l < lanes ? l : 0].offset + frame_offset + f * bytes_per_frame));
+
+                shift_factor = 20 - shift_factor;
+                coef1_buf[l] = ps_adpcm_coefs_f[coef_index][0];
+                coef2_buf[l] = ps_adpcm_coefs_f[coef_index][1];
+                lane_buf[l] = flag < 0x07 ? -1 : 0; /* with flag 0x07 decoded sample must be 0 */
+
+                for (i = first_sample; i < first_sample + samples_frame; i++) {
+                    uint8_t nibbles = frame[0x02 + i/2];
+                    int32_t nibble = i&1 ? /* low nibble first */
+                            get_high_nibble_signed(nibbles):
+                            get_low_nibble_signed(nibbles);
+                    nibbles_buf[i][l] = nibble << shift_factor;
+                }
+            }
+            coef1 = simd_f32_load(coef1_buf);
+            coef2 = simd_f32_load(coef2_buf);
+            mask = simd_i32_load(lane_buf);
+
+            for (i = first_sample; i < first_sample + samples_frame; i++) {
+                predicted = simd_f32_add(
+                        simd_f32_mul(coef1, simd_f32_from_i32(hist1)),
+                        simd_f32_mul(coef2, simd_f32_from_i32(hist2)));
+                predicted = simd_f32_mul(predicted, scale);
+
+                sample = simd_i32_load(nibbles_buf[i]);
+                sample = simd_i32_add(sample, simd_i32_from_f32(predicted));
+                sample = simd_i32_srai(sample, 8);
+                sample = simd_i32_and(sample, mask);
+
+                if (lanes == PSX_SIMD_LANES && ch_step == 1) {
+                    simd_i32_store16(outbuf, simd_i32_clamp16(sample));
+                }
+                else {
+                    simd_i32_store16(sample_buf, simd_i32_clamp16(sample));
+                    for (l = 0; l < lanes; l++) {
+                        outbuf[l * ch_step] = sample_buf[l];
+                    }
+                }
+                outbuf += channelspacing;
+
+                hist2 = hist1;
+                hist1 = sample;
+            }
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
+
+        frame_offset += frames_to_do * bytes_per_frame;
+    }
+
+    simd_i32_store(lane_buf, hist1);
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history1_32 = lane_buf[l];
+    }
+    simd_i32_store(lane_buf, hist2);
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history2_32 = lane_buf[l];
+    }
+}
+#endif
+
+/* decodes several channels at once when possible (same output as decode_psx), returns channels done.
+ * Channel N is written at outbuf + N * ch_step (1 = interleaved, else planar). */
+int decode_psx_multi(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int ch_step, int channels, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config) {
+#ifdef PSX_SIMD_LANES
+    int ch = 0;
+    int extended_mode = (config == 1);
+
+    while (channels - ch >= 2) {
+        int lanes = channels - ch;
+        if (lanes > PSX_SIMD_LANES)
+            lanes = PSX_SIMD_LANES;
+
+        decode_psx_lanes(stream + ch, outbuf + ch * ch_step, channelspacing, ch_step, lanes, first_sample, samples_to_do, is_badflags, extended_mode);
+        ch += lanes;
+    }
+    return ch;
+#else
+    return 0;
+#endif
+}
+
 
 /* PS-ADPCM with configurable frame size and no flag (int math version).
  * Found in some PC/PS3 games (FF XI in sizes 0x3/0x5/0x9/0x41, Afrika in size 0x4, Blur/James Bond in size 0x33, etc).
  *
  * Uses int/float math depending on config (PC/other code may be int, PS3 float). */
 void decode_psx_configurable(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size, int config) {
-    uint8_t frame[0x50] = {0};
+    uint8_t frame_buf[0x50] = {0};
+    const uint8_t* frame;
     off_t frame_offset;
     int i, frames_in, sample_count = 0;
     size_t bytes_per_frame, samples_per_frame;
@@ -144,7 +417,8 @@ void decode_psx_configurable(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int cha
 
     /* parse frame header */
     frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
+    frame = peek_streamfile(frame_buf, frame_offset, bytes_per_frame, stream->streamfile);
+    if (!frame) frame = frame_buf; /* ignore EOF errors (partial data) */
     coef_index   = (frame[0] >> 4) & 0xf;
     shift_factor = (frame[0] >> 0) & 0xf;
 
@@ -185,7 +459,8 @@ void decode_psx_configurable(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int cha
 
 /* PS-ADPCM from Pivotal games, exactly like psx_cfg but with float math (reverse engineered from the exe) */
 void decode_psx_pivotal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size) {
-    uint8_t frame[0x50] = {0};
+    uint8_t frame_buf[0x50] = {0};
+    const uint8_t* frame;
     off_t frame_offset;
     int i, frames_in, sample_count = 0;
     size_t bytes_per_frame, samples_per_frame;
@@ -202,7 +477,8 @@ void decode_psx_pivotal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channels
 
     /* parse frame header */
     frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
+    frame = peek_streamfile(frame_buf, frame_offset, bytes_per_frame, stream->streamfile);
+    if (!frame) frame = frame_buf; /* ignore EOF errors (partial data) */
     coef_index   = (frame[0] >> 4) & 0xf;
     shift_factor = (frame[0] >> 0) & 0xf;
 
@@ -41,7 +41,7 @@ static const int16_t EA_TABLE[16][2] = {
  * See end for accuracy information and layout info. */
 
 typedef struct {
-    uint8_t frame[0x80];
+    const uint8_t* frame;
     int16_t* sbuf;
     int channels;
     int32_t hist1;
@@ -152,8 +152,10 @@ void decode_xa(VGMSTREAM* v, sample_t* outbuf, int32_t samples_to_do) {
     uint32_t offset = v->ch[0].offset; /* L/R share offsets */
     STREAMFILE* sf = v->ch[0].streamfile;
 
-    int ch;
-    int frames_in, bytes, samples_per_frame;
+    uint8_t block_buf[DECODE_BLOCK_BUFFER_SIZE];
+    const uint8_t* block;
+    int ch, f;
+    int frames_in, frames_to_do, samples_per_frame, samples_frame;
     uint32_t frame_offset, bytes_per_frame;
     int32_t first_sample = v->samples_into_block;
     xa_t xa;
@@ -164,33 +166,52 @@ void decode_xa(VGMSTREAM* v, sample_t* outbuf, int32_t samples_to_do) {
     xa.subframes = (xa.is_xa8) ? 4 : 8;
 
     /* external interleave (fixed size), mono/stereo */
-    bytes_per_frame = sizeof(xa.frame);
+    bytes_per_frame = 0x80;
     samples_per_frame = 28 * xa.subframes / v->channels;
     frames_in = first_sample / samples_per_frame;
     first_sample = first_sample % samples_per_frame;
-
-    /* parse frame header */
     frame_offset = offset + bytes_per_frame * frames_in;
-    bytes = read_streamfile(xa.frame, frame_offset, bytes_per_frame, sf);
-    if (bytes != sizeof(xa.frame)) /* ignore EOF errors */
-        memset(xa.frame + bytes, 0, bytes_per_frame - bytes);
 
-    /* headers should repeat in pairs, except in EA's modified XA */
-    VGM_ASSERT_ONCE(!xa.is_ea &&
-            (get_u32be(xa.frame+0x0) != get_u32be(xa.frame+0x4) || get_u32be(xa.frame+0x8) != get_u32be(xa.frame+0xC)),
-            "bad frames at %x\n", frame_offset);
+    /* may be called with N frames: read as many as possible at once, then decode from memory */
+    while (samples_to_do > 0) {
+        frames_to_do = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_to_do > sizeof(block_buf) / bytes_per_frame)
+            frames_to_do = sizeof(block_buf) / bytes_per_frame;
+
+        /* ignore EOF errors */
+        block = peek_streamfile_pad(block_buf, frame_offset, frames_to_do * bytes_per_frame, sf);
+
+        for (f = 0; f < frames_to_do; f++) {
+            xa.frame = block + f * bytes_per_frame;
+
+            samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            /* headers should repeat in pairs, except in EA's modified XA */
+            VGM_ASSERT_ONCE(!xa.is_ea &&
+                    (get_u32be(xa.frame+0x0) != get_u32be(xa.frame+0x4) || get_u32be(xa.frame+0x8) != get_u32be(xa.frame+0xC)),
+                    "bad frames at %x\n", frame_offset + f * bytes_per_frame);
 
-    for (ch = 0; ch < xa.channels; ch++) {
-        VGMSTREAMCHANNEL* stream = &v->ch[ch];
+            for (ch = 0; ch < xa.channels; ch++) {
+                VGMSTREAMCHANNEL* stream = &v->ch[ch];
 
-        xa.sbuf = outbuf+ch;
-        xa.hist1 = stream->adpcm_history1_32;
-        xa.hist2 = stream->adpcm_history2_32;
+                xa.sbuf = outbuf+ch;
+                xa.hist1 = stream->adpcm_history1_32;
+                xa.hist2 = stream->adpcm_history2_32;
 
-        decode_xa_frame(&xa, first_sample, samples_to_do, ch);
+                decode_xa_frame(&xa, first_sample, samples_frame, ch);
+
+                stream->adpcm_history1_32 = xa.hist1;
+                stream->adpcm_history2_32 = xa.hist2;
+            }
+
+            outbuf += samples_frame * v->channels;
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+        }
 
-        stream->adpcm_history1_32 = xa.hist1;
-        stream->adpcm_history2_32 = xa.hist2;
+        frame_offset += frames_to_do * bytes_per_frame;
     }
 }
 
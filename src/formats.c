@@ -1475,6 +1475,8 @@ static const char* get_layout_name(layout_t layout_type) {
 static int has_sublayouts(VGMSTREAM** vgmstreams, int count) {
     int i;
     for (i = 0; i < count; i++) {
+        if (!vgmstreams[i]) /* closed deferred segment */
+            continue;
         if (vgmstreams[i]->layout_type == layout_segmented || vgmstreams[i]->layout_type == layout_layered)
             return 1;
     }
@@ -1523,6 +1525,8 @@ static int get_layout_mixed_description(VGMSTREAM* vgmstream, char* dst, int dst
     }
 
     for (i = 0; i < count; i++) {
+        if (!vgmstreams[i])
+            continue;
         done += get_layout_mixed_description(vgmstreams[i], dst + done, dst_size - done);
     }
 
@@ -9,10 +9,11 @@
  * when a block is decoded, and those must parse the new block and move offsets accordingly. */
 void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream) {
     int samples_written = 0;
-    int frame_size, samples_per_frame, samples_this_block;
+    int frame_size, samples_per_frame, samples_this_block, frames_per_call;
 
     frame_size = decode_get_frame_size(vgmstream);
     samples_per_frame = decode_get_samples_per_frame(vgmstream);
+    frames_per_call = decode_get_frames_per_call(vgmstream);
     samples_this_block = 0;
 
     if (vgmstream->current_block_samples) {
@@ -43,18 +44,18 @@ void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM*
         if (samples_this_block < 0) {
             /* probably block bug or EOF, next calcs would give wrong values/segfaults/infinite loop */
             VGM_LOG("layout_blocked: wrong block samples at 0x%x\n", (uint32_t)vgmstream->current_block_offset);
-            memset(buffer + samples_written*vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+            decode_silence(vgmstream, samples_written, sample_count - samples_written, buffer);
             break;
         }
 
         if (vgmstream->current_block_offset < 0 || vgmstream->current_block_offset == 0xFFFFFFFF) {
             /* probably block bug or EOF, block functions won't be able to read anything useful/infinite loop */
             VGM_LOG("layout_blocked: wrong block offset found\n");
-            memset(buffer + samples_written*vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+            decode_silence(vgmstream, samples_written, sample_count - samples_written, buffer);
             break;
         }
 
-        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame, vgmstream);
+        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame * frames_per_call, vgmstream);
         if (samples_to_do > sample_count - samples_written)
             samples_to_do = sample_count - samples_written;
 
@@ -76,6 +77,7 @@ void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM*
             /* update since these may change each block */
             frame_size = decode_get_frame_size(vgmstream);
             samples_per_frame = decode_get_samples_per_frame(vgmstream);
+            frames_per_call = decode_get_frames_per_call(vgmstream);
             if (vgmstream->current_block_samples) {
                 samples_this_block = vgmstream->current_block_samples;
             } else if (frame_size == 0) { /* assume 4 bit */ //TODO: decode_get_frame_size() really should return bits... */
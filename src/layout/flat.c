@@ -7,9 +7,10 @@
  * Data forms a single stream, and the decoder may internally skip chunks and move offsets as needed. */
 void render_vgmstream_flat(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
     int samples_written = 0;
-    int samples_per_frame, samples_this_block;
+    int samples_per_frame, samples_this_block, frames_per_call;
 
     samples_per_frame = decode_get_samples_per_frame(vgmstream);
+    frames_per_call = decode_get_frames_per_call(vgmstream);
     samples_this_block = vgmstream->num_samples; /* do all samples if possible */
 
 
@@ -21,7 +22,7 @@ void render_vgmstream_flat(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vg
             continue;
         }
 
-        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame, vgmstream);
+        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame * frames_per_call, vgmstream);
         if (samples_to_do > sample_count - samples_written)
             samples_to_do = sample_count - samples_written;
 
@@ -39,5 +40,73 @@ void render_vgmstream_flat(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vg
 
     return;
 decode_fail:
-    memset(outbuf + samples_written * vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+    decode_silence(vgmstream, samples_written, sample_count - samples_written, outbuf);
+}
+
+/* Same as above but for float renders, for codecs that decode to float natively. */
+void render_vgmstream_flat_f32(float* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    int samples_written = 0;
+    int samples_per_frame, samples_this_block, frames_per_call;
+
+    samples_per_frame = decode_get_samples_per_frame(vgmstream);
+    frames_per_call = decode_get_frames_per_call(vgmstream);
+    samples_this_block = vgmstream->num_samples; /* do all samples if possible */
+
+
+    while (samples_written < sample_count) {
+        int samples_to_do;
+
+        if (vgmstream->loop_flag && decode_do_loop(vgmstream)) {
+            /* handle looping */
+            continue;
+        }
+
+        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame * frames_per_call, vgmstream);
+        if (samples_to_do > sample_count - samples_written)
+            samples_to_do = sample_count - samples_written;
+
+        if (samples_to_do == 0) { /* when decoding more than num_samples */
+            VGM_LOG_ONCE("FLAT: samples_to_do 0\n"); 
+            goto decode_fail;
+        }
+
+        decode_vgmstream_f32(vgmstream, samples_written, samples_to_do, outbuf);
+
+        samples_written += samples_to_do;
+        vgmstream->current_sample += samples_to_do;
+        vgmstream->samples_into_block += samples_to_do;
+    }
+
+    return;
+decode_fail:
+    memset(outbuf + samples_written * vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(float));
+}
+
+/* Moves decoder to the start of the frame with seek_sample (ahead of current sample) for codecs that can decode
+ * from any frame, so only the rest of the frame needs to be decoded. Returns 1 if moved. */
+int seek_layout_flat(VGMSTREAM* vgmstream, int32_t seek_sample) {
+    int samples_per_frame, frame_size, moves_offset;
+    int32_t frame_pos, frames, skip;
+    int ch;
+
+    if (!decode_get_seek_frame(vgmstream, &samples_per_frame, &frame_size, &moves_offset))
+        return 0;
+
+    /* frames are relative to samples_into_block (which may differ from current_sample after looping) */
+    frame_pos = vgmstream->samples_into_block % samples_per_frame;
+    frames = (frame_pos + seek_sample - vgmstream->current_sample) / samples_per_frame;
+    if (frames <= 0)
+        return 0;
+
+    skip = frames * samples_per_frame - frame_pos;
+    vgmstream->current_sample += skip;
+    vgmstream->samples_into_block += skip;
+
+    if (moves_offset) {
+        for (ch = 0; ch < vgmstream->channels; ch++) {
+            vgmstream->ch[ch].offset += frames * frame_size;
+        }
+    }
+
+    return 1;
 }
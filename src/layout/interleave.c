@@ -1,6 +1,9 @@
 #include "layout.h"
 #include "../vgmstream.h"
 #include "../base/decode.h"
+#include "../coding/coding.h"
+
+#define INTERLEAVE_PCM_FRAMES 0x1000
 
 
 /* Decodes samples for interleaved streams.
@@ -10,11 +13,15 @@
 void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTREAM * vgmstream) {
     int samples_written = 0;
     int samples_per_frame, samples_this_block; /* used */
+    int frames_per_call = decode_get_frames_per_call(vgmstream);
     int samples_per_frame_d = 0, samples_this_block_d = 0; /* default */
     int samples_per_frame_f = 0, samples_this_block_f = 0; /* first */
     int samples_per_frame_l = 0, samples_this_block_l = 0; /* last */
     int has_interleave_first = vgmstream->interleave_first_block_size && vgmstream->channels > 1;
     int has_interleave_last = vgmstream->interleave_last_block_size && vgmstream->channels > 1;
+    int blocks_per_move = 1;
+    int use_blocks = 0;
+    off_t block_skip = 0;
 
 
     /* setup */
@@ -57,6 +64,19 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
     if (samples_this_block == 0 && vgmstream->channels == 1)
         samples_this_block = vgmstream->num_samples;
 
+    /* frame interleaved PCM is converted for all channels at once, so use bigger blocks
+     * (offsets end up the same as moving one frame at a time) */
+    if (samples_this_block == 1 && !has_interleave_first && !has_interleave_last && pcm_get_frame_sample_size(vgmstream)) {
+        blocks_per_move = INTERLEAVE_PCM_FRAMES;
+        samples_this_block = blocks_per_move;
+    }
+
+
+    /* only for standard interleaves (offsets always move the same) */
+    if (vgmstream->decode_threads && !has_interleave_first && !has_interleave_last && blocks_per_move == 1 && samples_this_block > 0) {
+        use_blocks = 1;
+        block_skip = vgmstream->interleave_block_size * vgmstream->channels;
+    }
 
     /* write samples */
     while (samples_written < sample_count) {
@@ -83,7 +103,18 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
             continue;
         }
 
-        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame, vgmstream);
+        /* with decode threads each channel group can go over many blocks at once (up to loop points) */
+        if (use_blocks) {
+            samples_to_do = decode_get_samples_to_do(vgmstream->samples_into_block + (sample_count - samples_written), 0, vgmstream);
+            if (decode_vgmstream_blocks(vgmstream, samples_written, samples_to_do, buffer, samples_this_block, block_skip)) {
+                samples_written += samples_to_do;
+                vgmstream->current_sample += samples_to_do;
+                vgmstream->samples_into_block = (vgmstream->samples_into_block + samples_to_do) % samples_this_block;
+                continue;
+            }
+        }
+
+        samples_to_do = decode_get_samples_to_do(samples_this_block, samples_per_frame * frames_per_call, vgmstream);
         if (samples_to_do > sample_count - samples_written)
             samples_to_do = sample_count - samples_written;
 
@@ -135,7 +166,7 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
             }
             else {
                 for (ch = 0; ch < vgmstream->channels; ch++) {
-                    off_t skip = vgmstream->interleave_block_size*vgmstream->channels;
+                    off_t skip = vgmstream->interleave_block_size*vgmstream->channels*blocks_per_move;
                     vgmstream->ch[ch].offset += skip;
                 }
             }
@@ -146,5 +177,58 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
     return;
 fail:
     VGM_LOG_ONCE("layout_interleave: wrong values found\n");
-    memset(buffer + samples_written*vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+    decode_silence(vgmstream, samples_written, sample_count - samples_written, buffer);
+}
+
+/* Moves decoder to the start of the frame with seek_sample (ahead of current sample) for codecs that can decode
+ * from any frame, moving offsets to the target block. Returns 1 if moved. */
+int seek_layout_interleave(VGMSTREAM* vgmstream, int32_t seek_sample) {
+    int samples_per_frame, frame_size, moves_offset;
+    int has_interleave_last = vgmstream->interleave_last_block_size && vgmstream->channels > 1;
+    int32_t samples_this_block, block_pos, frame_pos, blocks;
+    off_t block_skip;
+    int ch;
+
+    if (!decode_get_seek_frame(vgmstream, &samples_per_frame, &frame_size, &moves_offset) || moves_offset)
+        return 0;
+    /* only standard interleaves */
+    if (vgmstream->interleave_first_block_size && vgmstream->channels > 1)
+        return 0;
+
+    samples_this_block = vgmstream->interleave_block_size / frame_size * samples_per_frame;
+    block_skip = vgmstream->interleave_block_size * vgmstream->channels;
+
+    /* mono interleaved stream with no layout set, offsets never move */
+    if (samples_this_block == 0 && vgmstream->channels == 1)
+        return seek_layout_flat(vgmstream, seek_sample);
+    if (samples_this_block == 0)
+        return 0;
+
+    /* frame interleaved PCM moves in bigger blocks (see above) */
+    if (samples_this_block == 1 && !has_interleave_last && pcm_get_frame_sample_size(vgmstream)) {
+        samples_this_block = INTERLEAVE_PCM_FRAMES;
+        block_skip *= INTERLEAVE_PCM_FRAMES;
+    }
+
+    block_pos = vgmstream->samples_into_block + (seek_sample - vgmstream->current_sample);
+    blocks = block_pos / samples_this_block;
+    block_pos = block_pos % samples_this_block;
+    frame_pos = block_pos % samples_per_frame;
+
+    if (blocks == 0 && block_pos - frame_pos <= vgmstream->samples_into_block)
+        return 0;
+
+    /* last interleave has different sizes */
+    if (has_interleave_last &&
+            vgmstream->current_sample - vgmstream->samples_into_block + (blocks + 1) * samples_this_block > vgmstream->num_samples)
+        return 0;
+
+    vgmstream->current_sample = seek_sample - frame_pos;
+    vgmstream->samples_into_block = block_pos - frame_pos;
+
+    for (ch = 0; ch < vgmstream->channels; ch++) {
+        vgmstream->ch[ch].offset += blocks * block_skip;
+    }
+
+    return 1;
 }
@@ -3,19 +3,54 @@
 #include "../base/decode.h"
 #include "../base/mixing.h"
 #include "../base/plugins.h"
+#include "../util/thread_pool.h"
 
 #define VGMSTREAM_MAX_LAYERS 255
 #define VGMSTREAM_LAYER_SAMPLE_BUFFER 8192
 
+static void render_layers_threads(layered_layout_data* data, int32_t samples_to_do, int is_f32);
+
+/* copies a layer's samples to its channels in the main buffer (dst starts at the layer's first channel) */
+static void copy_layer_samples(uint8_t* dst, int dst_channels, const uint8_t* src, int src_channels, int32_t samples, size_t sample_size) {
+    size_t src_frame = src_channels * sample_size;
+    size_t dst_frame = dst_channels * sample_size;
+    int32_t s;
+
+    if (src_channels == dst_channels) {
+        memcpy(dst, src, samples * src_frame);
+        return;
+    }
+
+    for (s = 0; s < samples; s++) {
+        memcpy(dst + s * dst_frame, src + s * src_frame, src_frame);
+    }
+}
+
+static void render_layer(void* buf, int32_t samples_to_do, VGMSTREAM* layer, int is_f32) {
+    if (is_f32)
+        render_vgmstream_f32(buf, samples_to_do, layer);
+    else
+        render_vgmstream(buf, samples_to_do, layer);
+}
+
+static void* get_layer_buffer(layered_layout_data* data, int layer, int is_f32) {
+    if (data->threads)
+        return is_f32 ? (void*)data->layer_buffers_f32[layer] : (void*)data->layer_buffers[layer];
+    return is_f32 ? (void*)data->buffer_f32 : (void*)data->buffer;
+}
+
 
 /* Decodes samples for layered streams.
  * Similar to flat layout, but decoded vgmstream are mixed into a final buffer, each vgmstream
  * may have different codecs and number of channels, creating a single super-vgmstream.
- * Usually combined with custom streamfiles to handle data interleaved in weird ways. */
-void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+ * Usually combined with custom streamfiles to handle data interleaved in weird ways.
+ * Renders int16 or float samples (each layer renders in the same format, so no conversions between them). */
+static void render_layered(void* outbuf, int32_t sample_count, VGMSTREAM* vgmstream, int is_f32) {
     int samples_written = 0;
     layered_layout_data* data = vgmstream->layout_data;
     int samples_per_frame, samples_this_block;
+    size_t sample_size = is_f32 ? sizeof(float) : sizeof(sample_t);
+    uint8_t* buf = outbuf;
 
     samples_per_frame = VGMSTREAM_LAYER_SAMPLE_BUFFER;
     samples_this_block = vgmstream->num_samples; /* do all samples if possible */
@@ -39,29 +74,27 @@ void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM*
             goto decode_fail;
         }
 
-        /* decode all layers */
+        /* decode all layers (at the same time with threads, each to its own buffer) */
+        if (data->threads) {
+            render_layers_threads(data, samples_to_do, is_f32);
+        }
+
         ch = 0;
         for (layer = 0; layer < data->layer_count; layer++) {
-            int s, layer_ch, layer_channels;
+            int layer_channels;
+            void* layer_buffer = get_layer_buffer(data, layer, is_f32);
 
             /* layers may have its own number of channels */
             mixing_info(data->layers[layer], NULL, &layer_channels);
 
-            render_vgmstream(
-                    data->buffer,
-                    samples_to_do,
-                    data->layers[layer]);
+            if (!data->threads) {
+                render_layer(layer_buffer, samples_to_do, data->layers[layer], is_f32);
+            }
 
             /* mix layer samples to main samples */
-            for (layer_ch = 0; layer_ch < layer_channels; layer_ch++) {
-                for (s = 0; s < samples_to_do; s++) {
-                    size_t layer_sample = s*layer_channels + layer_ch;
-                    size_t buffer_sample = (samples_written+s)*data->output_channels + ch;
-
-                    outbuf[buffer_sample] = data->buffer[layer_sample];
-                }
-                ch++;
-            }
+            copy_layer_samples(buf + (samples_written * data->output_channels + ch) * sample_size, data->output_channels,
+                    layer_buffer, layer_channels, samples_to_do, sample_size);
+            ch += layer_channels;
         }
 
 
@@ -72,7 +105,214 @@ void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM*
 
     return;
 decode_fail:
-    memset(outbuf + samples_written * data->output_channels, 0, (sample_count - samples_written) * data->output_channels * sizeof(sample_t));
+    memset(buf + samples_written * data->output_channels * sample_size, 0, (sample_count - samples_written) * data->output_channels * sample_size);
+}
+
+void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    render_layered(outbuf, sample_count, vgmstream, 0);
+}
+
+void render_vgmstream_layered_f32(float* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    render_layered(outbuf, sample_count, vgmstream, 1);
+}
+
+
+/* THREADS
+ * Layers are independent VGMSTREAMs (own state and SFs), so they can render at the same time
+ * into their own buffers, and be copied to the main buffer once all are done. */
+
+typedef struct {
+    layered_layout_data* data;
+    int32_t samples_to_do;
+    int is_f32;
+} layered_job_t;
+
+static void render_layer_job(void* arg, int layer) {
+    layered_job_t* job = arg;
+    layered_layout_data* data = job->data;
+
+    render_layer(get_layer_buffer(data, layer, job->is_f32), job->samples_to_do, data->layers[layer], job->is_f32);
+}
+
+static void render_layers_threads(layered_layout_data* data, int32_t samples_to_do, int is_f32) {
+    layered_job_t job;
+
+    job.data = data;
+    job.samples_to_do = samples_to_do;
+    job.is_f32 = is_f32;
+    vgm_pool_run(data->threads, render_layer_job, &job, data->layer_count);
+}
+
+static void free_layered_threads(layered_layout_data* data) {
+    int i;
+
+    vgm_pool_free(data->threads);
+    data->threads = NULL;
+
+    if (data->layer_buffers) {
+        for (i = 0; i < data->layer_count; i++) {
+            free(data->layer_buffers[i]);
+        }
+        free(data->layer_buffers);
+        data->layer_buffers = NULL;
+    }
+    if (data->layer_buffers_f32) {
+        for (i = 0; i < data->layer_count; i++) {
+            free(data->layer_buffers_f32[i]);
+        }
+        free(data->layer_buffers_f32);
+        data->layer_buffers_f32 = NULL;
+    }
+}
+
+/* checks if all SFs of a VGMSTREAM (and its sub-VGMSTREAMs) can be read while other layers read theirs */
+static int layer_streamfiles_threadsafe(VGMSTREAM* vgmstream) {
+    int i;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+        if (data->open_segment)
+            return 0; /* deferred segments are opened later, from unknown SFs */
+        for (i = 0; i < data->segment_count; i++) {
+            if (!layer_streamfiles_threadsafe(data->segments[i]))
+                return 0;
+        }
+        return 1;
+    }
+
+    if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+        for (i = 0; i < data->layer_count; i++) {
+            if (!layer_streamfiles_threadsafe(data->layers[i]))
+                return 0;
+        }
+        return 1;
+    }
+
+    for (i = 0; i < vgmstream->channels; i++) {
+        STREAMFILE* sf = vgmstream->ch[i].streamfile;
+        if (sf && !is_threadsafe_streamfile(sf))
+            return 0;
+    }
+    return 1;
+}
+
+/* checks if sf is (or shares an underlying SF with) any SF of a VGMSTREAM and its sub-VGMSTREAMs */
+static int layer_has_streamfile(VGMSTREAM* vgmstream, STREAMFILE* sf) {
+    int i;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+        for (i = 0; i < data->segment_count; i++) {
+            if (layer_has_streamfile(data->segments[i], sf))
+                return 1;
+        }
+        return 0;
+    }
+
+    if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+        for (i = 0; i < data->layer_count; i++) {
+            if (layer_has_streamfile(data->layers[i], sf))
+                return 1;
+        }
+        return 0;
+    }
+
+    for (i = 0; i < vgmstream->channels; i++) {
+        STREAMFILE* layer_sf = vgmstream->ch[i].streamfile;
+        if (layer_sf && is_shared_streamfile(layer_sf, sf))
+            return 1;
+    }
+    return 0;
+}
+
+/* checks if any SF of a VGMSTREAM (and its sub-VGMSTREAMs) is shared with other */
+static int layers_share_streamfile(VGMSTREAM* vgmstream, VGMSTREAM* other) {
+    int i;
+
+    if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+        for (i = 0; i < data->segment_count; i++) {
+            if (layers_share_streamfile(data->segments[i], other))
+                return 1;
+        }
+        return 0;
+    }
+
+    if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+        for (i = 0; i < data->layer_count; i++) {
+            if (layers_share_streamfile(data->layers[i], other))
+                return 1;
+        }
+        return 0;
+    }
+
+    for (i = 0; i < vgmstream->channels; i++) {
+        STREAMFILE* sf = vgmstream->ch[i].streamfile;
+        if (sf && layer_has_streamfile(other, sf))
+            return 1;
+    }
+    return 0;
+}
+
+/* Layers render at the same time, so they can't read from the same SFs (their buffers aren't thread-safe),
+ * even through different wrappers, and their base SFs must allow reads from reopens in other threads
+ * (stdio reopens share the file position). */
+static int layers_can_use_threads(layered_layout_data* data) {
+    int i, j;
+
+    for (i = 0; i < data->layer_count; i++) {
+        if (!layer_streamfiles_threadsafe(data->layers[i]))
+            return 0;
+    }
+
+    for (i = 0; i < data->layer_count; i++) {
+        for (j = i + 1; j < data->layer_count; j++) {
+            if (layers_share_streamfile(data->layers[i], data->layers[j]))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+void setup_layout_layered_threads(layered_layout_data* data, int threads) {
+    int i;
+
+    free_layered_threads(data);
+
+    if (threads > data->layer_count)
+        threads = data->layer_count;
+    if (threads <= 1)
+        return;
+    if (!layers_can_use_threads(data)) {
+        VGM_LOG("LAYERED: streamfiles can't be read by threads\n");
+        return;
+    }
+
+    data->layer_buffers = calloc(data->layer_count, sizeof(sample_t*));
+    data->layer_buffers_f32 = calloc(data->layer_count, sizeof(float*));
+    if (!data->layer_buffers || !data->layer_buffers_f32) goto fail;
+
+    for (i = 0; i < data->layer_count; i++) {
+        int layer_channels;
+
+        mixing_info(data->layers[i], &layer_channels, NULL);
+
+        data->layer_buffers[i] = malloc(VGMSTREAM_LAYER_SAMPLE_BUFFER * layer_channels * sizeof(sample_t));
+        data->layer_buffers_f32[i] = malloc(VGMSTREAM_LAYER_SAMPLE_BUFFER * layer_channels * sizeof(float));
+        if (!data->layer_buffers[i] || !data->layer_buffers_f32[i]) goto fail;
+    }
+
+    data->threads = vgm_pool_init(threads);
+    if (!data->threads) goto fail;
+
+    return;
+fail:
+    VGM_LOG("LAYERED: can't setup threads\n");
+    free_layered_threads(data);
 }
 
 
@@ -144,6 +384,7 @@ fail:
 int setup_layout_layered(layered_layout_data* data) {
     int i, max_input_channels = 0, max_output_channels = 0;
     sample_t *outbuf_re = NULL;
+    float *outbuf_f32_re = NULL;
 
 
     /* setup each VGMSTREAM (roughly equivalent to vgmstream.c's init_vgmstream_internal stuff) */
@@ -199,6 +440,10 @@ int setup_layout_layered(layered_layout_data* data) {
     if (!outbuf_re) goto fail;
     data->buffer = outbuf_re;
 
+    outbuf_f32_re = realloc(data->buffer_f32, VGMSTREAM_LAYER_SAMPLE_BUFFER*max_input_channels*sizeof(float));
+    if (!outbuf_f32_re) goto fail;
+    data->buffer_f32 = outbuf_f32_re;
+
     data->input_channels = max_input_channels;
     data->output_channels = max_output_channels;
 
@@ -219,7 +464,9 @@ void free_layout_layered(layered_layout_data *data) {
         }
         free(data->layers);
     }
+    free_layered_threads(data);
     free(data->buffer);
+    free(data->buffer_f32);
     free(data);
 }
 
@@ -52,22 +52,29 @@ void block_update_tt_ad(off_t block_offset, VGMSTREAM* vgmstream);
 
 /* other layouts */
 void render_vgmstream_interleave(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+int seek_layout_interleave(VGMSTREAM* vgmstream, int32_t seek_sample);
 
 void render_vgmstream_flat(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+void render_vgmstream_flat_f32(float* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+int seek_layout_flat(VGMSTREAM* vgmstream, int32_t seek_sample);
 
 void render_vgmstream_segmented(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+void render_vgmstream_segmented_f32(float* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
 segmented_layout_data* init_layout_segmented(int segment_count);
 int setup_layout_segmented(segmented_layout_data* data);
 void free_layout_segmented(segmented_layout_data* data);
 void reset_layout_segmented(segmented_layout_data* data);
 void seek_layout_segmented(VGMSTREAM* vgmstream, int32_t seek_sample);
+void set_layout_segmented_deferred(segmented_layout_data* data, VGMSTREAM* (*open_segment)(void* open_data, int segment), void* open_data, void (*free_open_data)(void* open_data));
 void loop_layout_segmented(VGMSTREAM* vgmstream, int32_t loop_sample);
 VGMSTREAM *allocate_segmented_vgmstream(segmented_layout_data* data, int loop_flag, int loop_start_segment, int loop_end_segment);
 
 void render_vgmstream_layered(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+void render_vgmstream_layered_f32(float* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
 layered_layout_data* init_layout_layered(int layer_count);
 int setup_layout_layered(layered_layout_data* data);
 void free_layout_layered(layered_layout_data* data);
+void setup_layout_layered_threads(layered_layout_data* data, int threads);
 void reset_layout_layered(layered_layout_data* data);
 void seek_layout_layered(VGMSTREAM* vgmstream, int32_t seek_sample);
 void loop_layout_layered(VGMSTREAM* vgmstream, int32_t loop_sample);
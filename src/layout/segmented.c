@@ -7,16 +7,21 @@
 #define VGMSTREAM_MAX_SEGMENTS 1024
 #define VGMSTREAM_SEGMENT_SAMPLE_BUFFER 8192
 
-static inline void copy_samples(sample_t* outbuf, segmented_layout_data* data, int current_channels, int32_t samples_to_do, int32_t samples_written);
+static inline void copy_samples(uint8_t* outbuf, const uint8_t* buffer, size_t sample_size, int ch_out, int ch_in, int32_t samples_to_do, int32_t samples_written);
+static int update_deferred_segments(VGMSTREAM* vgmstream, segmented_layout_data* data);
 
 /* Decodes samples for segmented streams.
  * Chains together sequential vgmstreams, for data divided into separate sections or files
- * (like one part for intro and other for loop segments, which may even use different codecs). */
-void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+ * (like one part for intro and other for loop segments, which may even use different codecs).
+ * Renders int16 or float samples (each segment renders in the same format, so no conversions between them). */
+static void render_segmented(void* outbuf, int32_t sample_count, VGMSTREAM* vgmstream, int is_f32) {
     int samples_written = 0, samples_this_block;
     segmented_layout_data* data = vgmstream->layout_data;
     int use_internal_buffer = 0;
     int current_channels = 0;
+    size_t sample_size = is_f32 ? sizeof(float) : sizeof(sample_t);
+    uint8_t* buf = outbuf;
+    uint8_t* buffer = is_f32 ? (uint8_t*)data->buffer_f32 : (uint8_t*)data->buffer;
 
     /* normally uses outbuf directly (faster?) but could need internal buffer if downmixing */
     if (vgmstream->channels != data->input_channels || data->mixed_channels) {
@@ -28,14 +33,20 @@ void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREA
         goto decode_fail;
     }
 
+    if (!data->segments[data->current_segment] && !update_deferred_segments(vgmstream, data))
+        goto decode_fail;
+
     samples_this_block = vgmstream_get_samples(data->segments[data->current_segment]);
     mixing_info(data->segments[data->current_segment], NULL, &current_channels);
 
     while (samples_written < sample_count) {
         int samples_to_do;
+        void* dst;
 
         if (vgmstream->loop_flag && decode_do_loop(vgmstream)) {
             /* handle looping (loop_layout has been called below, changes segments/state) */
+            if (!data->segments[data->current_segment])
+                goto decode_fail;
             samples_this_block = vgmstream_get_samples(data->segments[data->current_segment]);
             mixing_info(data->segments[data->current_segment], NULL, &current_channels);
             continue;
@@ -50,6 +61,10 @@ void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREA
                 goto decode_fail;
             }
 
+            /* deferred segments are opened as they are reached */
+            if (data->open_segment && !update_deferred_segments(vgmstream, data))
+                goto decode_fail;
+
             /* in case of looping spanning multiple segments */
             reset_vgmstream(data->segments[data->current_segment]);
 
@@ -71,14 +86,14 @@ void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREA
             goto decode_fail;
         }
 
-        render_vgmstream(
-                use_internal_buffer ?
-                        data->buffer : &outbuf[samples_written * data->output_channels],
-                samples_to_do,
-                data->segments[data->current_segment]);
+        dst = use_internal_buffer ? buffer : buf + samples_written * data->output_channels * sample_size;
+        if (is_f32)
+            render_vgmstream_f32(dst, samples_to_do, data->segments[data->current_segment]);
+        else
+            render_vgmstream(dst, samples_to_do, data->segments[data->current_segment]);
 
         if (use_internal_buffer) {
-            copy_samples(outbuf, data, current_channels, samples_to_do, samples_written);
+            copy_samples(buf, buffer, sample_size, data->output_channels, current_channels, samples_to_do, samples_written);
         }
 
         samples_written += samples_to_do;
@@ -88,58 +103,68 @@ void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREA
 
     return;
 decode_fail:
-    memset(outbuf + samples_written * data->output_channels, 0, (sample_count - samples_written) * data->output_channels * sizeof(sample_t));
+    memset(buf + samples_written * data->output_channels * sample_size, 0, (sample_count - samples_written) * data->output_channels * sample_size);
 }
 
-static inline void copy_samples(sample_t* outbuf, segmented_layout_data* data, int current_channels, int32_t samples_to_do, int32_t samples_written) {
-    int ch_out = data->output_channels;
-    int ch_in = current_channels;
-    int pos = samples_written * ch_out;
+void render_vgmstream_segmented(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    render_segmented(outbuf, sample_count, vgmstream, 0);
+}
+
+void render_vgmstream_segmented_f32(float* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    render_segmented(outbuf, sample_count, vgmstream, 1);
+}
+
+static inline void copy_samples(uint8_t* outbuf, const uint8_t* buffer, size_t sample_size, int ch_out, int ch_in, int32_t samples_to_do, int32_t samples_written) {
+    size_t frame_out = ch_out * sample_size;
+    size_t frame_in = ch_in * sample_size;
+    uint8_t* dst = outbuf + samples_written * frame_out;
     int s;
+
     if (ch_in == ch_out) { /* most common and probably faster */
-        for (s = 0; s < samples_to_do * ch_out; s++) {
-            outbuf[pos + s] = data->buffer[s];
-        }
+        memcpy(dst, buffer, samples_to_do * frame_out);
     }
     else {
-        int ch;
+        /* extra channels are silence (0 in both int16 and float) */
         for (s = 0; s < samples_to_do; s++) {
-            for (ch = 0; ch < ch_in; ch++) {
-                outbuf[pos + s*ch_out + ch] = data->buffer[s*ch_in + ch];
-            }
-            for (ch = ch_in; ch < ch_out; ch++) {
-                outbuf[pos + s*ch_out + ch] = 0;
-            }
+            memcpy(dst + s * frame_out, buffer + s * frame_in, frame_in);
+            memset(dst + s * frame_out + frame_in, 0, frame_out - frame_in);
         }
     }
 }
 
 
 void seek_layout_segmented(VGMSTREAM* vgmstream, int32_t seek_sample) {
-    int segment, total_samples;
+    int segment, lo, hi;
+    int32_t seek_relative;
     segmented_layout_data* data = vgmstream->layout_data;
 
-    segment = 0;
-    total_samples = 0;
-    while (total_samples < vgmstream->num_samples) {
-        int32_t segment_samples = vgmstream_get_samples(data->segments[segment]);
-
-        /* find if sample falls within segment's samples */
-        if (seek_sample >= total_samples && seek_sample < total_samples + segment_samples) {
-            int32_t seek_relative = seek_sample - total_samples;
+    if (seek_sample < 0 || seek_sample >= data->segment_starts[data->segment_count]) {
+        VGM_LOG("SEGMENTED: can't find seek segment\n");
+        return;
+    }
 
-            seek_vgmstream(data->segments[segment], seek_relative);
-            data->current_segment = segment;
-            vgmstream->samples_into_block = seek_relative;
-            break;
-        }
-        total_samples += segment_samples;
-        segment++;
+    /* find last segment that starts before sample (binary search, as there may be many segments) */
+    lo = 0;
+    hi = data->segment_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (data->segment_starts[mid] <= seek_sample)
+            lo = mid;
+        else
+            hi = mid - 1;
     }
+    segment = lo;
+    seek_relative = seek_sample - data->segment_starts[segment];
 
-    if (segment == data->segment_count) {
-        VGM_LOG("SEGMENTED: can't find seek segment\n");
+    data->current_segment = segment;
+    if (data->open_segment && !update_deferred_segments(vgmstream, data)) {
+        VGM_LOG("SEGMENTED: can't open seek segment\n");
+        return;
     }
+
+    seek_vgmstream(data->segments[segment], seek_relative);
+    vgmstream->current_sample = seek_sample;
+    vgmstream->samples_into_block = seek_relative;
 }
 
 void loop_layout_segmented(VGMSTREAM* vgmstream, int32_t loop_sample) {
@@ -168,15 +193,56 @@ fail:
     return NULL;
 }
 
+/* segment setup (roughly equivalent to vgmstream.c's init_vgmstream_internal stuff) */
+static void setup_segment(segmented_layout_data* data, VGMSTREAM* segment, int i) {
+
+    /* allow config if set for fine-tuned parts (usually TXTP only) */
+    segment->config_enabled = segment->config.config_set;
+
+    /* disable so that looping is controlled by render_vgmstream_segmented */
+    if (segment->loop_flag != 0) {
+        VGM_LOG("SEGMENTED: segment %i is looped\n", i);
+
+        /* config allows internal loops */
+        if (!segment->config_enabled) {
+            segment->loop_flag = 0;
+        }
+    }
+
+    /* init mixing */
+    mixing_setup(segment, VGMSTREAM_SEGMENT_SAMPLE_BUFFER);
+
+    /* final setup in case the VGMSTREAM was created manually */
+    setup_vgmstream(segment);
+
+    if (data->decode_threads)
+        vgmstream_set_decode_threads(segment, data->decode_threads);
+    if (data->seek_interval)
+        vgmstream_set_seek_table(segment, data->seek_interval);
+}
+
 int setup_layout_segmented(segmented_layout_data* data) {
     int i, max_input_channels = 0, max_output_channels = 0, mixed_channels = 0;
+    int prev_output_channels = 0, prev_sample_rate = 0;
     sample_t *outbuf_re = NULL;
+    float *outbuf_f32_re = NULL;
+    int32_t *starts_re = NULL;
+
 
+    /* segment positions */
+    starts_re = realloc(data->segment_starts, (data->segment_count + 1) * sizeof(int32_t));
+    if (!starts_re) goto fail;
+    data->segment_starts = starts_re;
+    data->segment_starts[0] = 0;
 
-    /* setup each VGMSTREAM (roughly equivalent to vgmstream.c's init_vgmstream_internal stuff) */
     for (i = 0; i < data->segment_count; i++) {
         int segment_input_channels, segment_output_channels;
 
+        /* deferred segments are only opened to get their info here */
+        if (data->segments[i] == NULL && data->open_segment) {
+            data->segments[i] = data->open_segment(data->open_data, i);
+        }
+
         if (data->segments[i] == NULL) {
             VGM_LOG("SEGMENTED: no vgmstream in segment %i\n", i);
             goto fail;
@@ -187,19 +253,6 @@ int setup_layout_segmented(segmented_layout_data* data) {
             goto fail;
         }
 
-        /* allow config if set for fine-tuned parts (usually TXTP only) */
-        data->segments[i]->config_enabled = data->segments[i]->config.config_set;
-
-        /* disable so that looping is controlled by render_vgmstream_segmented */
-        if (data->segments[i]->loop_flag != 0) {
-            VGM_LOG("SEGMENTED: segment %i is looped\n", i);
-
-            /* config allows internal loops */
-            if (!data->segments[i]->config_enabled) {
-                data->segments[i]->loop_flag = 0;
-            }
-        }
-
         /* different segments may have different input or output channels, we
          * need to know maxs to properly handle */
         mixing_info(data->segments[i], &segment_input_channels, &segment_output_channels);
@@ -209,9 +262,6 @@ int setup_layout_segmented(segmented_layout_data* data) {
             max_output_channels = segment_output_channels;
 
         if (i > 0) {
-            int prev_output_channels;
-
-            mixing_info(data->segments[i-1], NULL, &prev_output_channels);
             if (segment_output_channels != prev_output_channels) {
                 mixed_channels = 1;
                 //VGM_LOG("SEGMENTED: segment %i has wrong channels %i vs prev channels %i\n", i, segment_output_channels, prev_output_channels);
@@ -219,7 +269,7 @@ int setup_layout_segmented(segmented_layout_data* data) {
             }
 
             /* a bit weird, but no matter (should resample) */
-            if (data->segments[i]->sample_rate != data->segments[i-1]->sample_rate) {
+            if (data->segments[i]->sample_rate != prev_sample_rate) {
                 VGM_LOG("SEGMENTED: segment %i has different sample rate\n", i);
             }
 
@@ -227,12 +277,33 @@ int setup_layout_segmented(segmented_layout_data* data) {
             //if (data->segments[i]->coding_type != data->segments[i-1]->coding_type)
             //    goto fail;
         }
+        prev_output_channels = segment_output_channels;
+        prev_sample_rate = data->segments[i]->sample_rate;
+
+        setup_segment(data, data->segments[i], i);
 
-        /* init mixing */
-        mixing_setup(data->segments[i], VGMSTREAM_SEGMENT_SAMPLE_BUFFER);
+        /* after setup, since samples may depend on config */
+        data->segment_starts[i + 1] = data->segment_starts[i] + vgmstream_get_samples(data->segments[i]);
 
-        /* final setup in case the VGMSTREAM was created manually */
-        setup_vgmstream(data->segments[i]);
+        if (data->open_segment) {
+            /* keep info needed to make the layout VGMSTREAM (see allocate_segmented_vgmstream) */
+            if (i == 0) {
+                data->channel_layout = data->segments[i]->channel_layout;
+                data->coding_type = data->segments[i]->coding_type;
+            }
+            if (data->channel_layout != 0 && data->channel_layout != data->segments[i]->channel_layout)
+                data->channel_layout = 0;
+            if (data->sample_rate < data->segments[i]->sample_rate)
+                data->sample_rate = data->segments[i]->sample_rate;
+            if (data->coding_type == coding_SILENCE)
+                data->coding_type = data->segments[i]->coding_type;
+
+            /* first segment is kept for info (formats, bitrate) and quick starts */
+            if (i > 0) {
+                close_vgmstream(data->segments[i]);
+                data->segments[i] = NULL;
+            }
+        }
     }
 
     if (max_output_channels > VGMSTREAM_MAX_CHANNELS || max_input_channels > VGMSTREAM_MAX_CHANNELS)
@@ -243,6 +314,10 @@ int setup_layout_segmented(segmented_layout_data* data) {
     if (!outbuf_re) goto fail;
     data->buffer = outbuf_re;
 
+    outbuf_f32_re = realloc(data->buffer_f32, VGMSTREAM_SEGMENT_SAMPLE_BUFFER*max_input_channels*sizeof(float));
+    if (!outbuf_f32_re) goto fail;
+    data->buffer_f32 = outbuf_f32_re;
+
     data->input_channels = max_input_channels;
     data->output_channels = max_output_channels;
     data->mixed_channels = mixed_channels;
@@ -252,6 +327,72 @@ fail:
     return 0; /* caller is expected to free */
 }
 
+/* Sets deferred mode, for layouts with many segments: rather than keeping all segments open (each with
+ * its own buffers and files), they are opened with the callback when needed. Must be set before setup. */
+void set_layout_segmented_deferred(segmented_layout_data* data, VGMSTREAM* (*open_segment)(void* open_data, int segment), void* open_data, void (*free_open_data)(void* open_data)) {
+    data->open_segment = open_segment;
+    data->open_data = open_data;
+    data->free_open_data = free_open_data;
+}
+
+static int open_deferred_segment(segmented_layout_data* data, int i) {
+    VGMSTREAM* segment;
+    int segment_output_channels;
+
+    if (data->segments[i])
+        return 1;
+
+    segment = data->open_segment(data->open_data, i);
+    if (!segment) goto fail;
+
+    setup_segment(data, segment, i);
+
+    /* should be the same as when first opened */
+    mixing_info(segment, NULL, &segment_output_channels);
+    if (vgmstream_get_samples(segment) != data->segment_starts[i + 1] - data->segment_starts[i]
+            || segment_output_channels > data->output_channels) {
+        VGM_LOG("SEGMENTED: segment %i changed\n", i);
+        close_vgmstream(segment);
+        goto fail;
+    }
+
+    data->segments[i] = segment;
+    return 1;
+fail:
+    VGM_LOG("SEGMENTED: can't open segment %i\n", i);
+    return 0;
+}
+
+/* Opens current segment, and closes segments that aren't needed anymore. Segments within the loop region
+ * are kept once opened as they'll be played again. */
+static int update_deferred_segments(VGMSTREAM* vgmstream, segmented_layout_data* data) {
+    int i, current = data->current_segment;
+
+    if (!data->open_segment)
+        return 1;
+
+    if (!open_deferred_segment(data, current))
+        return 0;
+
+    for (i = 1; i < data->segment_count; i++) {
+        int is_loop;
+
+        if (!data->segments[i] || i == current)
+            continue;
+
+        is_loop = vgmstream->loop_flag
+                && data->segment_starts[i + 1] > vgmstream->loop_start_sample
+                && data->segment_starts[i] < vgmstream->loop_end_sample;
+        if (is_loop)
+            continue;
+
+        close_vgmstream(data->segments[i]);
+        data->segments[i] = NULL;
+    }
+
+    return 1;
+}
+
 void free_layout_segmented(segmented_layout_data* data) {
     int i, j;
 
@@ -274,7 +415,11 @@ void free_layout_segmented(segmented_layout_data* data) {
         }
         free(data->segments);
     }
+    if (data->free_open_data)
+        data->free_open_data(data->open_data);
     free(data->buffer);
+    free(data->buffer_f32);
+    free(data->segment_starts);
     free(data);
 }
 
@@ -286,6 +431,8 @@ void reset_layout_segmented(segmented_layout_data* data) {
 
     data->current_segment = 0;
     for (i = 0; i < data->segment_count; i++) {
+        if (!data->segments[i]) /* closed deferred segment */
+            continue;
         reset_vgmstream(data->segments[i]);
     }
 }
@@ -304,7 +451,18 @@ VGMSTREAM* allocate_segmented_vgmstream(segmented_layout_data* data, int loop_fl
     loop_start = 0;
     loop_end = 0;
     sample_rate = 0;
-    for (i = 0; i < data->segment_count; i++) {
+    if (data->open_segment) {
+        /* segments are closed, use info from setup */
+        num_samples = data->segment_starts[data->segment_count];
+        if (loop_flag && loop_start_segment >= 0 && loop_start_segment < data->segment_count)
+            loop_start = data->segment_starts[loop_start_segment];
+        if (loop_flag && loop_end_segment >= 0 && loop_end_segment < data->segment_count)
+            loop_end = data->segment_starts[loop_end_segment + 1];
+        channel_layout = data->channel_layout;
+        sample_rate = data->sample_rate;
+        coding_type = data->coding_type;
+    }
+    for (i = 0; i < data->segment_count && !data->open_segment; i++) {
         /* needs get_samples since element may use play settings */
         int32_t segment_samples = vgmstream_get_samples(data->segments[i]);
         int segment_rate = data->segments[i]->sample_rate;
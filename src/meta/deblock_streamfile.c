@@ -11,23 +11,97 @@ static void block_callback_default(STREAMFILE* sf, deblock_io_data* data) {
     //;VGM_LOG("DEBLOCK: of=%lx, bs=%lx, ss=%lx, ds=%lx\n", data->physical_offset, data->block_size, data->skip_size, data->data_size);
 }
 
+/* block state before calling block_callback, enough to resume reading from that block */
+struct deblock_index_t {
+    off_t logical_offset;
+    off_t physical_offset;
+    off_t chunk_size;
+    int step_count;
+};
+
+#define DEBLOCK_INDEX_MIN 256
+
+/* registers current block, if not visited before (blocks are always processed in order) */
+static void index_add(deblock_io_data* data) {
+    deblock_index_t* entry;
+
+    if (data->index_count > 0 && data->physical_offset <= data->index[data->index_count - 1].physical_offset)
+        return;
+
+    if (data->index_count >= data->index_max) {
+        int new_max = data->index_max ? data->index_max * 2 : DEBLOCK_INDEX_MIN;
+        deblock_index_t* new_index = realloc(data->index, new_max * sizeof(deblock_index_t));
+        if (!new_index) return; /* not critical */
+        data->index = new_index;
+        data->index_max = new_max;
+    }
+
+    entry = &data->index[data->index_count];
+    entry->logical_offset = data->logical_offset;
+    entry->physical_offset = data->physical_offset;
+    entry->chunk_size = data->chunk_size;
+    entry->step_count = data->step_count;
+    data->index_count++;
+}
+
+/* finds last block that starts before offset (blocks that are stepped over share logical offsets) */
+static deblock_index_t* index_find(deblock_io_data* data, off_t offset) {
+    int lo = 0, hi = data->index_count - 1;
+    deblock_index_t* found = NULL;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (data->index[mid].logical_offset <= offset) {
+            found = &data->index[mid];
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    return found;
+}
+
+static void index_restore(deblock_io_data* data, deblock_index_t* entry) {
+    data->physical_offset = entry->physical_offset;
+    data->logical_offset = entry->logical_offset;
+    data->block_size = 0;
+    data->data_size = 0;
+    data->skip_size = 0;
+    data->chunk_size = entry->chunk_size;
+    data->step_count = entry->step_count;
+}
+
 static size_t deblock_io_read(STREAMFILE* sf, uint8_t* dest, off_t offset, size_t length, deblock_io_data* data) {
     size_t total_read = 0;
 
     //;VGM_LOG("DEBLOCK: of=%lx, sz=%x, po=%lx\n", offset, length, data->physical_offset);
 
-    /* re-start when previous offset (can't map logical<>physical offsets) */
+    /* re-start when previous offset (can't map logical<>physical offsets without walking blocks) */
     if (data->logical_offset < 0 || offset < data->logical_offset) {
-        ;VGM_LOG("DEBLOCK: restart offset=%lx + %x, po=%lx, lo=%lx\n", offset, length, data->physical_offset, data->logical_offset);
-        data->physical_offset = data->cfg.stream_start;
-        data->logical_offset = 0x00;
-        data->block_size = 0;
-        data->data_size = 0;
-        data->skip_size = 0;
-        data->chunk_size = 0;
-
-        data->step_count = data->cfg.step_start;
-        //data->read_count = data->cfg.read_count;
+        deblock_index_t* entry = index_find(data, offset);
+        if (entry) {
+            index_restore(data, entry);
+        }
+        else {
+            ;VGM_LOG("DEBLOCK: restart offset=%lx + %x, po=%lx, lo=%lx\n", offset, length, data->physical_offset, data->logical_offset);
+            data->physical_offset = data->cfg.stream_start;
+            data->logical_offset = 0x00;
+            data->block_size = 0;
+            data->data_size = 0;
+            data->skip_size = 0;
+            data->chunk_size = 0;
+
+            data->step_count = data->cfg.step_start;
+            //data->read_count = data->cfg.read_count;
+        }
+    }
+    /* skip known blocks when jumping forward */
+    else if (offset >= data->logical_offset + data->data_size) {
+        deblock_index_t* entry = index_find(data, offset);
+        if (entry && entry->physical_offset > data->physical_offset)
+            index_restore(data, entry);
     }
 
     /* read blocks */
@@ -37,11 +111,15 @@ static size_t deblock_io_read(STREAMFILE* sf, uint8_t* dest, off_t offset, size_
         if (offset < 0 ||
                 (data->physical_offset >= data->cfg.stream_start + data->physical_size) ||
                 (data->logical_size > 0 && offset > data->logical_size)) {
+            /* all blocks visited, so size is known (unless config sets it, as padding blocks may be counted) */
+            if (offset >= 0 && data->physical_offset >= data->cfg.stream_start + data->physical_size && !data->cfg.logical_size)
+                data->logical_size = data->logical_offset;
             break;
         }
 
         /* process new block */
         if (data->data_size <= 0) {
+            index_add(data);
             data->cfg.block_callback(sf, data);
 
             if (data->block_size <= 0) {
@@ -127,9 +205,10 @@ static size_t deblock_io_size(STREAMFILE* sf, deblock_io_data* data) {
         return data->logical_size;
     }
 
-    /* force a fake read at max offset, to get max logical_offset (will be reset next read) */
+    /* force a fake read at max offset, to get max logical_offset (will be reset next read).
+     * Starts from the last visited block, and next reads won't need to walk all blocks again. */
     deblock_io_read(sf, buf, 0x7FFFFFFF, 1, data);
-    data->logical_size = data->logical_offset;
+    data->logical_size = data->logical_offset; /* only reached without config size (see above) */
     
     //todo tests:
     //if (logical_size > max_physical_offset)
@@ -141,6 +220,18 @@ static size_t deblock_io_size(STREAMFILE* sf, deblock_io_data* data) {
     return data->logical_size;
 }
 
+static int deblock_io_init(STREAMFILE* sf, deblock_io_data* data) {
+    /* reopened SFs get a copy of the current data, but index must be their own */
+    data->index = NULL;
+    data->index_count = 0;
+    data->index_max = 0;
+    return 0;
+}
+
+static void deblock_io_close(STREAMFILE* sf, deblock_io_data* data) {
+    free(data->index);
+}
+
 /* generic "de-blocker" helper for streams divided in blocks that have weird interleaves, their
  * decoder can't easily use blocked layout, or some other weird feature. It "filters" data so
  * reader only sees clean data without blocks. Must pass setup config and a callback that sets
@@ -177,7 +268,7 @@ STREAMFILE* open_io_deblock_streamfile_f(STREAMFILE* sf, deblock_config_t *cfg)
     //TODO: other validations
 
     /* setup subfile */
-    new_sf = open_io_streamfile_f(sf, &io_data, sizeof(deblock_io_data), deblock_io_read, deblock_io_size);
+    new_sf = open_io_streamfile_ex_f(sf, &io_data, sizeof(deblock_io_data), deblock_io_read, deblock_io_size, deblock_io_init, deblock_io_close);
     return new_sf;
 fail:
     VGM_LOG("DEBLOCK: bad init\n");
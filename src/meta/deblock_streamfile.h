@@ -4,6 +4,7 @@
 
 typedef struct deblock_config_t deblock_config_t;
 typedef struct deblock_io_data deblock_io_data;
+typedef struct deblock_index_t deblock_index_t;
 
 struct deblock_config_t {
     /* config (all optional) */
@@ -57,6 +58,11 @@ struct deblock_io_data {
     size_t logical_size;
     size_t physical_size;
     off_t physical_end;
+
+    /* visited blocks, to restart reads from the closest one rather than from the beginning */
+    deblock_index_t* index;
+    int index_count;
+    int index_max;
 };
 
 STREAMFILE* open_io_deblock_streamfile_f(STREAMFILE* sf, deblock_config_t* cfg);
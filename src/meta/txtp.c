@@ -19,6 +19,7 @@
 #define TXTP_GROUP_RANDOM_ALL '-'
 #define TXTP_GROUP_REPEAT 'R'
 #define TXTP_POSITION_LOOPS 'L'
+#define TXTP_DEFERRED_MIN 32 /* segments, past this are opened on demand (see is_deferred) */
 
 /* mixing info */
 typedef enum {
@@ -147,6 +148,8 @@ static txtp_header* parse_txtp(STREAMFILE* sf);
 static int parse_entries(txtp_header* txtp, STREAMFILE* sf);
 static int parse_groups(txtp_header* txtp);
 static void clean_txtp(txtp_header* txtp, int fail);
+static int is_deferred(txtp_header* txtp);
+static VGMSTREAM* make_deferred_segments(txtp_header* txtp, STREAMFILE* sf);
 static void apply_settings(VGMSTREAM* vgmstream, txtp_entry* current);
 void add_mixing(txtp_entry* cfg, txtp_mix_data* mix, txtp_mix_t command);
 
@@ -166,23 +169,30 @@ VGMSTREAM* init_vgmstream_txtp(STREAMFILE* sf) {
     txtp = parse_txtp(sf);
     if (!txtp) goto fail;
 
-    /* process files in the .txtp */
-    ok = parse_entries(txtp, sf);
-    if (!ok) goto fail;
+    /* long segment lists are opened as needed rather than all at once */
+    if (is_deferred(txtp)) {
+        vgmstream = make_deferred_segments(txtp, sf);
+        if (!vgmstream) goto fail;
+    }
+    else {
+        /* process files in the .txtp */
+        ok = parse_entries(txtp, sf);
+        if (!ok) goto fail;
 
-    /* group files into layouts */
-    ok = parse_groups(txtp);
-    if (!ok) goto fail;
+        /* group files into layouts */
+        ok = parse_groups(txtp);
+        if (!ok) goto fail;
 
 
-    /* may happen if using mixed mode but some files weren't grouped */
-    if (txtp->vgmstream_count != 1) {
-        VGM_LOG("TXTP: wrong final vgmstream count %i\n", txtp->vgmstream_count);
-        goto fail;
-    }
+        /* may happen if using mixed mode but some files weren't grouped */
+        if (txtp->vgmstream_count != 1) {
+            VGM_LOG("TXTP: wrong final vgmstream count %i\n", txtp->vgmstream_count);
+            goto fail;
+        }
 
-    /* should result in a final, single vgmstream possibly containing multiple vgmstreams */
-    vgmstream = txtp->vgmstream[0];
+        /* should result in a final, single vgmstream possibly containing multiple vgmstreams */
+        vgmstream = txtp->vgmstream[0];
+    }
 
     /* flags for title config */
     vgmstream->config.is_txtp = 1;
@@ -257,6 +267,36 @@ static int is_absolute(const char* fn) {
     return fn[0] == '/' || fn[0] == '\\'  || fn[1] == ':';
 }
 
+/* open a file entry and apply its settings */
+/* opens an entry's file (p_meta is optional, see init_vgmstream_from_STREAMFILE_meta) */
+static VGMSTREAM* open_entry(STREAMFILE* sf, txtp_entry* entry, int* p_meta) {
+    VGMSTREAM* vgmstream = NULL;
+    STREAMFILE* temp_sf = NULL;
+    const char* filename = entry->filename;
+
+    /* absolute paths are detected for convenience, but since it's hard to unify all OSs
+     * and plugins, they aren't "officially" supported nor documented, thus may or may not work */
+    if (is_absolute(filename))
+        temp_sf = open_streamfile(sf, filename); /* from path as is */
+    else
+        temp_sf = open_streamfile_by_filename(sf, filename); /* from current path */
+    if (!temp_sf) {
+        vgm_logi("TXTP: cannot open %s\n", filename);
+        return NULL;
+    }
+    temp_sf->stream_index = entry->subsong;
+
+    vgmstream = init_vgmstream_from_STREAMFILE_meta(temp_sf, p_meta);
+    close_streamfile(temp_sf);
+    if (!vgmstream) {
+        vgm_logi("TXTP: cannot parse %s#%i\n", filename, entry->subsong);
+        return NULL;
+    }
+
+    apply_settings(vgmstream, entry);
+    return vgmstream;
+}
+
 /* open all entries and apply settings to resulting VGMSTREAMs */
 static int parse_entries(txtp_header* txtp, STREAMFILE* sf) {
     int i;
@@ -274,7 +314,6 @@ static int parse_entries(txtp_header* txtp, STREAMFILE* sf) {
 
     /* open all entry files first as they'll be modified by modes */
     for (i = 0; i < txtp->vgmstream_count; i++) {
-        STREAMFILE* temp_sf = NULL;
         const char* filename = txtp->entry[i].filename;
 
         /* silent entry ignore */
@@ -284,26 +323,9 @@ static int parse_entries(txtp_header* txtp, STREAMFILE* sf) {
             continue;
         }
 
-        /* absolute paths are detected for convenience, but since it's hard to unify all OSs
-         * and plugins, they aren't "officially" supported nor documented, thus may or may not work */
-        if (is_absolute(filename))
-            temp_sf = open_streamfile(sf, filename); /* from path as is */
-        else
-            temp_sf = open_streamfile_by_filename(sf, filename); /* from current path */
-        if (!temp_sf) {
-            vgm_logi("TXTP: cannot open %s\n", filename);
+        txtp->vgmstream[i] = open_entry(sf, &txtp->entry[i], NULL);
+        if (!txtp->vgmstream[i])
             goto fail;
-        }
-        temp_sf->stream_index = txtp->entry[i].subsong;
-
-        txtp->vgmstream[i] = init_vgmstream_from_STREAMFILE(temp_sf);
-        close_streamfile(temp_sf);
-        if (!txtp->vgmstream[i]) {
-            vgm_logi("TXTP: cannot parse %s#%i\n", filename, txtp->entry[i].subsong);
-            goto fail;
-        }
-
-        apply_settings(txtp->vgmstream[i], &txtp->entry[i]);
     }
 
     if (has_silents) {
@@ -368,32 +390,17 @@ static int find_loop_anchors(txtp_header* txtp, int position, int count, int* p_
 }
 
 
-static int make_group_segment(txtp_header* txtp, txtp_group* grp, int position, int count) {
-    VGMSTREAM* vgmstream = NULL;
-    segmented_layout_data *data_s = NULL;
-    int i, loop_flag = 0;
+static int get_segment_loops(txtp_header* txtp, int position, int count, int is_final, int* p_loop_start, int* p_loop_end) {
+    int loop_flag = 0;
     int loop_start = 0, loop_end = 0;
 
-
-    /* allowed for actual groups (not final "mode"), otherwise skip to optimize */
-    if (!grp && count == 1) {
-        //;VGM_LOG("TXTP: ignored single group\n");
-        return 1;
-    }
-
-    if (position + count > txtp->vgmstream_count || position < 0 || count < 0) {
-        VGM_LOG("TXTP: ignored segment position=%i, count=%i, entries=%i\n", position, count, txtp->vgmstream_count);
-        return 1;
-    }
-
-
     /* set loops with "anchors" (this allows loop config inside groups, not just in the final group,
      * which is sometimes useful when paired with random/selectable groups or loop times) */
     if (find_loop_anchors(txtp, position, count, &loop_start, &loop_end)) {
         loop_flag = (loop_start > 0 && loop_start <= count);
     }
     /* loop segment settings only make sense if this group becomes final vgmstream */
-    else if (position == 0 && txtp->vgmstream_count == count) {
+    else if (is_final) {
         loop_start = txtp->loop_start_segment;
         loop_end = txtp->loop_end_segment;
 
@@ -407,6 +414,31 @@ static int make_group_segment(txtp_header* txtp, txtp_group* grp, int position,
         loop_flag = (loop_start > 0 && loop_start <= count);
     }
 
+    *p_loop_start = loop_start;
+    *p_loop_end = loop_end;
+    return loop_flag;
+}
+
+static int make_group_segment(txtp_header* txtp, txtp_group* grp, int position, int count) {
+    VGMSTREAM* vgmstream = NULL;
+    segmented_layout_data *data_s = NULL;
+    int i, loop_flag = 0;
+    int loop_start = 0, loop_end = 0;
+
+
+    /* allowed for actual groups (not final "mode"), otherwise skip to optimize */
+    if (!grp && count == 1) {
+        //;VGM_LOG("TXTP: ignored single group\n");
+        return 1;
+    }
+
+    if (position + count > txtp->vgmstream_count || position < 0 || count < 0) {
+        VGM_LOG("TXTP: ignored segment position=%i, count=%i, entries=%i\n", position, count, txtp->vgmstream_count);
+        return 1;
+    }
+
+    loop_flag = get_segment_loops(txtp, position, count, position == 0 && txtp->vgmstream_count == count, &loop_start, &loop_end);
+
 
     /* init layout */
     data_s = init_layout_segmented(count);
@@ -690,6 +722,128 @@ fail:
 }
 
 
+/*******************************************************************************/
+/* DEFERRED                                                                    */
+/*******************************************************************************/
+
+/* Plain lists of many segments (long sequences) are opened on demand by the layout, so only a
+ * few are open at a time. Groups/silences/loop keep need all segments, so use regular opening.
+ * Each open keeps at least one file (plus buffers) per segment, so lists of hundreds of parts could reach
+ * the OS's open file limits (like 256 on some systems), while short lists (most multi-part songs) work fine
+ * opening everything; TXTP_DEFERRED_MIN is a middle ground that stays well below those limits.
+ * Segment files are detected once, and later opens call their meta directly. */
+
+typedef struct {
+    STREAMFILE* sf; /* base .txtp, to open entries relative to it */
+    txtp_entry* entry;
+    int* metas;     /* detected meta of each entry, to reopen without format detection (-1 if not known) */
+    int opened;
+    meta_t meta_type; /* of all opened segments, or TXTP if different */
+} txtp_deferred_t;
+
+static int is_deferred(txtp_header* txtp) {
+    int i;
+
+    if (!txtp->is_segmented || txtp->is_layered || txtp->group_count > 0 || txtp->is_loop_keep)
+        return 0;
+    if (txtp->entry_count < TXTP_DEFERRED_MIN)
+        return 0;
+
+    for (i = 0; i < txtp->entry_count; i++) {
+        if (is_silent(txtp->entry[i].filename))
+            return 0;
+    }
+
+    return 1;
+}
+
+static VGMSTREAM* open_deferred_segment(void* open_data, int segment) {
+    txtp_deferred_t* data = open_data;
+    VGMSTREAM* vgmstream;
+
+    vgmstream = open_entry(data->sf, &data->entry[segment], &data->metas[segment]);
+    if (!vgmstream)
+        return NULL;
+
+    if (!data->opened)
+        data->meta_type = vgmstream->meta_type;
+    else if (data->meta_type != vgmstream->meta_type)
+        data->meta_type = meta_TXTP;
+    data->opened = 1;
+
+    return vgmstream;
+}
+
+static void free_deferred_data(void* open_data) {
+    txtp_deferred_t* data = open_data;
+    if (!data)
+        return;
+    close_streamfile(data->sf);
+    free(data->entry);
+    free(data->metas);
+    free(data);
+}
+
+static VGMSTREAM* make_deferred_segments(txtp_header* txtp, STREAMFILE* sf) {
+    VGMSTREAM* vgmstream = NULL;
+    segmented_layout_data* data_s = NULL;
+    txtp_deferred_t* data_d = NULL;
+    txtp_deferred_t* open_data;
+    int i, count = txtp->entry_count;
+    int loop_flag, loop_start = 0, loop_end = 0;
+
+    loop_flag = get_segment_loops(txtp, 0, count, 1, &loop_start, &loop_end);
+
+    data_d = calloc(1, sizeof(txtp_deferred_t));
+    if (!data_d) goto fail;
+
+    data_d->sf = reopen_streamfile(sf, 0);
+    if (!data_d->sf) goto fail;
+
+    data_d->metas = malloc(count * sizeof(int));
+    if (!data_d->metas) goto fail;
+    for (i = 0; i < count; i++) {
+        data_d->metas[i] = -1;
+    }
+
+    /* entries are kept to reapply settings on each open */
+    data_d->entry = txtp->entry;
+    txtp->entry = NULL;
+    txtp->entry_count = 0;
+
+    /* init layout */
+    data_s = init_layout_segmented(count);
+    if (!data_s) goto fail;
+
+    set_layout_segmented_deferred(data_s, open_deferred_segment, data_d, free_deferred_data);
+    open_data = data_d;
+    data_d = NULL; /* will be freed by layout */
+
+    /* opens each segment to get its info (and closes it) */
+    if (!setup_layout_segmented(data_s))
+        goto fail;
+
+    vgmstream = allocate_segmented_vgmstream(data_s, loop_flag, loop_start - 1, loop_end - 1);
+    if (!vgmstream) goto fail;
+
+    /* custom meta name if all parts don't match */
+    vgmstream->meta_type = open_data->meta_type;
+
+    /* apply default settings to the resulting file */
+    if (txtp->default_entry_set) {
+        apply_settings(vgmstream, &txtp->default_entry);
+    }
+
+    return vgmstream;
+fail:
+    close_vgmstream(vgmstream);
+    if (!vgmstream)
+        free_layout_segmented(data_s);
+    free_deferred_data(data_d);
+    return NULL;
+}
+
+
 /*******************************************************************************/
 /* CONFIG                                                                      */
 /*******************************************************************************/
@@ -3,6 +3,7 @@
 #include "vgmstream.h"
 #include "util/paths.h"
 #include "util/sf_utils.h"
+#include "util/thread.h"
 #include <string.h>
 
 /* for dup/fdopen in some systems */
@@ -20,7 +21,19 @@
 #if !defined (_MSC_VER) && !defined (__ANDROID__) && !defined (__APPLE__)
     #define USE_STDIO_FDUP 1
 #endif
- 
+
+/* Enables memory-mapped files and pread-based IO on POSIX systems (others fall back to stdio).
+ * Not used by default, mainly for callers that decode big files and want to avoid buffer copies,
+ * or read from multiple threads without depending on FILE positions. */
+#if !defined (_MSC_VER) && !defined (__MINGW32__) && !defined (__MINGW64__) && !defined (__EMSCRIPTEN__)
+    #define USE_MMAP 1
+    #define USE_PREAD 1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <errno.h>
+#endif
+
 /* For (rarely needed) +2GB file support we use fseek64/ftell64. Those are usually available
  * but may depend on compiler.
  * - MSVC: +VS2008 should work
@@ -77,6 +90,17 @@
 #endif
 
 
+/* max pages per stdio SF (bigger buffers use bigger pages) */
+#define STDIO_MAX_PAGES  64
+
+/* a chunk of file data, cached in the SF */
+typedef struct {
+    offv_t offset;          /* current page data start */
+    size_t valid_size;      /* current page data size */
+    uint8_t* buf;           /* page data (part of main buf) */
+    uint32_t last_used;     /* LRU counter */
+} stdio_page_t;
+
 /* a STREAMFILE that operates via standard IO using a buffer */
 typedef struct {
     STREAMFILE vt;          /* callbacks */
@@ -85,15 +109,102 @@ typedef struct {
     char name[PATH_LIMIT];  /* FILE filename */
     int name_len;           /* cache */
     offv_t offset;          /* last read offset (info) */
-    offv_t buf_offset;      /* current buffer data start */
-    uint8_t* buf;           /* data buffer */
-    size_t buf_size;        /* max buffer size */
-    size_t valid_size;      /* current buffer size */
+    uint8_t* buf;           /* data buffer (all pages) */
+    size_t buf_size;        /* max buffer size (per page) */
     size_t file_size;       /* buffered file size */
+
+    /* Metas that jump between a header table and data (or multiple tables) would keep trashing
+     * a single buffer, so bigger buffers are split into N pages that are discarded in LRU order. */
+    stdio_page_t pages[STDIO_MAX_PAGES];
+    int page_count;         /* used pages */
+    int page_cur;           /* last used page */
+    uint32_t page_uses;     /* LRU counter */
+    size_t page_size;       /* config: reopens with bigger buffer sizes are split into pages of this size (0 = single buffer) */
+
+    dircache_t* dircache;   /* shared listings to skip opening missing files (optional) */
 } STDIO_STREAMFILE;
 
-static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size_t buf_size);
-static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char* const filename, size_t buf_size);
+static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size_t buf_size, size_t page_size);
+static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char* const filename, size_t buf_size, size_t page_size);
+
+/* reads a new chunk of data into the page */
+static stdio_page_t* stdio_fill_page(STDIO_STREAMFILE* sf, stdio_page_t* page, offv_t offset) {
+
+    /* position to new offset */
+    if (fseek_v(sf->infile, offset, SEEK_SET)) {
+        page->valid_size = 0;
+        return NULL; /* this shouldn't happen in our code */
+    }
+
+#if 0
+    /* old workaround for USE_STDIO_FDUP bug, keep it here for a while as a reminder just in case */
+    //fseek_v(sf->infile, ftell_v(sf->infile), SEEK_SET);
+#endif
+
+    page->offset = offset;
+    page->valid_size = fread(page->buf, sizeof(uint8_t), sf->buf_size, sf->infile);
+    //;VGM_LOG("stdio: read page %i %lx + %x\n", (int)(page - sf->pages), page->offset, page->valid_size);
+
+    if (page->valid_size == 0)
+        return NULL;
+    return page;
+}
+
+/* returns least recently used page, to be refilled */
+static stdio_page_t* stdio_get_lru_page(STDIO_STREAMFILE* sf) {
+    int i;
+    int lru = 0;
+
+    for (i = 1; i < sf->page_count; i++) {
+        if (sf->pages[i].last_used < sf->pages[lru].last_used)
+            lru = i;
+    }
+
+    return &sf->pages[lru];
+}
+
+static void stdio_use_page(STDIO_STREAMFILE* sf, stdio_page_t* page) {
+    sf->page_cur = page - sf->pages;
+    sf->page_uses++;
+    page->last_used = sf->page_uses;
+}
+
+/* finds the page with data at offset (reading it if needed), or NULL on EOF/errors */
+static stdio_page_t* stdio_get_page(STDIO_STREAMFILE* sf, offv_t offset) {
+    stdio_page_t* page;
+    int i;
+
+    /* current page first, as reads are mostly sequential */
+    page = &sf->pages[sf->page_cur];
+    if (offset >= page->offset && offset < page->offset + page->valid_size)
+        return page;
+
+    for (i = 0; i < sf->page_count; i++) {
+        page = &sf->pages[i];
+        if (offset >= page->offset && offset < page->offset + page->valid_size) {
+            stdio_use_page(sf, page);
+            return page;
+        }
+    }
+
+    /* possible if all data was copied to buf and FD closed */
+    if (!sf->infile)
+        return NULL;
+
+    /* ignore requests at EOF */
+    if (offset >= sf->file_size) {
+        //offset = sf->file_size; /* seems fseek doesn't clamp offset */
+        VGM_ASSERT_ONCE(offset > sf->file_size, "STDIO: reading over file_size 0x%x @ 0x%x\n", sf->file_size, (uint32_t)offset);
+        return NULL;
+    }
+
+    /* fill a new page (aligned when using multiple so they don't overlap) */
+    page = stdio_get_lru_page(sf);
+    stdio_use_page(sf, page);
+    if (sf->page_count > 1)
+        return stdio_fill_page(sf, page, offset - (offset % sf->buf_size));
+    return stdio_fill_page(sf, page, offset);
+}
 
 static size_t stdio_read(STDIO_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
     size_t read_total = 0;
@@ -101,88 +212,54 @@ static size_t stdio_read(STDIO_STREAMFILE* sf, uint8_t* dst, offv_t offset, size
     if (/*!sf->infile ||*/ !dst || length <= 0 || offset < 0)
         return 0;
 
-    //;VGM_LOG("stdio: read %lx + %x (buf %lx + %x)\n", offset, length, sf->buf_offset, sf->valid_size, sf->buf_size);
+    //;VGM_LOG("stdio: read %lx + %x\n", offset, length);
 
-    /* is the part of the requested length in the buffer? */
-    if (offset >= sf->buf_offset && offset < sf->buf_offset + sf->valid_size) {
+    while (length > 0) {
         size_t buf_limit;
-        int buf_into = (int)(offset - sf->buf_offset);
+        int buf_into;
+        stdio_page_t* page = stdio_get_page(sf, offset);
+        if (!page)
+            break;
 
-        buf_limit = sf->valid_size - buf_into;
+        buf_into = (int)(offset - page->offset);
+        buf_limit = page->valid_size - buf_into;
         if (buf_limit > length)
             buf_limit = length;
 
-        //;VGM_LOG("stdio: copy buf %lx + %x (+ %x) (buf %lx + %x)\n", offset, length_to_read, (length - length_to_read), sf->buf_offset, sf->valid_size);
-
-        memcpy(dst, sf->buf + buf_into, buf_limit);
+        memcpy(dst, page->buf + buf_into, buf_limit);
         read_total += buf_limit;
         length -= buf_limit;
         offset += buf_limit;
         dst += buf_limit;
     }
 
-#ifdef VGM_DEBUG_OUTPUT
-    if (offset < sf->buf_offset && length > 0) {
-        //VGM_LOG("stdio: rebuffer, requested %x vs %x (sf %x)\n", (uint32_t)offset, (uint32_t)sf->buf_offset, (uint32_t)sf);
-        //sf->rebuffer++;
-        //if (rebuffer > N) ...
-    }
-#endif
-
-    /* possible if all data was copied to buf and FD closed */
-    if (!sf->infile)
-        return read_total;
-
-    /* read the rest of the requested length */
-    while (length > 0) {
-        size_t length_to_read;
-
-        /* ignore requests at EOF */
-        if (offset >= sf->file_size) {
-            //offset = sf->file_size; /* seems fseek doesn't clamp offset */
-            VGM_ASSERT_ONCE(offset > sf->file_size, "STDIO: reading over file_size 0x%x @ 0x%x + 0x%x\n", sf->file_size, (uint32_t)offset, length);
-            break;
-        }
-
-        /* position to new offset */
-        if (fseek_v(sf->infile, offset, SEEK_SET)) {
-            break; /* this shouldn't happen in our code */
-        }
+    sf->offset = offset; /* last fread offset */
+    return read_total;
+}
 
-#if 0
-        /* old workaround for USE_STDIO_FDUP bug, keep it here for a while as a reminder just in case */
-        //fseek_v(sf->infile, ftell_v(sf->infile), SEEK_SET);
-#endif
+static const uint8_t* stdio_peek(STDIO_STREAMFILE* sf, offv_t offset, size_t length) {
+    stdio_page_t* page;
 
-        /* fill the buffer (offset now is beyond buf_offset) */
-        sf->buf_offset = offset;
-        sf->valid_size = fread(sf->buf, sizeof(uint8_t), sf->buf_size, sf->infile);
-        //;VGM_LOG("stdio: read buf %lx + %x\n", sf->buf_offset, sf->valid_size);
+    if (length <= 0 || offset < 0)
+        return NULL;
 
-        /* decide how much must be read this time */
-        if (length > sf->buf_size)
-            length_to_read = sf->buf_size;
-        else
-            length_to_read = length;
+    page = stdio_get_page(sf, offset);
+    if (!page)
+        return NULL;
 
-        /* give up on partial reads (EOF) */
-        if (sf->valid_size < length_to_read) {
-            memcpy(dst, sf->buf, sf->valid_size);
-            offset += sf->valid_size;
-            read_total += sf->valid_size;
-            break;
-        }
+    /* data crosses buffer: refill it at offset, if it fits (partial EOF reads are left to regular reads).
+     * Pages are kept aligned so they never overlap, so data crossing them is left to regular reads too. */
+    if (offset + length > page->offset + page->valid_size) {
+        if (sf->page_count > 1 || !sf->infile || length > sf->buf_size || offset + length > sf->file_size)
+            return NULL;
 
-        /* use the new buffer */
-        memcpy(dst, sf->buf, length_to_read);
-        offset += length_to_read;
-        read_total += length_to_read;
-        length -= length_to_read;
-        dst += length_to_read;
+        page = stdio_fill_page(sf, page, offset);
+        if (!page || page->valid_size < length)
+            return NULL;
     }
 
-    sf->offset = offset; /* last fread offset */
-    return read_total;
+    sf->offset = offset + length; /* last read offset */
+    return page->buf + (offset - page->offset);
 }
 
 static size_t stdio_get_size(STDIO_STREAMFILE* sf) {
@@ -202,7 +279,16 @@ static void stdio_get_name(STDIO_STREAMFILE* sf, char* name, size_t name_size) {
     name[copy_size - 1] = '\0';
 }
 
+/* passes shared config to a newly opened SF */
+static STREAMFILE* stdio_set_dircache(STREAMFILE* new_sf, dircache_t* dircache) {
+    if (new_sf && dircache)
+        ((STDIO_STREAMFILE*)new_sf)->dircache = dircache_ref(dircache);
+    return new_sf;
+}
+
 static STREAMFILE* stdio_open(STDIO_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    STREAMFILE* new_sf;
+
     if (!filename)
         return NULL;
 
@@ -215,9 +301,9 @@ static STREAMFILE* stdio_open(STDIO_STREAMFILE* sf, const char* const filename,
         FILE *new_file = NULL;
 
         if (((new_fd = dup(fileno(sf->infile))) >= 0) && (new_file = fdopen(new_fd, "rb")))  {
-            STREAMFILE* new_sf = open_stdio_streamfile_buffer_by_file(new_file, filename, buf_size);
+            new_sf = open_stdio_streamfile_buffer_by_file(new_file, filename, buf_size, sf->page_size);
             if (new_sf)
-                return new_sf;
+                return stdio_set_dircache(new_sf, sf->dircache);
             fclose(new_file);
         }
         if (new_fd >= 0 && !new_file)
@@ -227,22 +313,44 @@ static STREAMFILE* stdio_open(STDIO_STREAMFILE* sf, const char* const filename,
     }
 #endif
 
-    return open_stdio_streamfile_buffer(filename, buf_size);
+    /* companion files (.txth, keys, etc) usually don't exist, so avoid failed opens if possible */
+    if (sf->dircache && dircache_is_missing(sf->dircache, filename) && !vgmstream_is_virtual_filename(filename))
+        return NULL;
+
+    new_sf = open_stdio_streamfile_buffer(filename, buf_size, sf->page_size);
+    return stdio_set_dircache(new_sf, sf->dircache);
 }
 
 static void stdio_close(STDIO_STREAMFILE* sf) {
     if (sf->infile)
         fclose(sf->infile);
+    dircache_free(sf->dircache);
     free(sf->buf);
     free(sf);
 }
 
 
-static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE* infile, const char* const filename, size_t buf_size) {
+static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE* infile, const char* const filename, size_t buf_size, size_t page_size) {
     uint8_t* buf = NULL;
     STDIO_STREAMFILE* this_sf = NULL;
+    size_t page_buf_size;
+    int i, page_count;
 
-    buf = calloc(buf_size, sizeof(uint8_t));
+    /* regular SFs use one buffer, while paged SFs split bigger sizes into pages (bigger than config if too many) */
+    if (page_size == 0 || buf_size <= page_size) {
+        page_count = 1;
+        page_buf_size = buf_size;
+    }
+    else {
+        page_count = (buf_size + page_size - 1) / page_size;
+        page_buf_size = page_size;
+        if (page_count > STDIO_MAX_PAGES) {
+            page_count = STDIO_MAX_PAGES;
+            page_buf_size = (buf_size + page_count - 1) / page_count;
+        }
+    }
+
+    buf = calloc(page_buf_size * page_count, sizeof(uint8_t));
     if (!buf) goto fail;
 
     this_sf = calloc(1, sizeof(STDIO_STREAMFILE));
@@ -254,11 +362,18 @@ static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE* infile, const char
     this_sf->vt.get_name = (void*)stdio_get_name;
     this_sf->vt.open = (void*)stdio_open;
     this_sf->vt.close = (void*)stdio_close;
+    this_sf->vt.peek = (void*)stdio_peek;
 
     this_sf->infile = infile;
-    this_sf->buf_size = buf_size;
+    this_sf->buf_size = page_buf_size;
     this_sf->buf = buf;
 
+    this_sf->page_size = page_size;
+    this_sf->page_count = page_count;
+    for (i = 0; i < page_count; i++) {
+        this_sf->pages[i].buf = buf + page_buf_size * i;
+    }
+
     this_sf->name_len = strlen(filename);
     if (this_sf->name_len >= sizeof(this_sf->name))
         goto fail;
@@ -288,11 +403,14 @@ static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE* infile, const char
      * For the time being, if the file is smaller that buffer we can just read it fully and close the FD,
      * that should help since big TXTP usually just need many small files.
      * Doubles as an optimization as most files given will be read fully into buf on first read. */
-    if (this_sf->file_size && this_sf->file_size < this_sf->buf_size && this_sf->infile) {
+    if (this_sf->file_size && this_sf->file_size < page_buf_size * page_count && this_sf->infile) {
         //;VGM_LOG("stdio: fit filesize %x into buf %x\n", sf->file_size, sf->buf_size);
 
-        this_sf->buf_offset = 0;
-        this_sf->valid_size = fread(this_sf->buf, sizeof(uint8_t), this_sf->file_size, this_sf->infile);
+        /* pages are contiguous so just use the first one for the whole file */
+        this_sf->page_count = 1;
+        this_sf->buf_size = page_buf_size * page_count;
+        this_sf->pages[0].offset = 0;
+        this_sf->pages[0].valid_size = fread(this_sf->buf, sizeof(uint8_t), this_sf->file_size, this_sf->infile);
 
         fclose(this_sf->infile);
         this_sf->infile = NULL;
@@ -306,7 +424,7 @@ fail:
     return NULL;
 }
 
-static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size_t bufsize) {
+static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size_t bufsize, size_t page_size) {
     FILE* infile = NULL;
     STREAMFILE* sf = NULL;
 
@@ -317,7 +435,7 @@ static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size
             return NULL;
     }
 
-    sf = open_stdio_streamfile_buffer_by_file(infile, filename, bufsize);
+    sf = open_stdio_streamfile_buffer_by_file(infile, filename, bufsize, page_size);
     if (!sf) {
         if (infile) fclose(infile);
     }
@@ -326,30 +444,280 @@ static STREAMFILE* open_stdio_streamfile_buffer(const char* const filename, size
 }
 
 STREAMFILE* open_stdio_streamfile(const char* filename) {
-    return open_stdio_streamfile_buffer(filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    return open_stdio_streamfile_buffer(filename, STREAMFILE_DEFAULT_BUFFER_SIZE, 0);
 }
 
 STREAMFILE* open_stdio_streamfile_by_file(FILE* file, const char* filename) {
-    return open_stdio_streamfile_buffer_by_file(file, filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    return open_stdio_streamfile_buffer_by_file(file, filename, STREAMFILE_DEFAULT_BUFFER_SIZE, 0);
+}
+
+STREAMFILE* open_stdio_streamfile_dircache(const char* filename, dircache_t* dircache) {
+    STREAMFILE* sf = open_stdio_streamfile(filename);
+    return stdio_set_dircache(sf, dircache);
+}
+
+STREAMFILE* open_stdio_streamfile_paged(const char* filename, size_t page_size, int page_count, dircache_t* dircache) {
+    STREAMFILE* sf;
+
+    if (page_size == 0)
+        page_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    if (page_count <= 0)
+        page_count = 1;
+    sf = open_stdio_streamfile_buffer(filename, page_size * page_count, page_size);
+    return stdio_set_dircache(sf, dircache);
 }
 
 /* **************************************************** */
 
+#ifdef USE_MMAP
+/* mapped file, shared between all SFs that reopen the same filename (one per channel and so on) */
 typedef struct {
-    STREAMFILE vt;
+    volatile int refs;      /* SFs using this map (may be opened/closed from different threads) */
+    uint8_t* data;          /* whole file */
+    size_t size;            /* mapped file size */
+} mmap_file_t;
 
-    STREAMFILE* inner_sf;
+/* a STREAMFILE that reads directly from a memory-mapped file */
+typedef struct {
+    STREAMFILE vt;          /* callbacks */
+
+    mmap_file_t* map;       /* shared mapping */
+    char name[PATH_LIMIT];  /* mapped filename */
+    int name_len;           /* cache */
+    offv_t offset;          /* last read offset (info) */
+    dircache_t* dircache;   /* shared listings to skip opening missing files (optional) */
+} MMAP_STREAMFILE;
+
+static STREAMFILE* open_mmap_streamfile_by_map(mmap_file_t* map, const char* const filename, dircache_t* dircache);
+static STREAMFILE* open_mmap_streamfile_file(const char* const filename, dircache_t* dircache);
+
+static size_t mmap_read(MMAP_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    size_t file_size = sf->map->size;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    /* ignore requests at EOF */
+    if (offset >= file_size) {
+        VGM_ASSERT_ONCE(offset > file_size, "MMAP: reading over file_size 0x%x @ 0x%x + 0x%x\n", file_size, (uint32_t)offset, length);
+        return 0;
+    }
+
+    if (offset + length > file_size)
+        length = file_size - offset;
+
+    memcpy(dst, sf->map->data + offset, length);
+
+    sf->offset = offset + length; /* last read offset */
+    return length;
+}
+
+static const uint8_t* mmap_peek(MMAP_STREAMFILE* sf, offv_t offset, size_t length) {
+    if (length <= 0 || offset < 0 || offset + length > sf->map->size)
+        return NULL;
+
+    sf->offset = offset + length; /* last read offset */
+    return sf->map->data + offset;
+}
+
+static size_t mmap_get_size(MMAP_STREAMFILE* sf) {
+    return sf->map->size;
+}
+
+static offv_t mmap_get_offset(MMAP_STREAMFILE* sf) {
+    return sf->offset;
+}
+
+static void mmap_get_name(MMAP_STREAMFILE* sf, char* name, size_t name_size) {
+    int copy_size = sf->name_len + 1;
+    if (copy_size > name_size)
+        copy_size = name_size;
+
+    memcpy(name, sf->name, copy_size);
+    name[copy_size - 1] = '\0';
+}
+
+static STREAMFILE* mmap_open(MMAP_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    if (!filename)
+        return NULL;
+
+    /* same file: share the mapping (buffer size is meaningless here) */
+    if (!strcmp(sf->name, filename)) {
+        STREAMFILE* new_sf = open_mmap_streamfile_by_map(sf->map, filename, sf->dircache);
+        if (new_sf)
+            return new_sf;
+    }
+
+    /* skip companion files known to be missing */
+    if (sf->dircache && dircache_is_missing(sf->dircache, filename) && !vgmstream_is_virtual_filename(filename))
+        return NULL;
+
+    return open_mmap_streamfile_file(filename, sf->dircache);
+}
+
+static void mmap_close(MMAP_STREAMFILE* sf) {
+    mmap_file_t* map = sf->map;
+
+    if (vgm_atomic_dec(&map->refs) <= 0) {
+        munmap(map->data, map->size);
+        free(map);
+    }
+    dircache_free(sf->dircache);
+    free(sf);
+}
+
+static STREAMFILE* open_mmap_streamfile_by_map(mmap_file_t* map, const char* const filename, dircache_t* dircache) {
+    MMAP_STREAMFILE* this_sf = NULL;
+
+    this_sf = calloc(1, sizeof(MMAP_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->vt.read = (void*)mmap_read;
+    this_sf->vt.get_size = (void*)mmap_get_size;
+    this_sf->vt.get_offset = (void*)mmap_get_offset;
+    this_sf->vt.get_name = (void*)mmap_get_name;
+    this_sf->vt.open = (void*)mmap_open;
+    this_sf->vt.close = (void*)mmap_close;
+    this_sf->vt.peek = (void*)mmap_peek;
+
+    this_sf->name_len = strlen(filename);
+    if (this_sf->name_len >= sizeof(this_sf->name))
+        goto fail;
+    memcpy(this_sf->name, filename, this_sf->name_len);
+    this_sf->name[this_sf->name_len] = '\0';
+
+    this_sf->map = map;
+    vgm_atomic_inc(&map->refs);
+    if (dircache)
+        this_sf->dircache = dircache_ref(dircache);
+
+    return &this_sf->vt;
+
+fail:
+    free(this_sf);
+    return NULL;
+}
+
+static mmap_file_t* mmap_file_open(const char* const filename) {
+    mmap_file_t* map = NULL;
+    struct stat st;
+    void* data;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    /* empty files can't be mapped, and 32-bit systems can't map +4GB (let stdio handle those) */
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uint64_t)st.st_size > (size_t)-1)
+        goto fail;
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+        goto fail;
+    close(fd); /* mapping stays valid */
+    fd = -1;
+
+    map = calloc(1, sizeof(mmap_file_t));
+    if (!map) {
+        munmap(data, (size_t)st.st_size);
+        return NULL;
+    }
+
+    map->data = data;
+    map->size = (size_t)st.st_size;
+    return map;
+
+fail:
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+static STREAMFILE* open_mmap_streamfile_file(const char* const filename, dircache_t* dircache) {
+    mmap_file_t* map;
+    STREAMFILE* sf;
+
+    map = mmap_file_open(filename);
+    if (!map) {
+        /* non-mappable (empty/virtual/special) files use regular IO */
+        return open_stdio_streamfile_dircache(filename, dircache);
+    }
+
+    sf = open_mmap_streamfile_by_map(map, filename, dircache);
+    if (!sf) {
+        munmap(map->data, map->size);
+        free(map);
+        return NULL;
+    }
+
+    return sf;
+}
+#endif
+
+STREAMFILE* open_mmap_streamfile(const char* filename) {
+    return open_mmap_streamfile_dircache(filename, NULL);
+}
+
+STREAMFILE* open_mmap_streamfile_dircache(const char* filename, dircache_t* dircache) {
+    if (!filename)
+        return NULL;
+#ifdef USE_MMAP
+    return open_mmap_streamfile_file(filename, dircache);
+#else
+    return open_stdio_streamfile_dircache(filename, dircache);
+#endif
+}
+
+/* **************************************************** */
+
+#ifdef USE_PREAD
+/* file descriptor, shared between all SFs that reopen the same filename. Since pread doesn't change
+ * the fd position (unlike fseek+fread), clones may read from different threads at the same time. */
+typedef struct {
+    volatile int refs;      /* SFs using this fd (may be opened/closed from different threads) */
+    int fd;                 /* actual file */
+    size_t size;            /* file size */
+} pread_file_t;
+
+/* a STREAMFILE that reads via pread on a shared file descriptor, using a buffer */
+typedef struct {
+    STREAMFILE vt;          /* callbacks */
+
+    pread_file_t* file;     /* shared fd */
+    char name[PATH_LIMIT];  /* fd filename */
+    int name_len;           /* cache */
     offv_t offset;          /* last read offset (info) */
     offv_t buf_offset;      /* current buffer data start */
     uint8_t* buf;           /* data buffer */
     size_t buf_size;        /* max buffer size */
     size_t valid_size;      /* current buffer size */
-    size_t file_size;       /* buffered file size */
-} BUFFER_STREAMFILE;
 
+    dircache_t* dircache;   /* shared listings to skip opening missing files (optional) */
+} PREAD_STREAMFILE;
 
-static size_t buffer_read(BUFFER_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+static STREAMFILE* open_pread_streamfile_by_file(pread_file_t* file, const char* const filename, size_t buf_size, dircache_t* dircache);
+static STREAMFILE* open_pread_streamfile_buffer(const char* const filename, size_t buf_size, dircache_t* dircache);
+
+/* pread may return less than requested (signals, big sizes) */
+static size_t pread_full(int fd, uint8_t* dst, offv_t offset, size_t length) {
+    size_t done = 0;
+
+    while (done < length) {
+        ssize_t bytes = pread(fd, dst + done, length - done, (off_t)(offset + done));
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+            break;
+        done += bytes;
+    }
+
+    return done;
+}
+
+static size_t pread_read(PREAD_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
     size_t read_total = 0;
+    size_t file_size = sf->file->size;
 
     if (!dst || length <= 0 || offset < 0)
         return 0;
@@ -370,28 +738,421 @@ static size_t buffer_read(BUFFER_STREAMFILE* sf, uint8_t* dst, offv_t offset, si
         dst += buf_limit;
     }
 
-#ifdef VGM_DEBUG_OUTPUT
-    if (offset < sf->buf_offset) {
-        //VGM_LOG("buffer: rebuffer, requested %x vs %x (sf %x)\n", (uint32_t)offset, (uint32_t)sf->buf_offset, (uint32_t)sf);
-    }
-#endif
-
-    /* read the rest of the requested length */
-    while (length > 0) {
-        size_t buf_limit;
-
+    if (length > 0) {
         /* ignore requests at EOF */
-        if (offset >= sf->file_size) {
-            //offset = sf->file_size; /* seems fseek doesn't clamp offset */
-            VGM_ASSERT_ONCE(offset > sf->file_size, "buffer: reading over file_size 0x%x @ 0x%x + 0x%x\n", sf->file_size, (uint32_t)offset, length);
-            break;
+        if (offset >= file_size) {
+            VGM_ASSERT_ONCE(offset > file_size, "PREAD: reading over file_size 0x%x @ 0x%x + 0x%x\n", file_size, (uint32_t)offset, length);
+        }
+        /* big reads go directly to dst, as buffering wouldn't help */
+        else if (length >= sf->buf_size) {
+            size_t bytes = pread_full(sf->file->fd, dst, offset, length);
+            offset += bytes;
+            read_total += bytes;
         }
+        /* fill the buffer and copy the rest */
+        else {
+            size_t buf_limit = length;
 
-        /* fill the buffer (offset now is beyond buf_offset) */
-        sf->buf_offset = offset;
-        sf->valid_size = sf->inner_sf->read(sf->inner_sf, sf->buf, sf->buf_offset, sf->buf_size);
+            sf->buf_offset = offset;
+            sf->valid_size = pread_full(sf->file->fd, sf->buf, sf->buf_offset, sf->buf_size);
 
-        /* decide how much must be read this time */
+            if (buf_limit > sf->valid_size) /* partial reads (EOF) */
+                buf_limit = sf->valid_size;
+
+            memcpy(dst, sf->buf, buf_limit);
+            offset += buf_limit;
+            read_total += buf_limit;
+        }
+    }
+
+    sf->offset = offset; /* last read offset */
+    return read_total;
+}
+
+static const uint8_t* pread_peek(PREAD_STREAMFILE* sf, offv_t offset, size_t length) {
+
+    if (length <= 0 || offset < 0)
+        return NULL;
+
+    /* refill buffer if needed; data that doesn't fit (or partial EOF reads) are left to regular reads */
+    if (offset < sf->buf_offset || offset + length > sf->buf_offset + sf->valid_size) {
+        if (length > sf->buf_size || offset + length > sf->file->size)
+            return NULL;
+
+        sf->buf_offset = offset;
+        sf->valid_size = pread_full(sf->file->fd, sf->buf, sf->buf_offset, sf->buf_size);
+        if (sf->valid_size < length)
+            return NULL;
+    }
+
+    sf->offset = offset + length; /* last read offset */
+    return sf->buf + (offset - sf->buf_offset);
+}
+
+static size_t pread_get_size(PREAD_STREAMFILE* sf) {
+    return sf->file->size;
+}
+
+static offv_t pread_get_offset(PREAD_STREAMFILE* sf) {
+    return sf->offset;
+}
+
+static void pread_get_name(PREAD_STREAMFILE* sf, char* name, size_t name_size) {
+    int copy_size = sf->name_len + 1;
+    if (copy_size > name_size)
+        copy_size = name_size;
+
+    memcpy(name, sf->name, copy_size);
+    name[copy_size - 1] = '\0';
+}
+
+static STREAMFILE* pread_open(PREAD_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    if (!filename)
+        return NULL;
+
+    /* same file: share the fd (no need to dup as position isn't used) */
+    if (!strcmp(sf->name, filename)) {
+        STREAMFILE* new_sf = open_pread_streamfile_by_file(sf->file, filename, buf_size, sf->dircache);
+        if (new_sf)
+            return new_sf;
+    }
+
+    /* same as stdio_open */
+    if (sf->dircache && dircache_is_missing(sf->dircache, filename) && !vgmstream_is_virtual_filename(filename))
+        return NULL;
+
+    return open_pread_streamfile_buffer(filename, buf_size, sf->dircache);
+}
+
+static void pread_close(PREAD_STREAMFILE* sf) {
+    pread_file_t* file = sf->file;
+
+    if (vgm_atomic_dec(&file->refs) <= 0) {
+        close(file->fd);
+        free(file);
+    }
+    dircache_free(sf->dircache);
+    free(sf->buf);
+    free(sf);
+}
+
+static STREAMFILE* open_pread_streamfile_by_file(pread_file_t* file, const char* const filename, size_t buf_size, dircache_t* dircache) {
+    uint8_t* buf = NULL;
+    PREAD_STREAMFILE* this_sf = NULL;
+
+    if (buf_size == 0)
+        buf_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
+    buf = calloc(buf_size, sizeof(uint8_t));
+    if (!buf) goto fail;
+
+    this_sf = calloc(1, sizeof(PREAD_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->vt.read = (void*)pread_read;
+    this_sf->vt.get_size = (void*)pread_get_size;
+    this_sf->vt.get_offset = (void*)pread_get_offset;
+    this_sf->vt.get_name = (void*)pread_get_name;
+    this_sf->vt.open = (void*)pread_open;
+    this_sf->vt.close = (void*)pread_close;
+    this_sf->vt.peek = (void*)pread_peek;
+
+    this_sf->buf_size = buf_size;
+    this_sf->buf = buf;
+
+    this_sf->name_len = strlen(filename);
+    if (this_sf->name_len >= sizeof(this_sf->name))
+        goto fail;
+    memcpy(this_sf->name, filename, this_sf->name_len);
+    this_sf->name[this_sf->name_len] = '\0';
+
+    this_sf->file = file;
+    vgm_atomic_inc(&file->refs);
+
+    if (dircache)
+        this_sf->dircache = dircache_ref(dircache);
+
+    return &this_sf->vt;
+
+fail:
+    free(buf);
+    free(this_sf);
+    return NULL;
+}
+
+static pread_file_t* pread_file_open(const char* const filename) {
+    pread_file_t* file = NULL;
+    struct stat st;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size > (size_t)-1)
+        goto fail;
+
+    file = calloc(1, sizeof(pread_file_t));
+    if (!file) goto fail;
+
+    file->fd = fd;
+    file->size = (size_t)st.st_size;
+    return file;
+
+fail:
+    close(fd);
+    return NULL;
+}
+
+static STREAMFILE* open_pread_streamfile_buffer(const char* const filename, size_t buf_size, dircache_t* dircache) {
+    pread_file_t* file;
+    STREAMFILE* sf;
+
+    file = pread_file_open(filename);
+    if (!file) {
+        /* non-existing (virtual) or special files use regular IO */
+        return open_stdio_streamfile_dircache(filename, dircache);
+    }
+
+    sf = open_pread_streamfile_by_file(file, filename, buf_size, dircache);
+    if (!sf) {
+        close(file->fd);
+        free(file);
+        return NULL;
+    }
+
+    return sf;
+}
+#endif
+
+STREAMFILE* open_pread_streamfile(const char* filename) {
+    return open_pread_streamfile_dircache(filename, NULL);
+}
+
+STREAMFILE* open_pread_streamfile_dircache(const char* filename, dircache_t* dircache) {
+    if (!filename)
+        return NULL;
+#ifdef USE_PREAD
+    return open_pread_streamfile_buffer(filename, STREAMFILE_DEFAULT_BUFFER_SIZE, dircache);
+#else
+    return open_stdio_streamfile_dircache(filename, dircache);
+#endif
+}
+
+/* **************************************************** */
+
+/* caller's buffer, shared between all SFs opened from the same memory SF */
+typedef struct {
+    volatile int refs;      /* SFs using this buffer (may be opened/closed from different threads) */
+    const uint8_t* data;    /* caller's data (not copied) */
+    size_t size;            /* data size */
+    void (*free_cb)(void* data); /* called with data once no SF uses it (optional) */
+    STREAMFILE* (*open_cb)(void* user_data, const char* filename); /* opens companion files (optional) */
+    void* user_data;        /* open_cb's state */
+} memory_file_t;
+
+/* a STREAMFILE that reads directly from a memory buffer */
+typedef struct {
+    STREAMFILE vt;          /* callbacks */
+
+    memory_file_t* mem;     /* shared buffer */
+    char name[PATH_LIMIT];  /* buffer's filename */
+    int name_len;           /* cache */
+    offv_t offset;          /* last read offset (info) */
+} MEMORY_STREAMFILE;
+
+static STREAMFILE* open_memory_streamfile_by_mem(memory_file_t* mem, const char* const filename);
+
+static size_t memory_read(MEMORY_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    size_t data_size = sf->mem->size;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    /* ignore requests at EOF */
+    if (offset >= data_size) {
+        VGM_ASSERT_ONCE(offset > data_size, "MEMORY: reading over data_size 0x%x @ 0x%x + 0x%x\n", data_size, (uint32_t)offset, length);
+        return 0;
+    }
+
+    if (offset + length > data_size)
+        length = data_size - offset;
+
+    memcpy(dst, sf->mem->data + offset, length);
+
+    sf->offset = offset + length; /* last read offset */
+    return length;
+}
+
+static const uint8_t* memory_peek(MEMORY_STREAMFILE* sf, offv_t offset, size_t length) {
+    if (length <= 0 || offset < 0 || offset + length > sf->mem->size)
+        return NULL;
+
+    sf->offset = offset + length; /* last read offset */
+    return sf->mem->data + offset;
+}
+
+static size_t memory_get_size(MEMORY_STREAMFILE* sf) {
+    return sf->mem->size;
+}
+
+static offv_t memory_get_offset(MEMORY_STREAMFILE* sf) {
+    return sf->offset;
+}
+
+static void memory_get_name(MEMORY_STREAMFILE* sf, char* name, size_t name_size) {
+    int copy_size = sf->name_len + 1;
+    if (copy_size > name_size)
+        copy_size = name_size;
+
+    memcpy(name, sf->name, copy_size);
+    name[copy_size - 1] = '\0';
+}
+
+static STREAMFILE* memory_open(MEMORY_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    if (!filename)
+        return NULL;
+
+    /* same file: share the buffer */
+    if (!strcmp(sf->name, filename))
+        return open_memory_streamfile_by_mem(sf->mem, filename);
+
+    /* companion files (.acb for .awb, .txth, etc) must come from the caller */
+    if (!sf->mem->open_cb)
+        return NULL;
+    return sf->mem->open_cb(sf->mem->user_data, filename);
+}
+
+static void memory_close(MEMORY_STREAMFILE* sf) {
+    memory_file_t* mem = sf->mem;
+
+    if (vgm_atomic_dec(&mem->refs) <= 0) {
+        if (mem->free_cb)
+            mem->free_cb((void*)mem->data);
+        free(mem);
+    }
+    free(sf);
+}
+
+static STREAMFILE* open_memory_streamfile_by_mem(memory_file_t* mem, const char* const filename) {
+    MEMORY_STREAMFILE* this_sf = NULL;
+
+    this_sf = calloc(1, sizeof(MEMORY_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->vt.read = (void*)memory_read;
+    this_sf->vt.get_size = (void*)memory_get_size;
+    this_sf->vt.get_offset = (void*)memory_get_offset;
+    this_sf->vt.get_name = (void*)memory_get_name;
+    this_sf->vt.open = (void*)memory_open;
+    this_sf->vt.close = (void*)memory_close;
+    this_sf->vt.peek = (void*)memory_peek;
+
+    this_sf->name_len = strlen(filename);
+    if (this_sf->name_len >= sizeof(this_sf->name))
+        goto fail;
+    memcpy(this_sf->name, filename, this_sf->name_len);
+    this_sf->name[this_sf->name_len] = '\0';
+
+    this_sf->mem = mem;
+    vgm_atomic_inc(&mem->refs);
+
+    return &this_sf->vt;
+
+fail:
+    free(this_sf);
+    return NULL;
+}
+
+STREAMFILE* open_memory_streamfile_ex(const uint8_t* data, size_t size, const char* name, void (*free_cb)(void* data),
+        STREAMFILE* (*open_cb)(void* user_data, const char* filename), void* user_data) {
+    memory_file_t* mem = NULL;
+    STREAMFILE* sf;
+
+    if (!data || !name)
+        return NULL;
+
+    mem = calloc(1, sizeof(memory_file_t));
+    if (!mem) return NULL;
+
+    mem->data = data;
+    mem->size = size;
+    mem->free_cb = free_cb;
+    mem->open_cb = open_cb;
+    mem->user_data = user_data;
+
+    sf = open_memory_streamfile_by_mem(mem, name);
+    if (!sf) {
+        free(mem); /* data is still the caller's */
+        return NULL;
+    }
+
+    return sf;
+}
+
+STREAMFILE* open_memory_streamfile(const uint8_t* data, size_t size, const char* name, void (*free_cb)(void* data)) {
+    return open_memory_streamfile_ex(data, size, name, free_cb, NULL, NULL);
+}
+
+/* **************************************************** */
+
+typedef struct {
+    STREAMFILE vt;
+
+    STREAMFILE* inner_sf;
+    offv_t offset;          /* last read offset (info) */
+    offv_t buf_offset;      /* current buffer data start */
+    uint8_t* buf;           /* data buffer */
+    size_t buf_size;        /* max buffer size */
+    size_t valid_size;      /* current buffer size */
+    size_t file_size;       /* buffered file size */
+} BUFFER_STREAMFILE;
+
+
+static size_t buffer_read(BUFFER_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    size_t read_total = 0;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    /* is the part of the requested length in the buffer? */
+    if (offset >= sf->buf_offset && offset < sf->buf_offset + sf->valid_size) {
+        size_t buf_limit;
+        int buf_into = (int)(offset - sf->buf_offset);
+
+        buf_limit = sf->valid_size - buf_into;
+        if (buf_limit > length)
+            buf_limit = length;
+
+        memcpy(dst, sf->buf + buf_into, buf_limit);
+        read_total += buf_limit;
+        length -= buf_limit;
+        offset += buf_limit;
+        dst += buf_limit;
+    }
+
+#ifdef VGM_DEBUG_OUTPUT
+    if (offset < sf->buf_offset) {
+        //VGM_LOG("buffer: rebuffer, requested %x vs %x (sf %x)\n", (uint32_t)offset, (uint32_t)sf->buf_offset, (uint32_t)sf);
+    }
+#endif
+
+    /* read the rest of the requested length */
+    while (length > 0) {
+        size_t buf_limit;
+
+        /* ignore requests at EOF */
+        if (offset >= sf->file_size) {
+            //offset = sf->file_size; /* seems fseek doesn't clamp offset */
+            VGM_ASSERT_ONCE(offset > sf->file_size, "buffer: reading over file_size 0x%x @ 0x%x + 0x%x\n", sf->file_size, (uint32_t)offset, length);
+            break;
+        }
+
+        /* fill the buffer (offset now is beyond buf_offset) */
+        sf->buf_offset = offset;
+        sf->valid_size = sf->inner_sf->read(sf->inner_sf, sf->buf, sf->buf_offset, sf->buf_size);
+
+        /* decide how much must be read this time */
         if (length > sf->buf_size)
             buf_limit = sf->buf_size;
         else
@@ -416,6 +1177,25 @@ static size_t buffer_read(BUFFER_STREAMFILE* sf, uint8_t* dst, offv_t offset, si
     sf->offset = offset; /* last fread offset */
     return read_total;
 }
+static const uint8_t* buffer_peek(BUFFER_STREAMFILE* sf, offv_t offset, size_t length) {
+
+    if (length <= 0 || offset < 0)
+        return NULL;
+
+    /* refill buffer if needed (same as stdio) */
+    if (offset < sf->buf_offset || offset + length > sf->buf_offset + sf->valid_size) {
+        if (length > sf->buf_size || offset + length > sf->file_size)
+            return NULL;
+
+        sf->buf_offset = offset;
+        sf->valid_size = sf->inner_sf->read(sf->inner_sf, sf->buf, sf->buf_offset, sf->buf_size);
+        if (sf->valid_size < length)
+            return NULL;
+    }
+
+    sf->offset = offset + length; /* last read offset */
+    return sf->buf + (offset - sf->buf_offset);
+}
 static size_t buffer_get_size(BUFFER_STREAMFILE* sf) {
     return sf->file_size; /* cache */
 }
@@ -443,39 +1223,501 @@ STREAMFILE* open_buffer_streamfile(STREAMFILE* sf, size_t buf_size) {
 
     if (!sf) goto fail;
 
-    if (buf_size == 0)
-        buf_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    if (buf_size == 0)
+        buf_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
+    buf = calloc(buf_size, sizeof(uint8_t));
+    if (!buf) goto fail;
+
+    this_sf = calloc(1, sizeof(BUFFER_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    /* set callbacks and internals */
+    this_sf->vt.read = (void*)buffer_read;
+    this_sf->vt.get_size = (void*)buffer_get_size;
+    this_sf->vt.get_offset = (void*)buffer_get_offset;
+    this_sf->vt.get_name = (void*)buffer_get_name;
+    this_sf->vt.open = (void*)buffer_open;
+    this_sf->vt.close = (void*)buffer_close;
+    this_sf->vt.peek = (void*)buffer_peek;
+    this_sf->vt.stream_index = sf->stream_index;
+
+    this_sf->inner_sf = sf;
+    this_sf->buf_size = buf_size;
+    this_sf->buf = buf;
+
+    this_sf->file_size = sf->get_size(sf);
+
+    return &this_sf->vt;
+
+fail:
+    if (this_sf) free(this_sf->buf);
+    free(this_sf);
+    return NULL;
+}
+STREAMFILE* open_buffer_streamfile_f(STREAMFILE* sf, size_t buffer_size) {
+    STREAMFILE* new_sf = open_buffer_streamfile(sf, buffer_size);
+    if (!new_sf)
+        close_streamfile(sf);
+    return new_sf;
+}
+
+/* **************************************************** */
+
+#define READAHEAD_DEFAULT_DEPTH  4
+
+enum { RA_EMPTY, RA_PENDING, RA_LOADING, RA_READY };
+
+/* a window of file data, filled by the background thread */
+typedef struct {
+    int state;              /* RA_x */
+    offv_t offset;          /* window data start (aligned to window size) */
+    size_t valid_size;      /* window data size (less than window size at EOF) */
+    uint8_t* buf;           /* window data (part of main buf) */
+} readahead_window_t;
+
+typedef struct READAHEAD_STREAMFILE READAHEAD_STREAMFILE;
+
+/* worker thread shared by a readahead SF and all SFs opened from it (like one per channel),
+ * so reopens don't need a thread each */
+typedef struct {
+    int refs;               /* SFs using the worker */
+    READAHEAD_STREAMFILE* sfs; /* list of open SFs, to find requested windows */
+    uint32_t serves;        /* counter to serve SFs in turns */
+
+    vgm_thread_t* thread;
+    vgm_mutex_t* mutex;     /* protects all fields, and window states/SF fields used by the worker */
+    vgm_cond_t* cond_work;  /* signaled when windows are requested (or on close) */
+    vgm_cond_t* cond_done;  /* signaled when windows are loaded */
+    int stop;
+} readahead_shared_t;
+
+/* A STREAMFILE that reads windows of data in a background thread. When reads look sequential,
+ * next windows are requested in advance, so the caller doesn't need to wait on slow IO.
+ * Only the thread reads from inner_sf (so it doesn't need to be thread-safe). */
+struct READAHEAD_STREAMFILE {
+    STREAMFILE vt;
+
+    STREAMFILE* inner_sf;
+    offv_t offset;          /* last read offset (info) */
+    size_t file_size;       /* cache */
+    size_t window_size;     /* size of each window */
+    int depth;              /* windows to read ahead */
+
+    uint8_t* buf;           /* data for all windows */
+    readahead_window_t* windows;
+    int window_count;       /* current window + depth */
+    offv_t next_offset;     /* end of last read, to detect sequential reads */
+
+    readahead_shared_t* shared;
+    READAHEAD_STREAMFILE* next; /* in shared list */
+    int waiting;            /* caller is waiting on a window */
+    uint32_t last_served;   /* shared counter when the worker last loaded a window for this SF */
+};
+
+static STREAMFILE* open_readahead_streamfile_shared(STREAMFILE* sf, readahead_shared_t* shared, size_t window_size, int depth);
+
+/* returns the next window to load: waited ones first, then from SFs that were served longest ago
+ * (closest window first), so one SF reading ahead doesn't stall others */
+static readahead_window_t* readahead_next_request(readahead_shared_t* shared, READAHEAD_STREAMFILE** p_sf) {
+    READAHEAD_STREAMFILE* sf;
+    READAHEAD_STREAMFILE* best_sf = NULL;
+    readahead_window_t* best = NULL;
+
+    for (sf = shared->sfs; sf != NULL; sf = sf->next) {
+        readahead_window_t* window = NULL;
+        int i;
+
+        for (i = 0; i < sf->window_count; i++) {
+            readahead_window_t* w = &sf->windows[i];
+            if (w->state == RA_PENDING && (!window || w->offset < window->offset))
+                window = w;
+        }
+        if (!window)
+            continue;
+
+        if (!best_sf || (sf->waiting && !best_sf->waiting)
+                || (sf->waiting == best_sf->waiting && sf->last_served < best_sf->last_served)) {
+            best_sf = sf;
+            best = window;
+        }
+    }
+
+    *p_sf = best_sf;
+    return best;
+}
+
+static void readahead_worker(void* arg) {
+    readahead_shared_t* shared = arg;
+
+    vgm_mutex_lock(shared->mutex);
+    while (!shared->stop) {
+        READAHEAD_STREAMFILE* sf;
+        readahead_window_t* window;
+        size_t bytes;
+        offv_t offset;
+
+        window = readahead_next_request(shared, &sf);
+        if (!window) {
+            vgm_cond_wait(shared->cond_work, shared->mutex);
+            continue;
+        }
+
+        window->state = RA_LOADING; /* SF can't be closed until loaded */
+        offset = window->offset;
+        shared->serves++;
+        sf->last_served = shared->serves;
+
+        vgm_mutex_unlock(shared->mutex);
+        bytes = sf->inner_sf->read(sf->inner_sf, window->buf, offset, sf->window_size);
+        vgm_mutex_lock(shared->mutex);
+
+        window->valid_size = bytes;
+        window->state = RA_READY;
+        vgm_cond_broadcast(shared->cond_done);
+    }
+    vgm_mutex_unlock(shared->mutex);
+}
+
+static readahead_window_t* readahead_find_window(READAHEAD_STREAMFILE* sf, offv_t window_offset) {
+    int i;
+
+    for (i = 0; i < sf->window_count; i++) {
+        readahead_window_t* w = &sf->windows[i];
+        if (w->state != RA_EMPTY && w->offset == window_offset)
+            return w;
+    }
+    return NULL;
+}
+
+/* gets a window that can be reused for new data, preferring unused, then ones behind the current position */
+static readahead_window_t* readahead_get_free_window(READAHEAD_STREAMFILE* sf, offv_t keep_offset, int allow_ahead) {
+    readahead_window_t* window = NULL;
+    int i;
+
+    for (i = 0; i < sf->window_count; i++) {
+        readahead_window_t* w = &sf->windows[i];
+        if (w->state == RA_EMPTY)
+            return w;
+    }
+
+    for (i = 0; i < sf->window_count; i++) {
+        readahead_window_t* w = &sf->windows[i];
+        if (w->state == RA_LOADING || w->offset == keep_offset)
+            continue;
+        if (w->offset < keep_offset)
+            return w;
+        /* otherwise the one furthest ahead */
+        if (allow_ahead && (!window || w->offset > window->offset))
+            window = w;
+    }
+
+    return window;
+}
+
+static void readahead_request_window(READAHEAD_STREAMFILE* sf, readahead_window_t* window, offv_t window_offset) {
+    window->state = RA_PENDING;
+    window->offset = window_offset;
+    window->valid_size = 0;
+    vgm_cond_signal(sf->shared->cond_work);
+}
+
+/* returns a loaded window with offset, waiting for the thread if needed */
+static readahead_window_t* readahead_get_window(READAHEAD_STREAMFILE* sf, offv_t offset) {
+    offv_t window_offset = offset - (offset % sf->window_size);
+    readahead_window_t* window;
+
+    window = readahead_find_window(sf, window_offset);
+    if (!window) {
+        int i;
+
+        /* a jump, so current requests are probably useless */
+        for (i = 0; i < sf->window_count; i++) {
+            if (sf->windows[i].state == RA_PENDING)
+                sf->windows[i].state = RA_EMPTY;
+        }
+
+        window = readahead_get_free_window(sf, window_offset, 1);
+        if (!window) /* shouldn't happen as the thread only loads one at a time */
+            return NULL;
+        readahead_request_window(sf, window, window_offset);
+    }
+
+    sf->waiting = 1;
+    while (window->state != RA_READY) {
+        vgm_cond_wait(sf->shared->cond_done, sf->shared->mutex);
+    }
+    sf->waiting = 0;
+
+    return window;
+}
+
+/* requests windows after current offset, if not already loaded */
+static void readahead_prefetch(READAHEAD_STREAMFILE* sf, offv_t offset) {
+    offv_t base_offset = offset - (offset % sf->window_size);
+    int i;
+
+    for (i = 1; i <= sf->depth; i++) {
+        offv_t window_offset = base_offset + sf->window_size * i;
+        readahead_window_t* window;
+
+        if (window_offset >= sf->file_size)
+            break;
+        if (readahead_find_window(sf, window_offset))
+            continue;
+
+        window = readahead_get_free_window(sf, base_offset, 0);
+        if (!window)
+            break;
+        readahead_request_window(sf, window, window_offset);
+    }
+}
+
+/* reads close to the last one (sequential, or slightly skipping/rewinding like decoders do) */
+static int readahead_is_sequential(READAHEAD_STREAMFILE* sf, offv_t offset) {
+    return offset + sf->window_size >= sf->next_offset && offset <= sf->next_offset + sf->window_size;
+}
+
+static void readahead_update(READAHEAD_STREAMFILE* sf, offv_t start, offv_t end) {
+    if (end > start && readahead_is_sequential(sf, start))
+        readahead_prefetch(sf, end - 1);
+    sf->next_offset = end;
+    sf->offset = end; /* last read offset */
+}
+
+static size_t readahead_read(READAHEAD_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    size_t read_total = 0;
+    offv_t start = offset;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    vgm_mutex_lock(sf->shared->mutex);
+
+    while (length > 0) {
+        readahead_window_t* window;
+        size_t buf_limit;
+        size_t buf_into;
+
+        /* ignore requests at EOF */
+        if (offset >= sf->file_size) {
+            VGM_ASSERT_ONCE(offset > sf->file_size, "readahead: reading over file_size 0x%x @ 0x%x + 0x%x\n", sf->file_size, (uint32_t)offset, length);
+            break;
+        }
+
+        window = readahead_get_window(sf, offset);
+        if (!window)
+            break;
+
+        buf_into = (size_t)(offset - window->offset);
+        if (buf_into >= window->valid_size) /* partial reads (EOF/errors) */
+            break;
+
+        buf_limit = window->valid_size - buf_into;
+        if (buf_limit > length)
+            buf_limit = length;
+
+        memcpy(dst, window->buf + buf_into, buf_limit);
+        read_total += buf_limit;
+        length -= buf_limit;
+        offset += buf_limit;
+        dst += buf_limit;
+    }
+
+    readahead_update(sf, start, offset);
+
+    vgm_mutex_unlock(sf->shared->mutex);
+    return read_total;
+}
+
+static const uint8_t* readahead_peek(READAHEAD_STREAMFILE* sf, offv_t offset, size_t length) {
+    readahead_window_t* window;
+    const uint8_t* ptr = NULL;
+
+    if (length <= 0 || offset < 0 || offset + length > sf->file_size)
+        return NULL;
+
+    vgm_mutex_lock(sf->shared->mutex);
+
+    /* windows aren't replaced until next call (prefetch keeps the current one) so pointer stays valid */
+    window = readahead_get_window(sf, offset);
+    if (window && offset + length <= window->offset + window->valid_size) {
+        ptr = window->buf + (offset - window->offset);
+        readahead_update(sf, offset, offset + length);
+    }
+
+    vgm_mutex_unlock(sf->shared->mutex);
+    return ptr;
+}
+
+static size_t readahead_get_size(READAHEAD_STREAMFILE* sf) {
+    return sf->file_size; /* cache */
+}
+static offv_t readahead_get_offset(READAHEAD_STREAMFILE* sf) {
+    return sf->offset; /* cache */
+}
+static void readahead_get_name(READAHEAD_STREAMFILE* sf, char* name, size_t name_size) {
+    sf->inner_sf->get_name(sf->inner_sf, name, name_size); /* default */
+}
+
+static STREAMFILE* readahead_open(READAHEAD_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    STREAMFILE* new_inner_sf;
+    STREAMFILE* new_sf;
+
+    new_inner_sf = sf->inner_sf->open(sf->inner_sf, filename, buf_size);
+    if (!new_inner_sf)
+        return NULL;
+
+    new_sf = open_readahead_streamfile_shared(new_inner_sf, sf->shared, sf->window_size, sf->depth);
+    if (!new_sf)
+        close_streamfile(new_inner_sf);
+    return new_sf;
+}
+
+static int readahead_is_loading(READAHEAD_STREAMFILE* sf) {
+    int i;
+
+    for (i = 0; i < sf->window_count; i++) {
+        if (sf->windows[i].state == RA_LOADING)
+            return 1;
+    }
+    return 0;
+}
+
+static void readahead_free_shared(readahead_shared_t* shared) {
+    if (!shared) return;
+
+    if (shared->thread) {
+        vgm_mutex_lock(shared->mutex);
+        shared->stop = 1;
+        vgm_cond_signal(shared->cond_work);
+        vgm_mutex_unlock(shared->mutex);
+
+        vgm_thread_join(shared->thread);
+    }
+
+    vgm_cond_free(shared->cond_done);
+    vgm_cond_free(shared->cond_work);
+    vgm_mutex_free(shared->mutex);
+    free(shared);
+}
+
+static void readahead_close(READAHEAD_STREAMFILE* sf) {
+    readahead_shared_t* shared = sf->shared;
+    READAHEAD_STREAMFILE** p_sf;
+    int refs;
+
+    vgm_mutex_lock(shared->mutex);
+
+    /* worker may be reading into one of this SF's windows */
+    while (readahead_is_loading(sf)) {
+        vgm_cond_wait(shared->cond_done, shared->mutex);
+    }
+
+    for (p_sf = &shared->sfs; *p_sf != NULL; p_sf = &(*p_sf)->next) {
+        if (*p_sf == sf) {
+            *p_sf = sf->next;
+            break;
+        }
+    }
+    shared->refs--;
+    refs = shared->refs;
+
+    vgm_mutex_unlock(shared->mutex);
+
+    if (refs <= 0)
+        readahead_free_shared(shared);
+
+    sf->inner_sf->close(sf->inner_sf);
+    free(sf->windows);
+    free(sf->buf);
+    free(sf);
+}
 
-    buf = calloc(buf_size, sizeof(uint8_t));
-    if (!buf) goto fail;
+static STREAMFILE* open_readahead_streamfile_shared(STREAMFILE* sf, readahead_shared_t* shared, size_t window_size, int depth) {
+    READAHEAD_STREAMFILE* this_sf = NULL;
+    int i;
 
-    this_sf = calloc(1, sizeof(BUFFER_STREAMFILE));
+    this_sf = calloc(1, sizeof(READAHEAD_STREAMFILE));
     if (!this_sf) goto fail;
 
     /* set callbacks and internals */
-    this_sf->vt.read = (void*)buffer_read;
-    this_sf->vt.get_size = (void*)buffer_get_size;
-    this_sf->vt.get_offset = (void*)buffer_get_offset;
-    this_sf->vt.get_name = (void*)buffer_get_name;
-    this_sf->vt.open = (void*)buffer_open;
-    this_sf->vt.close = (void*)buffer_close;
+    this_sf->vt.read = (void*)readahead_read;
+    this_sf->vt.get_size = (void*)readahead_get_size;
+    this_sf->vt.get_offset = (void*)readahead_get_offset;
+    this_sf->vt.get_name = (void*)readahead_get_name;
+    this_sf->vt.open = (void*)readahead_open;
+    this_sf->vt.close = (void*)readahead_close;
+    this_sf->vt.peek = (void*)readahead_peek;
     this_sf->vt.stream_index = sf->stream_index;
 
     this_sf->inner_sf = sf;
-    this_sf->buf_size = buf_size;
-    this_sf->buf = buf;
-
     this_sf->file_size = sf->get_size(sf);
+    this_sf->window_size = window_size;
+    this_sf->depth = depth;
+
+    this_sf->window_count = depth + 1;
+    this_sf->buf = calloc(window_size * this_sf->window_count, sizeof(uint8_t));
+    if (!this_sf->buf) goto fail;
+    this_sf->windows = calloc(this_sf->window_count, sizeof(readahead_window_t));
+    if (!this_sf->windows) goto fail;
+    for (i = 0; i < this_sf->window_count; i++) {
+        this_sf->windows[i].buf = this_sf->buf + window_size * i;
+    }
+
+    vgm_mutex_lock(shared->mutex);
+    this_sf->shared = shared;
+    this_sf->next = shared->sfs;
+    shared->sfs = this_sf;
+    shared->refs++;
+    vgm_mutex_unlock(shared->mutex);
 
     return &this_sf->vt;
 
 fail:
-    if (this_sf) free(this_sf->buf);
-    free(this_sf);
+    if (this_sf) {
+        free(this_sf->windows);
+        free(this_sf->buf);
+        free(this_sf);
+    }
     return NULL;
 }
-STREAMFILE* open_buffer_streamfile_f(STREAMFILE* sf, size_t buffer_size) {
-    STREAMFILE* new_sf = open_buffer_streamfile(sf, buffer_size);
+
+STREAMFILE* open_readahead_streamfile(STREAMFILE* sf, size_t window_size, int depth) {
+    readahead_shared_t* shared = NULL;
+    STREAMFILE* new_sf;
+
+    if (!sf) return NULL;
+
+    if (window_size == 0)
+        window_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    if (depth <= 0)
+        depth = READAHEAD_DEFAULT_DEPTH;
+
+    shared = calloc(1, sizeof(readahead_shared_t));
+    if (!shared) goto fail;
+
+    shared->mutex = vgm_mutex_init();
+    shared->cond_work = vgm_cond_init();
+    shared->cond_done = vgm_cond_init();
+    if (!shared->mutex || !shared->cond_work || !shared->cond_done) goto fail;
+
+    shared->thread = vgm_thread_create(readahead_worker, shared);
+    if (!shared->thread) goto fail;
+
+    new_sf = open_readahead_streamfile_shared(sf, shared, window_size, depth);
+    if (!new_sf) goto fail;
+
+    return new_sf;
+
+fail:
+    readahead_free_shared(shared);
+
+    /* no threads (or other issues): use regular buffered reads */
+    return open_buffer_streamfile(sf, window_size);
+}
+STREAMFILE* open_readahead_streamfile_f(STREAMFILE* sf, size_t window_size, int depth) {
+    STREAMFILE* new_sf = open_readahead_streamfile(sf, window_size, depth);
     if (!new_sf)
         close_streamfile(sf);
     return new_sf;
@@ -496,6 +1738,9 @@ typedef struct {
 static size_t wrap_read(WRAP_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
     return sf->inner_sf->read(sf->inner_sf, dst, offset, length); /* default */
 }
+static const uint8_t* wrap_peek(WRAP_STREAMFILE* sf, offv_t offset, size_t length) {
+    return sf->inner_sf->peek(sf->inner_sf, offset, length); /* default */
+}
 static size_t wrap_get_size(WRAP_STREAMFILE* sf) {
     return sf->inner_sf->get_size(sf->inner_sf); /* default */
 }
@@ -530,6 +1775,7 @@ STREAMFILE* open_wrap_streamfile(STREAMFILE* sf) {
     this_sf->vt.get_name = (void*)wrap_get_name;
     this_sf->vt.open = (void*)wrap_open;
     this_sf->vt.close = (void*)wrap_close;
+    this_sf->vt.peek = sf->peek ? (void*)wrap_peek : NULL;
     this_sf->vt.stream_index = sf->stream_index;
 
     this_sf->inner_sf = sf;
@@ -566,6 +1812,12 @@ static size_t clamp_read(CLAMP_STREAMFILE* sf, uint8_t* dst, offv_t offset, size
 
     return sf->inner_sf->read(sf->inner_sf, dst, inner_offset, clamp_length);
 }
+static const uint8_t* clamp_peek(CLAMP_STREAMFILE* sf, offv_t offset, size_t length) {
+    if (offset < 0 || offset + length > sf->size)
+        return NULL; /* let read handle partial data */
+
+    return sf->inner_sf->peek(sf->inner_sf, sf->start + offset, length);
+}
 static size_t clamp_get_size(CLAMP_STREAMFILE* sf) {
     return sf->size;
 }
@@ -612,6 +1864,7 @@ STREAMFILE* open_clamp_streamfile(STREAMFILE* sf, offv_t start, size_t size) {
     this_sf->vt.get_name = (void*)clamp_get_name;
     this_sf->vt.open = (void*)clamp_open;
     this_sf->vt.close = (void*)clamp_close;
+    this_sf->vt.peek = sf->peek ? (void*)clamp_peek : NULL;
     this_sf->vt.stream_index = sf->stream_index;
 
     this_sf->inner_sf = sf;
@@ -741,6 +1994,9 @@ typedef struct {
 static size_t fakename_read(FAKENAME_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
     return sf->inner_sf->read(sf->inner_sf, dst, offset, length); /* default */
 }
+static const uint8_t* fakename_peek(FAKENAME_STREAMFILE* sf, offv_t offset, size_t length) {
+    return sf->inner_sf->peek(sf->inner_sf, offset, length); /* default */
+}
 static size_t fakename_get_size(FAKENAME_STREAMFILE* sf) {
     return sf->inner_sf->get_size(sf->inner_sf); /* default */
 }
@@ -789,6 +2045,7 @@ STREAMFILE* open_fakename_streamfile(STREAMFILE* sf, const char* fakename, const
     this_sf->vt.get_name = (void*)fakename_get_name;
     this_sf->vt.open = (void*)fakename_open;
     this_sf->vt.close = (void*)fakename_close;
+    this_sf->vt.peek = sf->peek ? (void*)fakename_peek : NULL;
     this_sf->vt.stream_index = sf->stream_index;
 
     this_sf->inner_sf = sf;
@@ -985,6 +2242,450 @@ STREAMFILE* open_multifile_streamfile_f(STREAMFILE** sfs, size_t sfs_size) {
 
 /* **************************************************** */
 
+/* A STREAMFILE that reads the start and end of a file once and serves reads inside those from memory,
+ * passing others to the underlying SF. Meant for format detection, where metas test lots of small values
+ * around the header (or footer) that may be slow to read one by one with some SFs (like network IO). */
+typedef struct {
+    STREAMFILE vt;
+
+    STREAMFILE* inner_sf;
+    size_t file_size;       /* cached inner size */
+    uint8_t* head;          /* data at 0x00 */
+    size_t head_size;       /* valid head data */
+    uint8_t* tail;          /* data at tail_offset */
+    offv_t tail_offset;
+    size_t tail_size;       /* valid tail data */
+} SNAPSHOT_STREAMFILE;
+
+/* returns snapshot data if [offset, offset+length) is fully inside it */
+static const uint8_t* snapshot_get(SNAPSHOT_STREAMFILE* sf, offv_t offset, size_t length) {
+    if (offset < 0)
+        return NULL;
+    if (offset + length <= sf->head_size)
+        return sf->head + offset;
+    if (offset >= sf->tail_offset && offset + length <= sf->tail_offset + sf->tail_size)
+        return sf->tail + (offset - sf->tail_offset);
+    return NULL;
+}
+
+static size_t snapshot_read(SNAPSHOT_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    const uint8_t* data;
+
+    if (!dst || length <= 0)
+        return 0;
+
+    data = snapshot_get(sf, offset, length);
+    if (!data)
+        return sf->inner_sf->read(sf->inner_sf, dst, offset, length);
+
+    memcpy(dst, data, length);
+    return length;
+}
+static const uint8_t* snapshot_peek(SNAPSHOT_STREAMFILE* sf, offv_t offset, size_t length) {
+    const uint8_t* data;
+
+    if (length <= 0)
+        return NULL;
+
+    data = snapshot_get(sf, offset, length);
+    if (!data && sf->inner_sf->peek)
+        data = sf->inner_sf->peek(sf->inner_sf, offset, length);
+    return data;
+}
+static size_t snapshot_get_size(SNAPSHOT_STREAMFILE* sf) {
+    return sf->file_size; /* cache */
+}
+static offv_t snapshot_get_offset(SNAPSHOT_STREAMFILE* sf) {
+    return sf->inner_sf->get_offset(sf->inner_sf); /* default */
+}
+static void snapshot_get_name(SNAPSHOT_STREAMFILE* sf, char* name, size_t name_size) {
+    sf->inner_sf->get_name(sf->inner_sf, name, name_size); /* default */
+}
+
+static STREAMFILE* snapshot_open(SNAPSHOT_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    return sf->inner_sf->open(sf->inner_sf, filename, buf_size); /* default (reopened SFs are used to play) */
+}
+
+static void snapshot_close(SNAPSHOT_STREAMFILE* sf) {
+    //sf->inner_sf->close(sf->inner_sf); /* don't close */
+    free(sf->head);
+    free(sf->tail);
+    free(sf);
+}
+
+STREAMFILE* open_snapshot_streamfile(STREAMFILE* sf, size_t head_size, size_t tail_size) {
+    SNAPSHOT_STREAMFILE* this_sf = NULL;
+
+    if (!sf) goto fail;
+
+    this_sf = calloc(1, sizeof(SNAPSHOT_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->file_size = sf->get_size(sf);
+
+    /* small files are fully in head */
+    if (head_size > this_sf->file_size)
+        head_size = this_sf->file_size;
+    if (tail_size > this_sf->file_size - head_size)
+        tail_size = this_sf->file_size - head_size;
+
+    if (head_size) {
+        this_sf->head = malloc(head_size);
+        if (!this_sf->head) goto fail;
+        this_sf->head_size = sf->read(sf, this_sf->head, 0x00, head_size);
+    }
+
+    if (tail_size) {
+        this_sf->tail = malloc(tail_size);
+        if (!this_sf->tail) goto fail;
+        this_sf->tail_offset = this_sf->file_size - tail_size;
+        this_sf->tail_size = sf->read(sf, this_sf->tail, this_sf->tail_offset, tail_size);
+    }
+
+    /* set callbacks and internals */
+    this_sf->vt.read = (void*)snapshot_read;
+    this_sf->vt.get_size = (void*)snapshot_get_size;
+    this_sf->vt.get_offset = (void*)snapshot_get_offset;
+    this_sf->vt.get_name = (void*)snapshot_get_name;
+    this_sf->vt.open = (void*)snapshot_open;
+    this_sf->vt.close = (void*)snapshot_close;
+    this_sf->vt.peek = (void*)snapshot_peek;
+    this_sf->vt.stream_index = sf->stream_index;
+
+    this_sf->inner_sf = sf;
+
+    return &this_sf->vt;
+
+fail:
+    if (this_sf) {
+        free(this_sf->head);
+        free(this_sf->tail);
+    }
+    free(this_sf);
+    return NULL;
+}
+
+/* **************************************************** */
+
+/* counters shared by a stats SF and all SFs opened from it */
+typedef struct {
+    volatile int refs;
+    int stopped;            /* SFs just pass calls to their inner SF */
+    streamfile_stats_t stats;
+} stats_shared_t;
+
+/* a buffered STREAMFILE that counts IO done through it (buffer works like regular SFs, to get
+ * representative numbers). Counters aren't atomic so they are approximate if SFs are used in threads. */
+typedef struct {
+    STREAMFILE vt;
+
+    STREAMFILE* inner_sf;
+    stats_shared_t* shared;
+    offv_t offset;          /* last read offset (info) */
+    offv_t last_start;      /* last read start, to detect jumps */
+    offv_t buf_offset;      /* current buffer data start */
+    uint8_t* buf;           /* data buffer */
+    size_t buf_size;        /* max buffer size */
+    size_t valid_size;      /* current buffer size */
+    size_t file_size;       /* buffered file size */
+} STATS_STREAMFILE;
+
+static STREAMFILE* open_stats_streamfile_shared(STREAMFILE* sf, stats_shared_t* shared, size_t buf_size);
+
+static void stats_fill_buffer(STATS_STREAMFILE* sf, offv_t offset) {
+    streamfile_stats_t* stats = &sf->shared->stats;
+
+    if (offset < sf->buf_offset)
+        stats->backward_jumps++;
+
+    sf->buf_offset = offset;
+    sf->valid_size = sf->inner_sf->read(sf->inner_sf, sf->buf, sf->buf_offset, sf->buf_size);
+
+    stats->rebuffers++;
+    stats->bytes_read += sf->valid_size;
+}
+
+static size_t stats_read(STATS_STREAMFILE* sf, uint8_t* dst, offv_t offset, size_t length) {
+    streamfile_stats_t* stats = &sf->shared->stats;
+    size_t read_total = 0;
+
+    if (sf->shared->stopped) {
+        read_total = sf->inner_sf->read(sf->inner_sf, dst, offset, length);
+        sf->offset = offset + read_total;
+        return read_total;
+    }
+
+    stats->read_calls++;
+    stats->bytes_requested += length;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    while (length > 0) {
+        size_t buf_limit;
+        int buf_into;
+
+        /* ignore requests at EOF */
+        if (offset >= sf->file_size)
+            break;
+
+        if (offset < sf->buf_offset || offset >= sf->buf_offset + sf->valid_size) {
+            stats_fill_buffer(sf, offset);
+            if (sf->valid_size == 0)
+                break;
+        }
+
+        buf_into = (int)(offset - sf->buf_offset);
+        buf_limit = sf->valid_size - buf_into;
+        if (buf_limit > length)
+            buf_limit = length;
+
+        memcpy(dst, sf->buf + buf_into, buf_limit);
+        read_total += buf_limit;
+        length -= buf_limit;
+        offset += buf_limit;
+        dst += buf_limit;
+    }
+
+    sf->offset = offset; /* last read offset */
+    return read_total;
+}
+
+static const uint8_t* stats_peek(STATS_STREAMFILE* sf, offv_t offset, size_t length) {
+    streamfile_stats_t* stats = &sf->shared->stats;
+
+    if (sf->shared->stopped)
+        return sf->inner_sf->peek(sf->inner_sf, offset, length);
+
+    if (length <= 0 || offset < 0 || length > sf->buf_size || offset + length > sf->file_size)
+        return NULL; /* counted by regular read */
+
+    stats->read_calls++;
+    stats->bytes_requested += length;
+
+    if (offset < sf->buf_offset || offset + length > sf->buf_offset + sf->valid_size) {
+        stats_fill_buffer(sf, offset);
+        if (sf->valid_size < length)
+            return NULL;
+    }
+
+    sf->offset = offset + length; /* last read offset */
+    return sf->buf + (offset - sf->buf_offset);
+}
+
+static size_t stats_get_size(STATS_STREAMFILE* sf) {
+    return sf->file_size; /* cache */
+}
+static offv_t stats_get_offset(STATS_STREAMFILE* sf) {
+    return sf->offset; /* cache */
+}
+static void stats_get_name(STATS_STREAMFILE* sf, char* name, size_t name_size) {
+    sf->inner_sf->get_name(sf->inner_sf, name, name_size); /* default */
+}
+
+static STREAMFILE* stats_open(STATS_STREAMFILE* sf, const char* const filename, size_t buf_size) {
+    STREAMFILE* new_inner_sf;
+    STREAMFILE* new_sf;
+
+    if (sf->shared->stopped)
+        return sf->inner_sf->open(sf->inner_sf, filename, buf_size);
+
+    sf->shared->stats.open_calls++;
+
+    new_inner_sf = sf->inner_sf->open(sf->inner_sf, filename, buf_size);
+    if (!new_inner_sf)
+        return NULL;
+
+    /* companion files are also counted */
+    new_sf = open_stats_streamfile_shared(new_inner_sf, sf->shared, buf_size);
+    if (!new_sf)
+        close_streamfile(new_inner_sf);
+    return new_sf;
+}
+
+static void stats_close(STATS_STREAMFILE* sf) {
+    if (vgm_atomic_dec(&sf->shared->refs) <= 0)
+        free(sf->shared);
+    sf->inner_sf->close(sf->inner_sf);
+    free(sf->buf);
+    free(sf);
+}
+
+static STREAMFILE* open_stats_streamfile_shared(STREAMFILE* sf, stats_shared_t* shared, size_t buf_size) {
+    STATS_STREAMFILE* this_sf = NULL;
+
+    if (!sf || !shared) goto fail;
+
+    if (buf_size == 0)
+        buf_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
+    this_sf = calloc(1, sizeof(STATS_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->buf = calloc(buf_size, sizeof(uint8_t));
+    if (!this_sf->buf) goto fail;
+
+    /* set callbacks and internals */
+    this_sf->vt.read = (void*)stats_read;
+    this_sf->vt.get_size = (void*)stats_get_size;
+    this_sf->vt.get_offset = (void*)stats_get_offset;
+    this_sf->vt.get_name = (void*)stats_get_name;
+    this_sf->vt.open = (void*)stats_open;
+    this_sf->vt.close = (void*)stats_close;
+    this_sf->vt.peek = (void*)stats_peek;
+    this_sf->vt.stream_index = sf->stream_index;
+
+    this_sf->inner_sf = sf;
+    this_sf->buf_size = buf_size;
+    this_sf->file_size = sf->get_size(sf);
+
+    this_sf->shared = shared;
+    vgm_atomic_inc(&shared->refs);
+
+    return &this_sf->vt;
+
+fail:
+    if (this_sf) free(this_sf->buf);
+    free(this_sf);
+    return NULL;
+}
+
+STREAMFILE* open_stats_streamfile(STREAMFILE* sf) {
+    stats_shared_t* shared;
+    STREAMFILE* new_sf;
+
+    if (!sf) return NULL;
+
+    shared = calloc(1, sizeof(stats_shared_t));
+    if (!shared) return NULL;
+
+    new_sf = open_stats_streamfile_shared(sf, shared, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    if (!new_sf) {
+        free(shared);
+        return NULL;
+    }
+    return new_sf;
+}
+STREAMFILE* open_stats_streamfile_f(STREAMFILE* sf) {
+    STREAMFILE* new_sf = open_stats_streamfile(sf);
+    if (!new_sf)
+        close_streamfile(sf);
+    return new_sf;
+}
+
+int get_streamfile_stats(STREAMFILE* sf, streamfile_stats_t* stats) {
+    STATS_STREAMFILE* stats_sf = (STATS_STREAMFILE*)sf;
+
+    if (!sf || !stats || sf->read != (void*)stats_read)
+        return 0;
+
+    *stats = stats_sf->shared->stats;
+    return 1;
+}
+
+void stop_streamfile_stats(STREAMFILE* sf) {
+    STATS_STREAMFILE* stats_sf = (STATS_STREAMFILE*)sf;
+
+    if (!sf || sf->read != (void*)stats_read)
+        return;
+
+    stats_sf->shared->stopped = 1;
+}
+
+/* **************************************************** */
+
+/* returns the SF a wrapper SF reads from, or NULL if sf isn't a (known) single SF wrapper */
+static STREAMFILE* get_inner_streamfile(STREAMFILE* sf) {
+    if (sf->read == (void*)buffer_read)
+        return ((BUFFER_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)readahead_read)
+        return ((READAHEAD_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)wrap_read)
+        return ((WRAP_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)clamp_read)
+        return ((CLAMP_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)io_read)
+        return ((IO_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)fakename_read)
+        return ((FAKENAME_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)snapshot_read)
+        return ((SNAPSHOT_STREAMFILE*)sf)->inner_sf;
+    if (sf->read == (void*)stats_read)
+        return ((STATS_STREAMFILE*)sf)->inner_sf;
+    return NULL;
+}
+
+int is_threadsafe_streamfile(STREAMFILE* sf) {
+    while (sf) {
+        /* reopens share a positionless fd, a read-only map or buffer */
+        if (sf->read == (void*)pread_read || sf->read == (void*)mmap_read || sf->read == (void*)memory_read)
+            return 1;
+
+        if (sf->read == (void*)multifile_read) {
+            MULTIFILE_STREAMFILE* multi_sf = (MULTIFILE_STREAMFILE*)sf;
+            for (int i = 0; i < multi_sf->inner_sfs_size; i++) {
+                if (!is_threadsafe_streamfile(multi_sf->inner_sfs[i]))
+                    return 0;
+            }
+            return 1;
+        }
+
+        /* stdio reopens dup() the fd (shared file position), and unknown SFs may do anything */
+        sf = get_inner_streamfile(sf);
+    }
+    return 0;
+}
+
+/* checks if target is sf or any SF it reads from */
+static int has_streamfile(STREAMFILE* sf, STREAMFILE* target) {
+    while (sf) {
+        if (sf == target)
+            return 1;
+
+        if (sf->read == (void*)multifile_read) {
+            MULTIFILE_STREAMFILE* multi_sf = (MULTIFILE_STREAMFILE*)sf;
+            for (int i = 0; i < multi_sf->inner_sfs_size; i++) {
+                if (has_streamfile(multi_sf->inner_sfs[i], target))
+                    return 1;
+            }
+            return 0;
+        }
+
+        sf = get_inner_streamfile(sf);
+    }
+    return 0;
+}
+
+int is_shared_streamfile(STREAMFILE* sf1, STREAMFILE* sf2) {
+    while (sf1) {
+        if (has_streamfile(sf2, sf1))
+            return 1;
+
+        if (sf1->read == (void*)multifile_read) {
+            MULTIFILE_STREAMFILE* multi_sf = (MULTIFILE_STREAMFILE*)sf1;
+            for (int i = 0; i < multi_sf->inner_sfs_size; i++) {
+                if (is_shared_streamfile(multi_sf->inner_sfs[i], sf2))
+                    return 1;
+            }
+            return 0;
+        }
+
+        sf1 = get_inner_streamfile(sf1);
+    }
+    return 0;
+}
+
+int is_snapshot_streamfile(STREAMFILE* sf) {
+    while (sf) {
+        if (sf->read == (void*)snapshot_read)
+            return 1;
+        sf = get_inner_streamfile(sf);
+    }
+    return 0;
+}
+
+/* **************************************************** */
+
 STREAMFILE* open_streamfile(STREAMFILE* sf, const char* pathname) {
     return sf->open(sf, pathname, STREAMFILE_DEFAULT_BUFFER_SIZE);
 }
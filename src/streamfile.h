@@ -19,6 +19,7 @@
 #include <sys/types.h>
 #include "streamtypes.h"
 #include "util.h"
+#include "util/dircache.h"
 
 
 /* MSVC fixes (though mingw uses MSVCRT but not MSC_VER, maybe use AND?) */
@@ -69,6 +70,10 @@ typedef struct _STREAMFILE {
     /* free current STREAMFILE */
     void (*close)(struct _STREAMFILE* sf);
 
+    /* (optional) get a pointer to 'length' data at 'offset' from internal buffers without copying,
+     * or NULL if not possible. Pointer is only valid until next call to this SF. */
+    const uint8_t* (*peek)(struct _STREAMFILE* sf, offv_t offset, size_t length);
+
     /* Substream selection for formats with subsongs.
      * Not ideal here, but it was the simplest way to pass to all init_vgmstream_x functions. */
     int stream_index; /* 0=default/auto (first), 1=first, N=Nth */
@@ -86,12 +91,54 @@ STREAMFILE* open_stdio_streamfile(const char* filename);
 /* Opens a standard STREAMFILE from a pre-opened FILE. */
 STREAMFILE* open_stdio_streamfile_by_file(FILE* file, const char* filename);
 
+/* Opens a standard STREAMFILE that checks a directory listing cache before opening other files
+ * (ex. companion files), shared with all SFs opened from it. Cache is ref'd so caller may free it
+ * after opening, or reuse it for other files in the same dirs. */
+STREAMFILE* open_stdio_streamfile_dircache(const char* filename, dircache_t* dircache);
+
+/* Opens a standard STREAMFILE that caches N pages of data (discarded in LRU order), for formats that
+ * jump around a lot. Reopening it with bigger buffer sizes than page_size also makes N pages of that size.
+ * Page size is optional, as is the dircache (see open_stdio_streamfile_dircache). */
+STREAMFILE* open_stdio_streamfile_paged(const char* filename, size_t page_size, int page_count, dircache_t* dircache);
+
+/* Opens a STREAMFILE that reads from a memory-mapped file, opening from path.
+ * Reopening the same file shares the mapping (no per-SF buffers). Falls back to stdio
+ * when the system or file can't be mapped. */
+STREAMFILE* open_mmap_streamfile(const char* filename);
+
+/* Same, but checks a directory listing cache before opening other files (see open_stdio_streamfile_dircache). */
+STREAMFILE* open_mmap_streamfile_dircache(const char* filename, dircache_t* dircache);
+
+/* Opens a STREAMFILE that reads with pread from a file descriptor, opening from path.
+ * Reopening the same file shares the descriptor, and since reads don't depend on a file position
+ * each SF can be used in a different thread. Falls back to stdio when the system can't use pread. */
+STREAMFILE* open_pread_streamfile(const char* filename);
+
+/* Same, but checks a directory listing cache before opening other files (see open_stdio_streamfile_dircache). */
+STREAMFILE* open_pread_streamfile_dircache(const char* filename, dircache_t* dircache);
+
+/* Opens a STREAMFILE that reads from a memory buffer (not copied), with a name for format detection.
+ * Reopening the same name shares the buffer. Once all SFs opened from it are closed free_cb(data) is
+ * called, if set (so the caller can release it). Other names can't be opened (returns NULL). */
+STREAMFILE* open_memory_streamfile(const uint8_t* data, size_t size, const char* name, void (*free_cb)(void* data));
+/* Same, but other names (companion files like .acb for .awb, or .txth) are opened with open_cb(user_data, filename),
+ * that should return a new SF or NULL if not found (may be another memory SF). */
+STREAMFILE* open_memory_streamfile_ex(const uint8_t* data, size_t size, const char* name, void (*free_cb)(void* data),
+        STREAMFILE* (*open_cb)(void* user_data, const char* filename), void* user_data);
+
 /* Opens a STREAMFILE that does buffered IO.
  * Can be used when the underlying IO may be slow (like when using custom IO).
  * Buffer size is optional. */
 STREAMFILE* open_buffer_streamfile(STREAMFILE* sf, size_t buffer_size);
 STREAMFILE* open_buffer_streamfile_f(STREAMFILE* sf, size_t buffer_size);
 
+/* Opens a STREAMFILE that reads windows of data in a background thread, reading ahead
+ * 'depth' windows when access looks sequential (so slow IO doesn't stall the decoder).
+ * Reopens share the same thread (so many channels don't start many threads). Sizes are optional, and acts like
+ * a buffered SF if threads aren't available. */
+STREAMFILE* open_readahead_streamfile(STREAMFILE* sf, size_t window_size, int depth);
+STREAMFILE* open_readahead_streamfile_f(STREAMFILE* sf, size_t window_size, int depth);
+
 /* Opens a STREAMFILE that doesn't close the underlying streamfile.
  * Calls to open won't wrap the new SF (assumes it needs to be closed).
  * Can be used in metas to test custom IO without closing the external SF. */
@@ -120,18 +167,56 @@ STREAMFILE* open_io_streamfile_ex_f(STREAMFILE* sf, void* data, size_t data_size
 STREAMFILE* open_fakename_streamfile(STREAMFILE* sf, const char* fakename, const char* fakeext);
 STREAMFILE* open_fakename_streamfile_f(STREAMFILE* sf, const char* fakename, const char* fakeext);
 
+/* Opens a STREAMFILE that reads the first head_size and last tail_size bytes once, and serves reads fully inside
+ * them from memory (others go to the underlying SF). Doesn't close the underlying SF, and open isn't wrapped.
+ * Can be used during format detection when the underlying IO is slow and metas test many small values. */
+STREAMFILE* open_snapshot_streamfile(STREAMFILE* sf, size_t head_size, size_t tail_size);
+
+/* Checks if sf is a snapshot SF, or wraps one (to avoid snapshots of snapshots). */
+int is_snapshot_streamfile(STREAMFILE* sf);
+
+/* Checks if SFs reopened from sf can be read in different threads at the same time (true for pread,
+ * mmap and memory SFs plus wrappers over them, while stdio reopens share the file position). */
+int is_threadsafe_streamfile(STREAMFILE* sf);
+
+/* Checks if both SFs are or wrap the same SF (reading both in different threads isn't safe). */
+int is_shared_streamfile(STREAMFILE* sf1, STREAMFILE* sf2);
+
 /* Opens streamfile formed from multiple streamfiles, their data joined during reads.
  * Can be used when data is segmented in multiple separate files.
  * The first streamfile is used to get names, stream index and so on. */
 STREAMFILE* open_multifile_streamfile(STREAMFILE** sfs, size_t sfs_size);
 STREAMFILE* open_multifile_streamfile_f(STREAMFILE** sfs, size_t sfs_size);
 
+/* IO counters of a stats STREAMFILE, shared with all SFs opened from it */
+typedef struct {
+    uint64_t read_calls;        /* read (and peek) calls */
+    uint64_t bytes_requested;   /* bytes asked by callers */
+    uint64_t bytes_read;        /* bytes read from the underlying SF (physical) */
+    uint64_t rebuffers;         /* reads from the underlying SF (buffer refills) */
+    uint64_t backward_jumps;    /* refills before the current buffer */
+    uint64_t open_calls;        /* open/reopen calls (including companion files) */
+} streamfile_stats_t;
+
+/* Opens a buffered STREAMFILE that counts IO done through it and all SFs opened from it.
+ * Should be put at the base of the chain (over the file SF) to see what a format/codec costs. */
+STREAMFILE* open_stats_streamfile(STREAMFILE* sf);
+STREAMFILE* open_stats_streamfile_f(STREAMFILE* sf);
+
+/* Copies current counters, if sf is a stats SF (returns 0 otherwise). */
+int get_streamfile_stats(STREAMFILE* sf, streamfile_stats_t* stats);
+
+/* Stops counting in sf and all SFs opened from it, that then pass calls to their inner SFs unbuffered
+ * (for SFs still in use after measuring). Not thread-safe, should be done before SFs are used in threads. */
+void stop_streamfile_stats(STREAMFILE* sf);
+
 /* Opens a STREAMFILE from a (path)+filename.
  * Just a wrapper, to avoid having to access the STREAMFILE's callbacks directly. */
 STREAMFILE* open_streamfile(STREAMFILE* sf, const char* pathname);
 
 /* Reopen a STREAMFILE with a different buffer size, for fine-tuned bigfile parsing.
- * Uses default buffer size when buffer_size is 0 */
+ * Uses default buffer size when buffer_size is 0. Paged stdio SFs (see open_stdio_streamfile_paged)
+ * split sizes bigger than their page size into multiple pages, while others use a single buffer. */
 STREAMFILE* reopen_streamfile(STREAMFILE* sf, size_t buffer_size);
 
 
@@ -146,6 +231,43 @@ static inline size_t read_streamfile(uint8_t* dst, offv_t offset, size_t length,
     return sf->read(sf, dst, offset, length);
 }
 
+/* get 'length' data at 'offset', pointing to the SF's internal buffer if possible (valid until next
+ * read/peek) or copying to 'buf' (must fit 'length') otherwise. Returns NULL if data can't be fully read. */
+static inline const uint8_t* peek_streamfile(uint8_t* buf, offv_t offset, size_t length, STREAMFILE* sf) {
+    if (sf->peek) {
+        const uint8_t* ptr = sf->peek(sf, offset, length);
+        if (ptr) return ptr;
+    }
+
+    if (sf->read(sf, buf, offset, length) != length)
+        return NULL;
+    return buf;
+}
+
+/* same as peek_streamfile, but partial data (EOF) is returned in 'buf' padded with 0s rather than NULL,
+ * for decoders that ignore EOF errors */
+static inline const uint8_t* peek_streamfile_pad(uint8_t* buf, offv_t offset, size_t length, STREAMFILE* sf) {
+    size_t bytes;
+
+    if (sf->peek) {
+        const uint8_t* ptr = sf->peek(sf, offset, length);
+        if (ptr) return ptr;
+    }
+
+    bytes = sf->read(sf, buf, offset, length);
+    if (bytes < length)
+        memset(buf + bytes, 0, length - bytes);
+    return buf;
+}
+
+/* same as read_streamfile, but partial data (EOF) is padded with 0s; for decoders that need
+ * data from N places at once (peeked data may be replaced on next call) */
+static inline void read_streamfile_pad(uint8_t* buf, offv_t offset, size_t length, STREAMFILE* sf) {
+    size_t bytes = sf->read(sf, buf, offset, length);
+    if (bytes < length)
+        memset(buf + bytes, 0, length - bytes);
+}
+
 /* return file size */
 static inline size_t get_streamfile_size(STREAMFILE* sf) {
     return sf->get_size(sf);
@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dircache.h"
+#include "thread.h"
+
+#if defined(_WIN32) || defined(WIN32)
+    #include <windows.h>
+    #define USE_DIRCACHE_WIN32
+    #define dircache_strcmp _stricmp /* case insensitive filesystem */
+#elif !defined(__EMSCRIPTEN__)
+    #include <dirent.h>
+    #include <strings.h>
+    #define USE_DIRCACHE_DIRENT
+    #define dircache_strcmp strcasecmp /* filesystem may be case insensitive too (macOS), see dircache_is_missing */
+#endif
+
+/* max directories cached at once (older ones are replaced) */
+#define DIRCACHE_MAX_DIRS  16
+
+typedef struct {
+    char* path;             /* directory (as part of the filename, without separator) */
+    char** names;           /* sorted filenames */
+    int count;              /* number of names */
+    int listed;             /* directory could be read */
+} dircache_dir_t;
+
+struct dircache_t {
+    int refs;
+    vgm_mutex_t* lock;      /* may be NULL without threads */
+
+    dircache_dir_t dirs[DIRCACHE_MAX_DIRS];
+    int dir_count;
+    int dir_next;           /* slot to replace when full */
+};
+
+
+dircache_t* dircache_init(void) {
+    dircache_t* cache = calloc(1, sizeof(dircache_t));
+    if (!cache) return NULL;
+
+    cache->refs = 1;
+    cache->lock = vgm_mutex_init();
+    return cache;
+}
+
+static void lock_cache(dircache_t* cache) {
+    if (cache->lock)
+        vgm_mutex_lock(cache->lock);
+}
+
+static void unlock_cache(dircache_t* cache) {
+    if (cache->lock)
+        vgm_mutex_unlock(cache->lock);
+}
+
+static void free_dir(dircache_dir_t* dir) {
+    int i;
+
+    for (i = 0; i < dir->count; i++) {
+        free(dir->names[i]);
+    }
+    free(dir->names);
+    free(dir->path);
+    memset(dir, 0, sizeof(dircache_dir_t));
+}
+
+dircache_t* dircache_ref(dircache_t* cache) {
+    if (!cache) return NULL;
+
+    lock_cache(cache);
+    cache->refs++;
+    unlock_cache(cache);
+    return cache;
+}
+
+void dircache_free(dircache_t* cache) {
+    int i, refs;
+
+    if (!cache) return;
+
+    lock_cache(cache);
+    cache->refs--;
+    refs = cache->refs;
+    unlock_cache(cache);
+    if (refs > 0)
+        return;
+
+    for (i = 0; i < cache->dir_count; i++) {
+        free_dir(&cache->dirs[i]);
+    }
+    vgm_mutex_free(cache->lock);
+    free(cache);
+}
+
+
+#if defined(USE_DIRCACHE_WIN32) || defined(USE_DIRCACHE_DIRENT)
+
+static int add_name(dircache_dir_t* dir, int* p_max, const char* name) {
+    if (dir->count >= *p_max) {
+        int new_max = *p_max ? *p_max * 2 : 256;
+        char** new_names = realloc(dir->names, new_max * sizeof(char*));
+        if (!new_names) return 0;
+        dir->names = new_names;
+        *p_max = new_max;
+    }
+
+    dir->names[dir->count] = malloc(strlen(name) + 1);
+    if (!dir->names[dir->count]) return 0;
+    strcpy(dir->names[dir->count], name);
+    dir->count++;
+    return 1;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return dircache_strcmp(*(const char**)a, *(const char**)b);
+}
+
+/* reads all filenames in path, or marks the dir as not listed on errors */
+static void list_dir(dircache_dir_t* dir) {
+    int max = 0;
+#ifdef USE_DIRCACHE_WIN32
+    char pattern[1024];
+    WIN32_FIND_DATAA data;
+    HANDLE handle;
+
+    if (strlen(dir->path) + 3 > sizeof(pattern))
+        return;
+    strcpy(pattern, dir->path);
+    strcat(pattern, "\\*");
+
+    handle = FindFirstFileA(pattern, &data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (!add_name(dir, &max, data.cFileName))
+            break;
+    } while (FindNextFileA(handle, &data));
+    if (GetLastError() != ERROR_NO_MORE_FILES) {
+        FindClose(handle);
+        goto fail;
+    }
+    FindClose(handle);
+#else
+    DIR* dp;
+    struct dirent* entry;
+
+    dp = opendir(dir->path);
+    if (!dp)
+        return;
+    while ((entry = readdir(dp)) != NULL) {
+        if (!add_name(dir, &max, entry->d_name)) {
+            closedir(dp);
+            goto fail;
+        }
+    }
+    closedir(dp);
+#endif
+
+    qsort(dir->names, dir->count, sizeof(char*), compare_names);
+    dir->listed = 1;
+    return;
+fail:
+    {
+        char* path = dir->path;
+        dir->path = NULL;
+        free_dir(dir);
+        dir->path = path; /* keep as unlisted so it isn't retried */
+    }
+}
+
+static dircache_dir_t* get_dir(dircache_t* cache, const char* path, size_t path_len) {
+    dircache_dir_t* dir;
+    int i;
+
+    for (i = 0; i < cache->dir_count; i++) {
+        dir = &cache->dirs[i];
+        if (dir->path && strlen(dir->path) == path_len && memcmp(dir->path, path, path_len) == 0)
+            return dir;
+    }
+
+    /* new dir */
+    if (cache->dir_count < DIRCACHE_MAX_DIRS) {
+        dir = &cache->dirs[cache->dir_count];
+        cache->dir_count++;
+    }
+    else {
+        dir = &cache->dirs[cache->dir_next];
+        cache->dir_next = (cache->dir_next + 1) % DIRCACHE_MAX_DIRS;
+        free_dir(dir);
+    }
+
+    dir->path = malloc(path_len + 1);
+    if (!dir->path) return NULL;
+    memcpy(dir->path, path, path_len);
+    dir->path[path_len] = '\0';
+
+    list_dir(dir);
+    return dir;
+}
+
+int dircache_is_missing(dircache_t* cache, const char* filename) {
+    const char* name;
+    const char* path;
+    size_t path_len;
+    dircache_dir_t* dir;
+    int missing = 0;
+
+    if (!cache || !filename)
+        return 0;
+
+    /* split "path/name" (no path = current dir) */
+    name = strrchr(filename, '/');
+#ifdef USE_DIRCACHE_WIN32
+    {
+        const char* name_bs = strrchr(filename, '\\');
+        if (!name || (name_bs && name_bs > name))
+            name = name_bs;
+    }
+#endif
+    if (name) {
+        path = filename;
+        path_len = name - filename;
+        name++;
+        if (path_len == 0) { /* root */
+            path = "/";
+            path_len = 1;
+        }
+    }
+    else {
+        path = ".";
+        path_len = 1;
+        name = filename;
+    }
+
+    if (name[0] == '\0')
+        return 0;
+
+#ifdef USE_DIRCACHE_DIRENT
+    /* Names are compared ignoring case, so on case sensitive filesystems a different case only means
+     * "unknown" (caller's open then fails as usual). Non-ASCII names may also be case folded or normalized
+     * differently by the filesystem (macOS), so those are always unknown. */
+    {
+        const unsigned char* c;
+        for (c = (const unsigned char*)name; *c; c++) {
+            if (*c >= 0x80)
+                return 0;
+        }
+    }
+#endif
+
+    lock_cache(cache);
+    dir = get_dir(cache, path, path_len);
+    if (dir && dir->listed) {
+        missing = bsearch(&name, dir->names, dir->count, sizeof(char*), compare_names) == NULL;
+    }
+    unlock_cache(cache);
+
+    return missing;
+}
+
+#else
+
+int dircache_is_missing(dircache_t* cache, const char* filename) {
+    return 0; /* can't list dirs */
+}
+
+#endif
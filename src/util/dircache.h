@@ -0,0 +1,25 @@
+#ifndef _DIRCACHE_H
+#define _DIRCACHE_H
+
+/* Cache of directory listings, to answer "does this file exist" without trying to open it.
+ * Formats probe many companion files (.txth, .txtm, keys, L/R pairs) that usually don't exist,
+ * and failed opens are slow on network drives. Notes:
+ * - listings are read once per directory, so files created later aren't seen (use a new cache)
+ * - only says if a file is known to be missing, otherwise caller should try to open it as usual
+ *   (names are matched ignoring case, since the filesystem may not be case sensitive)
+ * - refcounted and thread-safe (when threads are available) so it can be shared between SFs
+ */
+
+typedef struct dircache_t dircache_t;
+
+/* creates a new cache (with 1 ref) */
+dircache_t* dircache_init(void);
+/* adds a ref, returns the same cache */
+dircache_t* dircache_ref(dircache_t* cache);
+/* removes a ref, freeing the cache when none are left */
+void dircache_free(dircache_t* cache);
+
+/* returns 1 if filename's directory could be listed and file isn't there, 0 if it exists or unknown */
+int dircache_is_missing(dircache_t* cache, const char* filename);
+
+#endif
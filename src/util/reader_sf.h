@@ -5,48 +5,56 @@
 
 /* Sometimes you just need an int, and we're doing the buffering.
 * Note, however, that if these fail to read they'll return -1,
-* so that should not be a valid value or there should be some backup. */
+* so that should not be a valid value or there should be some backup.
+* Data is peeked from the SF's buffer when possible to avoid copies (these are called a lot). */
 static inline int16_t read_16bitLE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[2];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 2, sf);
 
-    if (read_streamfile(buf,offset,2,sf)!=2) return -1;
-    return get_16bitLE(buf);
+    if (!ptr) return -1;
+    return get_16bitLE(ptr);
 }
 static inline int16_t read_16bitBE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[2];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 2, sf);
 
-    if (read_streamfile(buf,offset,2,sf)!=2) return -1;
-    return get_16bitBE(buf);
+    if (!ptr) return -1;
+    return get_16bitBE(ptr);
 }
 static inline int32_t read_32bitLE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[4];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 4, sf);
 
-    if (read_streamfile(buf,offset,4,sf)!=4) return -1;
-    return get_32bitLE(buf);
+    if (!ptr) return -1;
+    return get_32bitLE(ptr);
 }
 static inline int32_t read_32bitBE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[4];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 4, sf);
 
-    if (read_streamfile(buf,offset,4,sf)!=4) return -1;
-    return get_32bitBE(buf);
+    if (!ptr) return -1;
+    return get_32bitBE(ptr);
 }
 static inline int64_t read_64bitLE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[8];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 8, sf);
 
-    if (read_streamfile(buf,offset,8,sf)!=8) return -1;
-    return get_64bitLE(buf);
+    if (!ptr) return -1;
+    return get_64bitLE(ptr);
 }
 static inline int64_t read_64bitBE(off_t offset, STREAMFILE* sf) {
     uint8_t buf[8];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 8, sf);
 
-    if (read_streamfile(buf,offset,8,sf)!=8) return -1;
-    return get_64bitBE(buf);
+    if (!ptr) return -1;
+    return get_64bitBE(ptr);
 }
 static inline int8_t read_8bit(off_t offset, STREAMFILE* sf) {
     uint8_t buf[1];
+    const uint8_t* ptr = peek_streamfile(buf, offset, 1, sf);
 
-    if (read_streamfile(buf,offset,1,sf)!=1) return -1;
-    return buf[0];
+    if (!ptr) return -1;
+    return ptr[0];
 }
 
 /* alias of the above */
@@ -67,17 +75,19 @@ static inline uint64_t read_u64le(off_t offset, STREAMFILE* sf) { return (uint64
 
 static inline float read_f32be(off_t offset, STREAMFILE* sf) {
     uint8_t buf[4];
+    const uint8_t* ptr = peek_streamfile(buf, offset, sizeof(buf), sf);
 
-    if (read_streamfile(buf, offset, sizeof(buf), sf) != sizeof(buf))
+    if (!ptr)
         return -1;
-    return get_f32be(buf);
+    return get_f32be(ptr);
 }
 static inline float    read_f32le(off_t offset, STREAMFILE* sf) {
     uint8_t buf[4];
+    const uint8_t* ptr = peek_streamfile(buf, offset, sizeof(buf), sf);
 
-    if (read_streamfile(buf, offset, sizeof(buf), sf) != sizeof(buf))
+    if (!ptr)
         return -1;
-    return get_f32le(buf);
+    return get_f32le(ptr);
 }
 
 #if 0
@@ -1,4 +1,6 @@
+#include <string.h>
 #include "samples_ops.h"
+#include "../coding/coding_utils_simd.h"
 
 
 void swap_samples_le(sample_t *buf, int count) {
@@ -21,6 +23,89 @@ void swap_samples_le(sample_t *buf, int count) {
 }
 
 
+void interleave_samples(sample_t* dst, const sample_t* src, int channels, int32_t plane_size, int32_t sample_count) {
+    int32_t s = 0;
+    int ch;
+
+    if (channels == 1) {
+        memcpy(dst, src, sample_count * sizeof(sample_t));
+        return;
+    }
+
+#ifdef VGM_SIMD_SSE2
+    if (channels == 2) {
+        const sample_t* src_l = src;
+        const sample_t* src_r = src + plane_size;
+        for (; s + 8 <= sample_count; s += 8) {
+            __m128i l = _mm_loadu_si128((const __m128i*)(src_l + s));
+            __m128i r = _mm_loadu_si128((const __m128i*)(src_r + s));
+            _mm_storeu_si128((__m128i*)(dst + s*2 + 0), _mm_unpacklo_epi16(l, r));
+            _mm_storeu_si128((__m128i*)(dst + s*2 + 8), _mm_unpackhi_epi16(l, r));
+        }
+    }
+#endif
+
+    for (; s < sample_count; s++) {
+        for (ch = 0; ch < channels; ch++) {
+            dst[s*channels + ch] = src[ch*plane_size + s];
+        }
+    }
+}
+
+void deinterleave_samples(sample_t* dst, const sample_t* src, int channels, int32_t plane_size, int32_t sample_count) {
+    int32_t s = 0;
+    int ch;
+
+    if (channels == 1) {
+        memcpy(dst, src, sample_count * sizeof(sample_t));
+        return;
+    }
+
+#ifdef VGM_SIMD_SSE2
+    if (channels == 2) {
+        sample_t* dst_l = dst;
+        sample_t* dst_r = dst + plane_size;
+        for (; s + 8 <= sample_count; s += 8) {
+            __m128i v0 = _mm_loadu_si128((const __m128i*)(src + s*2 + 0));
+            __m128i v1 = _mm_loadu_si128((const __m128i*)(src + s*2 + 8));
+            /* sign-extended low/high halves of each LR pair, packed back (no saturation needed) */
+            __m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(v0, 16), 16), _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16));
+            __m128i r = _mm_packs_epi32(_mm_srai_epi32(v0, 16), _mm_srai_epi32(v1, 16));
+            _mm_storeu_si128((__m128i*)(dst_l + s), l);
+            _mm_storeu_si128((__m128i*)(dst_r + s), r);
+        }
+    }
+#endif
+
+    for (ch = 0; ch < channels; ch++) {
+        sample_t* plane = dst + ch*plane_size;
+        int32_t i;
+        for (i = s; i < sample_count; i++) {
+            plane[i] = src[i*channels + ch];
+        }
+    }
+}
+
+void samples_s16_to_f32(float* dst, const sample_t* src, int count) {
+    const float scale = 1.0f / 32768.0f;
+    int i = 0;
+
+#ifdef VGM_SIMD_SSE2
+    const __m128 scale_v = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); /* sign-extend */
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale_v));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale_v));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+
 /* unused */
 /*
 void interleave_channel(sample_t * outbuffer, sample_t * inbuffer, int32_t sample_count, int channel_count, int channel_number) {
@@ -6,4 +6,13 @@
 /* swap samples in machine endianness to little endian (useful to write .wav) */
 void swap_samples_le(sample_t* buf, int count);
 
+/* joins 'channels' planes of sample_count samples (plane N starts at src + N * plane_size) into interleaved dst */
+void interleave_samples(sample_t* dst, const sample_t* src, int channels, int32_t plane_size, int32_t sample_count);
+
+/* splits interleaved src (sample_count samples per channel) into planes (plane N starts at dst + N * plane_size) */
+void deinterleave_samples(sample_t* dst, const sample_t* src, int channels, int32_t plane_size, int32_t sample_count);
+
+/* converts int16 samples to float (-1.0..1.0) */
+void samples_s16_to_f32(float* dst, const sample_t* src, int count);
+
 #endif
@@ -90,13 +90,16 @@ STREAMFILE* open_streamfile_by_filename(STREAMFILE* sf, const char* filename) {
 
 int check_extensions(STREAMFILE* sf, const char* cmp_exts) {
     char filename[PATH_LIMIT];
-    const char* ext = NULL;
+
+    sf->get_name(sf, filename, sizeof(filename));
+    return check_extension_list(filename_extension(filename), cmp_exts);
+}
+
+int check_extension_list(const char* ext, const char* cmp_exts) {
     const char* cmp_ext = NULL;
     const char* ststr_res = NULL;
     size_t ext_len, cmp_len;
 
-    sf->get_name(sf, filename, sizeof(filename));
-    ext = filename_extension(filename);
     ext_len = strlen(ext);
 
     cmp_ext = cmp_exts;
@@ -18,6 +18,8 @@ STREAMFILE* open_streamfile_by_filename(STREAMFILE* sf, const char* filename);
 /* Checks if the stream filename is one of the extensions (comma-separated, ex. "adx" or "adx,aix").
  * Empty is ok to accept files without extension ("", "adx,,aix"). Returns 0 on failure */
 int check_extensions(STREAMFILE* sf, const char* cmp_exts);
+/* same, for an already extracted extension */
+int check_extension_list(const char* ext, const char* cmp_exts);
 
 /* filename helpers */
 void get_streamfile_name(STREAMFILE* sf, char* buf, size_t size);
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include "thread.h"
+
+/* win32 condition variables need Vista+, older targets (like _WIN32_WINNT=0x501) just get no threads */
+#if defined(_WIN32) || defined(WIN32)
+    #include <windows.h>
+    #if defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0600
+        #define VGM_THREADS_NONE
+    #else
+        #define VGM_THREADS_WIN32
+    #endif
+#elif defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    #define VGM_THREADS_NONE
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #define VGM_THREADS_PTHREAD
+#endif
+
+
+#if defined(VGM_THREADS_PTHREAD)
+
+struct vgm_thread_t {
+    pthread_t handle;
+    void (*callback)(void*);
+    void* arg;
+};
+struct vgm_mutex_t {
+    pthread_mutex_t handle;
+};
+struct vgm_cond_t {
+    pthread_cond_t handle;
+};
+
+static void* thread_start(void* arg) {
+    vgm_thread_t* thread = arg;
+    thread->callback(thread->arg);
+    return NULL;
+}
+
+vgm_thread_t* vgm_thread_create(void (*callback)(void*), void* arg) {
+    vgm_thread_t* thread = calloc(1, sizeof(vgm_thread_t));
+    if (!thread) return NULL;
+
+    thread->callback = callback;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, thread_start, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void vgm_thread_join(vgm_thread_t* thread) {
+    if (!thread) return;
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+vgm_mutex_t* vgm_mutex_init(void) {
+    vgm_mutex_t* mutex = calloc(1, sizeof(vgm_mutex_t));
+    if (!mutex) return NULL;
+
+    if (pthread_mutex_init(&mutex->handle, NULL) != 0) {
+        free(mutex);
+        return NULL;
+    }
+    return mutex;
+}
+
+void vgm_mutex_free(vgm_mutex_t* mutex) {
+    if (!mutex) return;
+    pthread_mutex_destroy(&mutex->handle);
+    free(mutex);
+}
+
+void vgm_mutex_lock(vgm_mutex_t* mutex) {
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void vgm_mutex_unlock(vgm_mutex_t* mutex) {
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+vgm_cond_t* vgm_cond_init(void) {
+    vgm_cond_t* cond = calloc(1, sizeof(vgm_cond_t));
+    if (!cond) return NULL;
+
+    if (pthread_cond_init(&cond->handle, NULL) != 0) {
+        free(cond);
+        return NULL;
+    }
+    return cond;
+}
+
+void vgm_cond_free(vgm_cond_t* cond) {
+    if (!cond) return;
+    pthread_cond_destroy(&cond->handle);
+    free(cond);
+}
+
+void vgm_cond_wait(vgm_cond_t* cond, vgm_mutex_t* mutex) {
+    pthread_cond_wait(&cond->handle, &mutex->handle);
+}
+
+void vgm_cond_signal(vgm_cond_t* cond) {
+    pthread_cond_signal(&cond->handle);
+}
+
+void vgm_cond_broadcast(vgm_cond_t* cond) {
+    pthread_cond_broadcast(&cond->handle);
+}
+
+int vgm_thread_get_cpus(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0)
+        return (int)cpus;
+#endif
+    return 1;
+}
+
+#elif defined(VGM_THREADS_WIN32)
+
+struct vgm_thread_t {
+    HANDLE handle;
+    void (*callback)(void*);
+    void* arg;
+};
+struct vgm_mutex_t {
+    CRITICAL_SECTION handle;
+};
+struct vgm_cond_t {
+    CONDITION_VARIABLE handle;
+};
+
+static DWORD WINAPI thread_start(LPVOID arg) {
+    vgm_thread_t* thread = arg;
+    thread->callback(thread->arg);
+    return 0;
+}
+
+vgm_thread_t* vgm_thread_create(void (*callback)(void*), void* arg) {
+    vgm_thread_t* thread = calloc(1, sizeof(vgm_thread_t));
+    if (!thread) return NULL;
+
+    thread->callback = callback;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, thread_start, thread, 0, NULL);
+    if (!thread->handle) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void vgm_thread_join(vgm_thread_t* thread) {
+    if (!thread) return;
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+vgm_mutex_t* vgm_mutex_init(void) {
+    vgm_mutex_t* mutex = calloc(1, sizeof(vgm_mutex_t));
+    if (!mutex) return NULL;
+
+    InitializeCriticalSection(&mutex->handle);
+    return mutex;
+}
+
+void vgm_mutex_free(vgm_mutex_t* mutex) {
+    if (!mutex) return;
+    DeleteCriticalSection(&mutex->handle);
+    free(mutex);
+}
+
+void vgm_mutex_lock(vgm_mutex_t* mutex) {
+    EnterCriticalSection(&mutex->handle);
+}
+
+void vgm_mutex_unlock(vgm_mutex_t* mutex) {
+    LeaveCriticalSection(&mutex->handle);
+}
+
+vgm_cond_t* vgm_cond_init(void) {
+    vgm_cond_t* cond = calloc(1, sizeof(vgm_cond_t));
+    if (!cond) return NULL;
+
+    InitializeConditionVariable(&cond->handle);
+    return cond;
+}
+
+void vgm_cond_free(vgm_cond_t* cond) {
+    free(cond); /* no destroy needed */
+}
+
+void vgm_cond_wait(vgm_cond_t* cond, vgm_mutex_t* mutex) {
+    SleepConditionVariableCS(&cond->handle, &mutex->handle, INFINITE);
+}
+
+void vgm_cond_signal(vgm_cond_t* cond) {
+    WakeConditionVariable(&cond->handle);
+}
+
+void vgm_cond_broadcast(vgm_cond_t* cond) {
+    WakeAllConditionVariable(&cond->handle);
+}
+
+int vgm_thread_get_cpus(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (info.dwNumberOfProcessors > 0)
+        return (int)info.dwNumberOfProcessors;
+    return 1;
+}
+
+#else
+
+/* no threads: everything fails so callers use their fallbacks */
+vgm_thread_t* vgm_thread_create(void (*callback)(void*), void* arg) { return NULL; }
+void vgm_thread_join(vgm_thread_t* thread) { }
+
+vgm_mutex_t* vgm_mutex_init(void) { return NULL; }
+void vgm_mutex_free(vgm_mutex_t* mutex) { }
+void vgm_mutex_lock(vgm_mutex_t* mutex) { }
+void vgm_mutex_unlock(vgm_mutex_t* mutex) { }
+
+vgm_cond_t* vgm_cond_init(void) { return NULL; }
+void vgm_cond_free(vgm_cond_t* cond) { }
+void vgm_cond_wait(vgm_cond_t* cond, vgm_mutex_t* mutex) { }
+void vgm_cond_signal(vgm_cond_t* cond) { }
+void vgm_cond_broadcast(vgm_cond_t* cond) { }
+
+int vgm_thread_get_cpus(void) { return 1; }
+
+#endif
+
+
+/* atomics don't depend on thread support (work the same when there is a single thread) */
+#if defined(__GNUC__) || defined(__clang__)
+
+int vgm_atomic_inc(volatile int* value) { return __atomic_add_fetch(value, 1, __ATOMIC_ACQ_REL); }
+int vgm_atomic_dec(volatile int* value) { return __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL); }
+
+#elif defined(_WIN32) || defined(WIN32)
+
+int vgm_atomic_inc(volatile int* value) { return InterlockedIncrement((volatile LONG*)value); }
+int vgm_atomic_dec(volatile int* value) { return InterlockedDecrement((volatile LONG*)value); }
+
+#else
+
+int vgm_atomic_inc(volatile int* value) { return ++(*value); }
+int vgm_atomic_dec(volatile int* value) { return --(*value); }
+
+#endif
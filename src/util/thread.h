@@ -0,0 +1,38 @@
+#ifndef _UTIL_THREAD_H
+#define _UTIL_THREAD_H
+
+/* Minimal threading utils for background/parallel work (pthreads or win32). Notes:
+ * - any function may fail (systems without threads, or old win32 targets without condition variables),
+ *   so callers must have a non-threaded fallback
+ * - objects are opaque and allocated on init, freed on free/join
+ */
+
+typedef struct vgm_thread_t vgm_thread_t;
+typedef struct vgm_mutex_t vgm_mutex_t;
+typedef struct vgm_cond_t vgm_cond_t;
+
+/* starts a thread that runs callback(arg); returns NULL if not possible */
+vgm_thread_t* vgm_thread_create(void (*callback)(void*), void* arg);
+/* waits until thread finishes and frees it */
+void vgm_thread_join(vgm_thread_t* thread);
+
+vgm_mutex_t* vgm_mutex_init(void);
+void vgm_mutex_free(vgm_mutex_t* mutex);
+void vgm_mutex_lock(vgm_mutex_t* mutex);
+void vgm_mutex_unlock(vgm_mutex_t* mutex);
+
+vgm_cond_t* vgm_cond_init(void);
+void vgm_cond_free(vgm_cond_t* cond);
+/* releases mutex (must be locked) while waiting, and re-locks it on wakeup (which may be spurious) */
+void vgm_cond_wait(vgm_cond_t* cond, vgm_mutex_t* mutex);
+void vgm_cond_signal(vgm_cond_t* cond);
+void vgm_cond_broadcast(vgm_cond_t* cond);
+
+/* atomic add/subtract for counters shared between threads (like refcounts); returns the new value */
+int vgm_atomic_inc(volatile int* value);
+int vgm_atomic_dec(volatile int* value);
+
+/* number of logical CPUs (1 if unknown) */
+int vgm_thread_get_cpus(void);
+
+#endif
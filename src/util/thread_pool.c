@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include "thread_pool.h"
+#include "thread.h"
+
+#define VGM_POOL_MAX_THREADS 64
+
+struct vgm_pool_t {
+    int threads;
+    vgm_thread_t* workers[VGM_POOL_MAX_THREADS];
+    int workers_count;
+
+    vgm_mutex_t* mutex;     /* protects all fields below */
+    vgm_cond_t* cond_work;  /* signaled when a job is posted (or on free) */
+    vgm_cond_t* cond_done;  /* signaled when all calls of a job are done */
+    int stop;
+
+    /* current job */
+    void (*callback)(void* arg, int index);
+    void* arg;
+    int count;
+    int next;               /* next index to call */
+    int done;               /* finished calls */
+    unsigned int job_id;    /* changes on each post, so workers know there is new work */
+};
+
+/* takes indexes until there are none left (mutex must be locked, and is locked on return) */
+static void pool_work(vgm_pool_t* pool) {
+    while (pool->next < pool->count) {
+        void (*callback)(void*, int) = pool->callback;
+        void* arg = pool->arg;
+        int index = pool->next++;
+
+        vgm_mutex_unlock(pool->mutex);
+        callback(arg, index);
+        vgm_mutex_lock(pool->mutex);
+
+        pool->done++;
+        if (pool->done == pool->count)
+            vgm_cond_signal(pool->cond_done);
+    }
+}
+
+static void pool_worker(void* arg) {
+    vgm_pool_t* pool = arg;
+    unsigned int job_id = 0;
+
+    vgm_mutex_lock(pool->mutex);
+    while (1) {
+        while (!pool->stop && pool->job_id == job_id) {
+            vgm_cond_wait(pool->cond_work, pool->mutex);
+        }
+        if (pool->stop)
+            break;
+
+        job_id = pool->job_id;
+        pool_work(pool);
+    }
+    vgm_mutex_unlock(pool->mutex);
+}
+
+vgm_pool_t* vgm_pool_init(int threads) {
+    vgm_pool_t* pool = NULL;
+    int i;
+
+    if (threads <= 1)
+        return NULL;
+    if (threads > VGM_POOL_MAX_THREADS)
+        threads = VGM_POOL_MAX_THREADS;
+
+    pool = calloc(1, sizeof(vgm_pool_t));
+    if (!pool) goto fail;
+
+    pool->mutex = vgm_mutex_init();
+    pool->cond_work = vgm_cond_init();
+    pool->cond_done = vgm_cond_init();
+    if (!pool->mutex || !pool->cond_work || !pool->cond_done) goto fail;
+
+    for (i = 0; i < threads - 1; i++) {
+        pool->workers[i] = vgm_thread_create(pool_worker, pool);
+        if (!pool->workers[i]) goto fail;
+        pool->workers_count++;
+    }
+
+    pool->threads = threads;
+    return pool;
+fail:
+    vgm_pool_free(pool);
+    return NULL;
+}
+
+void vgm_pool_free(vgm_pool_t* pool) {
+    int i;
+
+    if (!pool)
+        return;
+
+    if (pool->workers_count) {
+        vgm_mutex_lock(pool->mutex);
+        pool->stop = 1;
+        vgm_cond_broadcast(pool->cond_work);
+        vgm_mutex_unlock(pool->mutex);
+
+        for (i = 0; i < pool->workers_count; i++) {
+            vgm_thread_join(pool->workers[i]);
+        }
+    }
+
+    vgm_cond_free(pool->cond_done);
+    vgm_cond_free(pool->cond_work);
+    vgm_mutex_free(pool->mutex);
+    free(pool);
+}
+
+int vgm_pool_get_threads(vgm_pool_t* pool) {
+    if (!pool)
+        return 1;
+    return pool->threads;
+}
+
+void vgm_pool_run(vgm_pool_t* pool, void (*callback)(void* arg, int index), void* arg, int count) {
+    int i;
+
+    if (count <= 0)
+        return;
+
+    if (!pool || count == 1) {
+        for (i = 0; i < count; i++) {
+            callback(arg, i);
+        }
+        return;
+    }
+
+    vgm_mutex_lock(pool->mutex);
+    pool->callback = callback;
+    pool->arg = arg;
+    pool->count = count;
+    pool->next = 0;
+    pool->done = 0;
+    pool->job_id++;
+    vgm_cond_broadcast(pool->cond_work);
+
+    /* work too, then wait for calls taken by workers */
+    pool_work(pool);
+    while (pool->done < pool->count) {
+        vgm_cond_wait(pool->cond_done, pool->mutex);
+    }
+    vgm_mutex_unlock(pool->mutex);
+}
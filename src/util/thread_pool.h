@@ -0,0 +1,21 @@
+#ifndef _UTIL_THREAD_POOL_H
+#define _UTIL_THREAD_POOL_H
+
+/* Simple fork-join pool: N-1 workers wait for jobs, and the calling thread also works while
+ * a job runs (so a pool of 1 thread does everything serially). Made over thread.h, so init may fail
+ * on systems without threads and callers must do their work directly in that case. */
+
+typedef struct vgm_pool_t vgm_pool_t;
+
+/* starts a pool with N threads (including the caller's); returns NULL if not possible */
+vgm_pool_t* vgm_pool_init(int threads);
+/* stops workers and frees the pool */
+void vgm_pool_free(vgm_pool_t* pool);
+
+int vgm_pool_get_threads(vgm_pool_t* pool);
+
+/* calls callback(arg, index) for index 0..count-1 over all threads, and returns once all calls are done
+ * (pool must not be used by more than one caller at the same time) */
+void vgm_pool_run(vgm_pool_t* pool, void (*callback)(void* arg, int index), void* arg, int count);
+
+#endif
@@ -12,552 +12,570 @@
 #include "base/decode.h"
 #include "base/render.h"
 #include "base/mixing.h"
+#include "base/meta_profile.h"
 #include "util/sf_utils.h"
 
 typedef VGMSTREAM* (*init_vgmstream_t)(STREAMFILE*);
 
+/* Meta parser plus what it requires to accept a file, so init can skip metas that would fail anyway without
+ * calling them (it's much faster to reject files or find the meta this way). Since the checks are used to
+ * skip metas they must be the same as the meta's first checks: exts must be the exact list passed to
+ * check_extensions, and magic must be a value that is always tested (at a fixed offset). If unsure leave
+ * them empty and the meta will be tried with every file, as usual. */
+typedef struct {
+    init_vgmstream_t init;
+    const char* name;       /* init function name (for profiling) */
+    const char* exts;       /* required extensions (NULL: any) */
+    uint8_t magic_offset;   /* max META_HEADER_SIZE - magic_size */
+    uint8_t magic_size;     /* 1/2/4, or 0 if no magic */
+    uint32_t magic;         /* value as read in BE (LE magic must be byteswapped) */
+} meta_entry_t;
+
+/* init function plus its name */
+#define META(init) init, #init
+
 static void try_dual_file_stereo(VGMSTREAM* opened_vgmstream, STREAMFILE* sf, init_vgmstream_t init_vgmstream_function);
 
-/* list of metadata parser functions that will recognize files, used on init */
-init_vgmstream_t init_vgmstream_functions[] = {
-    init_vgmstream_adx,
-    init_vgmstream_brstm,
-    init_vgmstream_brwav,
-    init_vgmstream_bfwav,
-    init_vgmstream_bcwav,
-    init_vgmstream_brwar,
-    init_vgmstream_nds_strm,
-    init_vgmstream_afc,
-    init_vgmstream_ast,
-    init_vgmstream_halpst,
-    init_vgmstream_rs03,
-    init_vgmstream_ngc_dsp_std,
-    init_vgmstream_ngc_dsp_std_le,
-    init_vgmstream_ngc_mdsp_std,
-    init_vgmstream_csmp,
-    init_vgmstream_rfrm,
-    init_vgmstream_cstr,
-    init_vgmstream_gcsw,
-    init_vgmstream_ads,
-    init_vgmstream_nps,
-    init_vgmstream_xa,
-    init_vgmstream_rxws,
-    init_vgmstream_ngc_dsp_stm,
-    init_vgmstream_exst,
-    init_vgmstream_svag_kcet,
-    init_vgmstream_ngc_mpdsp,
-    init_vgmstream_ngc_dsp_std_int,
-    init_vgmstream_vag,
-    init_vgmstream_vag_aaap,
-    init_vgmstream_ild,
-    init_vgmstream_ngc_str,
-    init_vgmstream_ea_schl,
-    init_vgmstream_caf,
-    init_vgmstream_vpk,
-    init_vgmstream_genh,
-    init_vgmstream_ogg_vorbis,
-    init_vgmstream_sfl_ogg,
-    init_vgmstream_sadb,
-    init_vgmstream_ps2_bmdx,
-    init_vgmstream_wsi,
-    init_vgmstream_aifc,
-    init_vgmstream_str_snds,
-    init_vgmstream_ws_aud,
-    init_vgmstream_ahx,
-    init_vgmstream_ivb,
-    init_vgmstream_svs,
-    init_vgmstream_riff,
-    init_vgmstream_rifx,
-    init_vgmstream_nwa,
-    init_vgmstream_ea_1snh,
-    init_vgmstream_ea_eacs,
-    init_vgmstream_xss,
-    init_vgmstream_sl3,
-    init_vgmstream_hgc1,
-    init_vgmstream_aus,
-    init_vgmstream_rws,
-    init_vgmstream_fsb,
-    init_vgmstream_fsb4_wav,
-    init_vgmstream_fsb5,
-    init_vgmstream_rwax,
-    init_vgmstream_xwb,
-    init_vgmstream_ps2_xa30,
-    init_vgmstream_musc,
-    init_vgmstream_musx,
-    init_vgmstream_filp,
-    init_vgmstream_ikm,
-    init_vgmstream_ster,
-    init_vgmstream_bg00,
-    init_vgmstream_sat_dvi,
-    init_vgmstream_dc_kcey,
-    init_vgmstream_rstm_rockstar,
-    init_vgmstream_acm,
-    init_vgmstream_mus_acm,
-    init_vgmstream_ps2_kces,
-    init_vgmstream_hxd,
-    init_vgmstream_vsv,
-    init_vgmstream_ps2_pcm,
-    init_vgmstream_ps2_rkv,
-    init_vgmstream_ps2_vas,
-    init_vgmstream_ps2_vas_container,
-    init_vgmstream_lp_ap_lep,
-    init_vgmstream_sdt,
-    init_vgmstream_aix,
-    init_vgmstream_ngc_tydsp,
-    init_vgmstream_wvs_xbox,
-    init_vgmstream_wvs_ngc,
-    init_vgmstream_dc_str,
-    init_vgmstream_dc_str_v2,
-    init_vgmstream_xbox_matx,
-    init_vgmstream_dec,
-    init_vgmstream_vs,
-    init_vgmstream_dc_str,
-    init_vgmstream_dc_str_v2,
-    init_vgmstream_xmu,
-    init_vgmstream_xvas,
-    init_vgmstream_sat_sap,
-    init_vgmstream_dc_idvi,
-    init_vgmstream_ps2_rnd,
-    init_vgmstream_idsp_tt,
-    init_vgmstream_kraw,
-    init_vgmstream_omu,
-    init_vgmstream_xa2_acclaim,
-    init_vgmstream_idsp_nl,
-    init_vgmstream_idsp_ie,
-    init_vgmstream_ymf,
-    init_vgmstream_sadl,
-    init_vgmstream_fag,
-    init_vgmstream_ps2_mihb,
-    init_vgmstream_ngc_pdt_split,
-    init_vgmstream_ngc_pdt,
-    init_vgmstream_wii_mus,
-    init_vgmstream_dc_asd,
-    init_vgmstream_spsd,
-    init_vgmstream_rsd,
-    init_vgmstream_bgw,
-    init_vgmstream_spw,
-    init_vgmstream_ps2_ass,
-    init_vgmstream_ubi_jade,
-    init_vgmstream_ubi_jade_container,
-    init_vgmstream_seg,
-    init_vgmstream_nds_strm_ffta2,
-    init_vgmstream_knon,
-    init_vgmstream_gca,
-    init_vgmstream_spt_spd,
-    init_vgmstream_ish_isd,
-    init_vgmstream_gsp_gsb,
-    init_vgmstream_ydsp,
-    init_vgmstream_ngc_ssm,
-    init_vgmstream_ps2_joe,
-    init_vgmstream_vgs,
-    init_vgmstream_dcs_wav,
-    init_vgmstream_mul,
-    init_vgmstream_thp,
-    init_vgmstream_sts,
-    init_vgmstream_ps2_p2bt,
-    init_vgmstream_ps2_gbts,
-    init_vgmstream_wii_sng,
-    init_vgmstream_ngc_dsp_iadp,
-    init_vgmstream_aax,
-    init_vgmstream_utf_dsp,
-    init_vgmstream_ngc_ffcc_str,
-    init_vgmstream_sat_baka,
-    init_vgmstream_swav,
-    init_vgmstream_vsf,
-    init_vgmstream_nds_rrds,
-    init_vgmstream_ps2_vsf_tta,
-    init_vgmstream_ads_midway,
-    init_vgmstream_ps2_mcg,
-    init_vgmstream_zsd,
-    init_vgmstream_vgs_ps,
-    init_vgmstream_redspark,
-    init_vgmstream_ivaud,
-    init_vgmstream_wii_wsd,
-    init_vgmstream_dsp_ndp,
-    init_vgmstream_ps2_sps,
-    init_vgmstream_nds_hwas,
-    init_vgmstream_ngc_lps,
-    init_vgmstream_ps2_snd,
-    init_vgmstream_naomi_adpcm,
-    init_vgmstream_sd9,
-    init_vgmstream_2dx9,
-    init_vgmstream_dsp_ygo,
-    init_vgmstream_ps2_vgv,
-    init_vgmstream_gcub,
-    init_vgmstream_maxis_xa,
-    init_vgmstream_ngc_sck_dsp,
-    init_vgmstream_apple_caff,
-    init_vgmstream_pc_mxst,
-    init_vgmstream_sab,
-    init_vgmstream_wii_bns,
-    init_vgmstream_wii_was,
-    init_vgmstream_pona_3do,
-    init_vgmstream_pona_psx,
-    init_vgmstream_xbox_hlwav,
-    init_vgmstream_myspd,
-    init_vgmstream_his,
-    init_vgmstream_ast_mmv,
-    init_vgmstream_ast_mv,
-    init_vgmstream_dmsg,
-    init_vgmstream_ngc_dsp_aaap,
-    init_vgmstream_ngc_dsp_konami,
-    init_vgmstream_ps2_wb,
-    init_vgmstream_bnsf,
-    init_vgmstream_ps2_gcm,
-    init_vgmstream_smpl,
-    init_vgmstream_msa,
-    init_vgmstream_voi,
-    init_vgmstream_ngc_rkv,
-    init_vgmstream_dsp_ddsp,
-    init_vgmstream_p3d,
-    init_vgmstream_ngc_dsp_mpds,
-    init_vgmstream_dsp_str_ig,
-    init_vgmstream_ea_swvr,
-    init_vgmstream_ps2_b1s,
-    init_vgmstream_ps2_wad,
-    init_vgmstream_dsp_xiii,
-    init_vgmstream_dsp_cabelas,
-    init_vgmstream_lpcm_shade,
-    init_vgmstream_ps2_vms,
-    init_vgmstream_xau,
-    init_vgmstream_bar,
-    init_vgmstream_ffw,
-    init_vgmstream_dsp_dspw,
-    init_vgmstream_jstm,
-    init_vgmstream_xvag,
-    init_vgmstream_cps,
-    init_vgmstream_sqex_scd,
-    init_vgmstream_ngc_nst_dsp,
-    init_vgmstream_baf,
-    init_vgmstream_msf,
-    init_vgmstream_ps3_past,
-    init_vgmstream_sgxd,
-    init_vgmstream_wii_ras,
-    init_vgmstream_spm,
-    init_vgmstream_ps2_iab,
-    init_vgmstream_vs_str,
-    init_vgmstream_lsf_n1nj4n,
-    init_vgmstream_xwav_new,
-    init_vgmstream_xwav_old,
-    init_vgmstream_hyperscan_kvag,
-    init_vgmstream_ios_psnd,
-    init_vgmstream_adp_wildfire,
-    init_vgmstream_adp_qd,
-    init_vgmstream_eb_sfx,
-    init_vgmstream_eb_sf0,
-    init_vgmstream_mtaf,
-    init_vgmstream_alp,
-    init_vgmstream_wpd,
-    init_vgmstream_mn_str,
-    init_vgmstream_mss,
-    init_vgmstream_ps2_hsf,
-    init_vgmstream_ivag,
-    init_vgmstream_ps2_2pfs,
-    init_vgmstream_xnb,
-    init_vgmstream_ubi_ckd,
-    init_vgmstream_ps2_vbk,
-    init_vgmstream_otm,
-    init_vgmstream_bcstm,
-    init_vgmstream_idsp_namco,
-    init_vgmstream_kt_g1l,
-    init_vgmstream_kt_wiibgm,
-    init_vgmstream_bfstm,
-    init_vgmstream_mca,
+/* list of metadata parser functions that will recognize files, used on init (in priority order) */
+static const meta_entry_t init_vgmstream_functions[] = {
+    {META(init_vgmstream_adx), "adx,adp", 0x00, 2, 0x8000},
+    {META(init_vgmstream_brstm), "brstm,brstmspm", 0x00, 4, 0x5253544D},
+    {META(init_vgmstream_brwav), "brwav,rwav", 0x00, 4, 0x52574156},
+    {META(init_vgmstream_bfwav), "bfwav,fwav", 0x00, 4, 0x46574156},
+    {META(init_vgmstream_bcwav), "bcwav,adpcm,bms,sfx,str,zic", 0x00, 4, 0x43574156},
+    {META(init_vgmstream_brwar), "rwar", 0x00, 4, 0x52574152},
+    {META(init_vgmstream_nds_strm), "strm", 0x00, 4, 0x5354524D},
+    {META(init_vgmstream_afc), "afc,stx"},
+    {META(init_vgmstream_ast), "ast"},
+    {META(init_vgmstream_halpst), "hps"},
+    {META(init_vgmstream_rs03), "dsp", 0x00, 4, 0x52530003},
+    {META(init_vgmstream_ngc_dsp_std), "dsp,adp,"},
+    {META(init_vgmstream_ngc_dsp_std_le), "adpcm"},
+    {META(init_vgmstream_ngc_mdsp_std), "dsp,mdsp"},
+    {META(init_vgmstream_csmp), "csmp", 0x00, 4, 0x43534D50},
+    {META(init_vgmstream_rfrm), "csmp", 0x00, 4, 0x5246524D},
+    {META(init_vgmstream_cstr), "dsp", 0x00, 4, 0x43737472},
+    {META(init_vgmstream_gcsw), "gcw", 0x00, 4, 0x47435357},
+    {META(init_vgmstream_ads), "ads,ss2,pcm,adx,,800", 0x00, 4, 0x53536864},
+    {META(init_vgmstream_nps), "nps,npsf", 0x00, 4, 0x4E505346},
+    {META(init_vgmstream_xa), "xa,str,pxa,grn,an2,"},
+    {META(init_vgmstream_rxws), "xws,xwb"},
+    {META(init_vgmstream_ngc_dsp_stm), "stm,lstm,dsp", 0x00, 2, 0x0200},
+    {META(init_vgmstream_exst), "sts,sts_cp3,x", 0x00, 4, 0x45585354},
+    {META(init_vgmstream_svag_kcet), "svag", 0x00, 4, 0x53766167},
+    {META(init_vgmstream_ngc_mpdsp), "mpdsp,ste"},
+    {META(init_vgmstream_ngc_dsp_std_int), "dsp,mss,gcm"},
+    {META(init_vgmstream_vag), "vag,swag,str,vig,l,r,vas,xa2,snd"},
+    {META(init_vgmstream_vag_aaap), "vag", 0x00, 4, 0x41414170},
+    {META(init_vgmstream_ild), "ild", 0x00, 4, 0x494C4400},
+    {META(init_vgmstream_ngc_str), "str", 0x00, 4, 0xFAAF0001},
+    {META(init_vgmstream_ea_schl), "asf,lasf,str,chk,eam,exa,sng,aud,sx,xa,strm,stm,hab,xsf,gsf,"},
+    {META(init_vgmstream_caf), "caf,cfn,", 0x00, 4, 0x43414620},
+    {META(init_vgmstream_vpk), "vpk", 0x00, 4, 0x204B5056},
+    {META(init_vgmstream_genh), "genh", 0x00, 4, 0x47454E48},
+    {META(init_vgmstream_ogg_vorbis)},
+    {META(init_vgmstream_sfl_ogg), "sfl", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_sadb), "sad", 0x00, 4, 0x73616462},
+    {META(init_vgmstream_ps2_bmdx), "bmdx"},
+    {META(init_vgmstream_wsi), "wsi"},
+    {META(init_vgmstream_aifc), NULL, 0x00, 4, 0x464F524D},
+    {META(init_vgmstream_str_snds), "str,stream,3do"},
+    {META(init_vgmstream_ws_aud), "aud"},
+    {META(init_vgmstream_ahx), "ahx", 0x00, 2, 0x8000},
+    {META(init_vgmstream_ivb), "ivb", 0x00, 4, 0x42564949},
+    {META(init_vgmstream_svs), "svs", 0x00, 4, 0x53565300},
+    {META(init_vgmstream_riff), "wav,lwav,xwav,mwv,da,dax,cd,med,snd,adx,adp,xss,xsew,adpcm,adw,wd,,sbv,wvx,str,at3,rws,aud,at9,ckd,saf,ima,nsa,pcm,xvag,ogg,logg,p1d,xms,mus,dat,ldat", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_rifx), "wav,lwav", 0x00, 4, 0x52494658},
+    {META(init_vgmstream_nwa), "nwa"},
+    {META(init_vgmstream_ea_1snh), "asf,lasf,sng,as4,cnk,uv,tgq,tgv,"},
+    {META(init_vgmstream_ea_eacs), "eas,bnk,as4"},
+    {META(init_vgmstream_xss), "xss"},
+    {META(init_vgmstream_sl3), "ms,sl3", 0x00, 4, 0x534C3300},
+    {META(init_vgmstream_hgc1), "hgc1", 0x00, 4, 0x68674331},
+    {META(init_vgmstream_aus), "aus", 0x00, 4, 0x41555320},
+    {META(init_vgmstream_rws), "rws", 0x00, 4, 0x0D080000},
+    {META(init_vgmstream_fsb), "fsb,bnk,sfx,ps3,xen"},
+    {META(init_vgmstream_fsb4_wav), "fsb,wii", 0x00, 4, 0x00574156},
+    {META(init_vgmstream_fsb5), "fsb,snd", 0x00, 4, 0x46534235},
+    {META(init_vgmstream_rwax), "rwx", 0x00, 4, 0x52415758},
+    {META(init_vgmstream_xwb), "xwb,xna,hwb,bd,"},
+    {META(init_vgmstream_ps2_xa30), "xa,xa30", 0x00, 4, 0x58413330},
+    {META(init_vgmstream_musc), "mus,musc", 0x00, 4, 0x4D555343},
+    {META(init_vgmstream_musx), "sfx,musx", 0x00, 4, 0x4D555358},
+    {META(init_vgmstream_filp), "filp", 0x00, 4, 0x46494C70},
+    {META(init_vgmstream_ikm), "ikm", 0x00, 4, 0x494B4D00},
+    {META(init_vgmstream_ster), "ster,sfs", 0x00, 4, 0x53544552},
+    {META(init_vgmstream_bg00), "bg00", 0x00, 4, 0x42473030},
+    {META(init_vgmstream_sat_dvi), "pcm,dvi", 0x00, 4, 0x4456492E},
+    {META(init_vgmstream_dc_kcey), "pcm,kcey", 0x00, 4, 0x4B434559},
+    {META(init_vgmstream_rstm_rockstar), "rsm,rstm", 0x00, 4, 0x5253544D},
+    {META(init_vgmstream_acm), "acm,tun,wavc"},
+    {META(init_vgmstream_mus_acm), "mus"},
+    {META(init_vgmstream_ps2_kces), "kces,vig", 0x00, 4, 0x01006408},
+    {META(init_vgmstream_hxd), "hxd", 0x00, 4, 0x00445848},
+    {META(init_vgmstream_vsv), "vsv,psh"},
+    {META(init_vgmstream_ps2_pcm), "pcm"},
+    {META(init_vgmstream_ps2_rkv), "rkv", 0x24, 4, 0x00000000},
+    {META(init_vgmstream_ps2_vas), "vas"},
+    {META(init_vgmstream_ps2_vas_container), "vas"},
+    {META(init_vgmstream_lp_ap_lep), "bin,lbin,lp,lep,ap"},
+    {META(init_vgmstream_sdt), "sdt"},
+    {META(init_vgmstream_aix), "aix", 0x00, 4, 0x41495846},
+    {META(init_vgmstream_ngc_tydsp), "tydsp"},
+    {META(init_vgmstream_wvs_xbox), "wvs", 0x0c, 2, 0x6900},
+    {META(init_vgmstream_wvs_ngc), "wvs"},
+    {META(init_vgmstream_dc_str), "str"},
+    {META(init_vgmstream_dc_str_v2), "str"},
+    {META(init_vgmstream_xbox_matx), "matx"},
+    {META(init_vgmstream_dec), "dec,de2"},
+    {META(init_vgmstream_vs), "vs", 0x00, 4, 0xC8000000},
+    {META(init_vgmstream_dc_str), "str"},
+    {META(init_vgmstream_dc_str_v2), "str"},
+    {META(init_vgmstream_xmu), "xmu", 0x00, 4, 0x584D5520},
+    {META(init_vgmstream_xvas), "xvas"},
+    {META(init_vgmstream_sat_sap), "sap", 0x08, 4, 0x00000010},
+    {META(init_vgmstream_dc_idvi), "dvi,idvi", 0x00, 4, 0x49445649},
+    {META(init_vgmstream_ps2_rnd), "rnd"},
+    {META(init_vgmstream_idsp_tt), "gcm,idsp,wua", 0x00, 4, 0x49445350},
+    {META(init_vgmstream_kraw), "kraw", 0x00, 4, 0x6B524157},
+    {META(init_vgmstream_omu), "omu", 0x00, 4, 0x4F4D5520},
+    {META(init_vgmstream_xa2_acclaim), "xa2"},
+    {META(init_vgmstream_idsp_nl), "idsp", 0x00, 4, 0x49445350},
+    {META(init_vgmstream_idsp_ie), "idsp", 0x00, 4, 0x49445350},
+    {META(init_vgmstream_ymf), "ymf"},
+    {META(init_vgmstream_sadl), "sad", 0x00, 4, 0x7361646C},
+    {META(init_vgmstream_fag), "fag"},
+    {META(init_vgmstream_ps2_mihb), "mic,mihb", 0x00, 4, 0x40000000},
+    {META(init_vgmstream_ngc_pdt_split), "pdt"},
+    {META(init_vgmstream_ngc_pdt), "pdt", 0x00, 2, 0x0001},
+    {META(init_vgmstream_wii_mus), "mus"},
+    {META(init_vgmstream_dc_asd), "asd"},
+    {META(init_vgmstream_spsd), "str,spsd", 0x00, 4, 0x53505344},
+    {META(init_vgmstream_rsd), "rsd,rsp"},
+    {META(init_vgmstream_bgw), "bgw"},
+    {META(init_vgmstream_spw), "spw"},
+    {META(init_vgmstream_ps2_ass), "ass"},
+    {META(init_vgmstream_ubi_jade), "waa,wac,wad,wam,wav,lwav", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_ubi_jade_container), "waa,wac,wad,wam,wav,lwav,xma"},
+    {META(init_vgmstream_seg), "seg", 0x00, 4, 0x73656700},
+    {META(init_vgmstream_nds_strm_ffta2), "bin,strm"},
+    {META(init_vgmstream_knon), "str,asr", 0x00, 4, 0x4B4E4F4E},
+    {META(init_vgmstream_gca), "gca", 0x00, 4, 0x47434131},
+    {META(init_vgmstream_spt_spd), "spd"},
+    {META(init_vgmstream_ish_isd), "isd"},
+    {META(init_vgmstream_gsp_gsb), "gsb"},
+    {META(init_vgmstream_ydsp), "ydsp", 0x00, 4, 0x59445350},
+    {META(init_vgmstream_ngc_ssm), "ssm"},
+    {META(init_vgmstream_ps2_joe), "joe"},
+    {META(init_vgmstream_vgs), "vgs", 0x00, 4, 0x56675321},
+    {META(init_vgmstream_dcs_wav), "dcs"},
+    {META(init_vgmstream_mul), "mul,emff"},
+    {META(init_vgmstream_thp), "thp,dsp,mov,", 0x00, 4, 0x54485000},
+    {META(init_vgmstream_sts), "sts"},
+    {META(init_vgmstream_ps2_p2bt), "p2bt"},
+    {META(init_vgmstream_ps2_gbts), "gbts"},
+    {META(init_vgmstream_wii_sng), "sng", 0x00, 4, 0x30545352},
+    {META(init_vgmstream_ngc_dsp_iadp), "adp,iadp", 0x00, 4, 0x69616470},
+    {META(init_vgmstream_aax), "aax,", 0x00, 4, 0x40555446},
+    {META(init_vgmstream_utf_dsp), "aax,", 0x00, 4, 0x40555446},
+    {META(init_vgmstream_ngc_ffcc_str), "str"},
+    {META(init_vgmstream_sat_baka), ",baka", 0x00, 4, 0x42414B41},
+    {META(init_vgmstream_swav), "swav,adpcm", 0x00, 4, 0x53574156},
+    {META(init_vgmstream_vsf), "vsf", 0x00, 4, 0x56534600},
+    {META(init_vgmstream_nds_rrds), ",rrds"},
+    {META(init_vgmstream_ps2_vsf_tta), "vsf", 0x00, 4, 0x534D5353},
+    {META(init_vgmstream_ads_midway), "ads", 0x00, 4, 0x64685353},
+    {META(init_vgmstream_ps2_mcg), "mcg"},
+    {META(init_vgmstream_zsd), "zsd", 0x00, 4, 0x5A534400},
+    {META(init_vgmstream_vgs_ps), "vgs", 0x00, 4, 0x56475300},
+    {META(init_vgmstream_redspark), "rsd"},
+    {META(init_vgmstream_ivaud), "ivaud,"},
+    {META(init_vgmstream_wii_wsd), "wsd", 0x00, 4, 0x00000020},
+    {META(init_vgmstream_dsp_ndp), "nds,ndp", 0x00, 4, 0x4E445000},
+    {META(init_vgmstream_ps2_sps), "sps", 0x10, 4, 0x01000000},
+    {META(init_vgmstream_nds_hwas), "hwas", 0x00, 4, 0x73617768},
+    {META(init_vgmstream_ngc_lps), "lps", 0x08, 4, 0x10000000},
+    {META(init_vgmstream_ps2_snd), "snd", 0x00, 4, 0x53534E44},
+    {META(init_vgmstream_naomi_adpcm), "adpcm"},
+    {META(init_vgmstream_sd9), "sd9", 0x00, 4, 0x53443900},
+    {META(init_vgmstream_2dx9), "2dx9", 0x00, 4, 0x32445839},
+    {META(init_vgmstream_dsp_ygo), "dsp"},
+    {META(init_vgmstream_ps2_vgv), "vgv", 0x08, 4, 0x00000000},
+    {META(init_vgmstream_gcub), "wav,lwav,gcub", 0x00, 4, 0x47437562},
+    {META(init_vgmstream_maxis_xa), "xa"},
+    {META(init_vgmstream_ngc_sck_dsp), "dsp"},
+    {META(init_vgmstream_apple_caff), "caf", 0x00, 4, 0x63616666},
+    {META(init_vgmstream_pc_mxst), "mxst"},
+    {META(init_vgmstream_sab), "sab"},
+    {META(init_vgmstream_wii_bns), "bin,lbin,bns"},
+    {META(init_vgmstream_wii_was), "was,dsp,isws", 0x00, 4, 0x69535753},
+    {META(init_vgmstream_pona_3do), "pona,sxd", 0x00, 4, 0x13020000},
+    {META(init_vgmstream_pona_psx), "pona", 0x00, 4, 0x00000800},
+    {META(init_vgmstream_xbox_hlwav), "wav,lwav"},
+    {META(init_vgmstream_myspd), "myspd"},
+    {META(init_vgmstream_his), "his"},
+    {META(init_vgmstream_ast_mmv), "ast", 0x00, 4, 0x41535400},
+    {META(init_vgmstream_ast_mv), "ast", 0x00, 4, 0x41535400},
+    {META(init_vgmstream_dmsg), "sgt,dmsg", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_ngc_dsp_aaap), "dsp", 0x00, 4, 0x41414170},
+    {META(init_vgmstream_ngc_dsp_konami), "dsp"},
+    {META(init_vgmstream_ps2_wb), "wb", 0x00, 4, 0x00000000},
+    {META(init_vgmstream_bnsf), "bnsf", 0x00, 4, 0x424E5346},
+    {META(init_vgmstream_ps2_gcm), "gcm", 0x00, 4, 0x4D434700},
+    {META(init_vgmstream_smpl), "v0,v1", 0x00, 4, 0x534D504C},
+    {META(init_vgmstream_msa), "msa"},
+    {META(init_vgmstream_voi), "voi"},
+    {META(init_vgmstream_ngc_rkv), ",rkv,bo2", 0x00, 4, 0x00000000},
+    {META(init_vgmstream_dsp_ddsp), "adp,ddsp,wav,lwav"},
+    {META(init_vgmstream_p3d), "p3d"},
+    {META(init_vgmstream_ngc_dsp_mpds), "dsp,mds", 0x00, 4, 0x4D504453},
+    {META(init_vgmstream_dsp_str_ig), "str"},
+    {META(init_vgmstream_ea_swvr), "stream,str"},
+    {META(init_vgmstream_ps2_b1s), "b1s"},
+    {META(init_vgmstream_ps2_wad), "wad"},
+    {META(init_vgmstream_dsp_xiii), "dsp"},
+    {META(init_vgmstream_dsp_cabelas), "dsp"},
+    {META(init_vgmstream_lpcm_shade), "w,lpcm", 0x00, 4, 0x4C50434D},
+    {META(init_vgmstream_ps2_vms), "vms", 0x00, 4, 0x564D5320},
+    {META(init_vgmstream_xau), "xau", 0x00, 4, 0x58415500},
+    {META(init_vgmstream_bar), "bar"},
+    {META(init_vgmstream_ffw), "ffw"},
+    {META(init_vgmstream_dsp_dspw), "dspw", 0x00, 4, 0x44535057},
+    {META(init_vgmstream_jstm), "stm,jstm", 0x00, 4, 0x4A53544D},
+    {META(init_vgmstream_xvag), "xvag,", 0x00, 4, 0x58564147},
+    {META(init_vgmstream_cps), "cps", 0x00, 4, 0x43505320},
+    {META(init_vgmstream_sqex_scd), "scd", 0x0d, 1, 0x04},
+    {META(init_vgmstream_ngc_nst_dsp), "dsp"},
+    {META(init_vgmstream_baf), "baf", 0x00, 4, 0x42414E4B},
+    {META(init_vgmstream_msf), "msf,msa,at3,mp3,str"},
+    {META(init_vgmstream_ps3_past), "past", 0x00, 4, 0x534E4450},
+    {META(init_vgmstream_sgxd), "sgx,sgd,sgb"},
+    {META(init_vgmstream_wii_ras), "ras", 0x00, 4, 0x5241535F},
+    {META(init_vgmstream_spm), "spm", 0x00, 4, 0x53504D00},
+    {META(init_vgmstream_ps2_iab), "iab", 0x00, 4, 0x10000000},
+    {META(init_vgmstream_vs_str), "vs,str"},
+    {META(init_vgmstream_lsf_n1nj4n), "lsf"},
+    {META(init_vgmstream_xwav_new), "xwv,vawx", 0x00, 4, 0x56415758},
+    {META(init_vgmstream_xwav_old), "xwv", 0x00, 4, 0x58574156},
+    {META(init_vgmstream_hyperscan_kvag), "bvg", 0x00, 4, 0x4B564147},
+    {META(init_vgmstream_ios_psnd), "psnd", 0x00, 4, 0x50534E44},
+    {META(init_vgmstream_adp_wildfire), "adp", 0x00, 4, 0x41445021},
+    {META(init_vgmstream_adp_qd), "adp"},
+    {META(init_vgmstream_eb_sfx), "sfx,sf0"},
+    {META(init_vgmstream_eb_sf0), "sf0"},
+    {META(init_vgmstream_mtaf), "mtaf", 0x00, 4, 0x4D544146},
+    {META(init_vgmstream_alp), "tun,pcm", 0x00, 4, 0x414C5020},
+    {META(init_vgmstream_wpd), "wpd", 0x00, 4, 0x20445057},
+    {META(init_vgmstream_mn_str), "mnstr"},
+    {META(init_vgmstream_mss), "mss", 0x00, 4, 0x4D435353},
+    {META(init_vgmstream_ps2_hsf)},
+    {META(init_vgmstream_ivag), "ivag", 0x00, 4, 0x49564147},
+    {META(init_vgmstream_ps2_2pfs), "sap,2pfs", 0x00, 4, 0x32504653},
+    {META(init_vgmstream_xnb), "xnb"},
+    {META(init_vgmstream_ubi_ckd), "ckd", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_ps2_vbk), "vbk", 0x00, 4, 0x2E56424B},
+    {META(init_vgmstream_otm), "otm", 0x20, 4, 0x10B10200},
+    {META(init_vgmstream_bcstm), "bcstm", 0x00, 4, 0x4353544D},
+    {META(init_vgmstream_idsp_namco), "idsp", 0x00, 4, 0x49445350},
+    {META(init_vgmstream_kt_g1l), "g1l", 0x04, 4, 0x30303030},
+    {META(init_vgmstream_kt_wiibgm), "g1l,dsp"},
+    {META(init_vgmstream_bfstm)},
+    {META(init_vgmstream_mca), "mca"},
 #if 0
-    init_vgmstream_mp4_aac,
+    {META(init_vgmstream_mp4_aac)},
 #endif
 #if defined(VGM_USE_MP4V2) && defined(VGM_USE_FDKAAC)
-    init_vgmstream_akb_mp4,
+    {META(init_vgmstream_akb_mp4)},
 #endif
-    init_vgmstream_ktss,
-    init_vgmstream_hca,
-    init_vgmstream_svag_snk,
-    init_vgmstream_ps2_vds_vdm,
-    init_vgmstream_cxs,
-    init_vgmstream_adx_monster,
-    init_vgmstream_akb,
-    init_vgmstream_akb2,
+    {META(init_vgmstream_ktss), "kns,kno,ktss", 0x00, 4, 0x4B545353},
+    {META(init_vgmstream_hca), "hca"},
+    {META(init_vgmstream_svag_snk), "svag", 0x00, 4, 0x5641476D},
+    {META(init_vgmstream_ps2_vds_vdm), "vds,vdm"},
+    {META(init_vgmstream_cxs), "cxs", 0x00, 4, 0x43585320},
+    {META(init_vgmstream_adx_monster), "adx", 0x00, 4, 0x02000000},
+    {META(init_vgmstream_akb), "akb", 0x00, 4, 0x414B4220},
+    {META(init_vgmstream_akb2), "akb", 0x00, 4, 0x414B4232},
 #ifdef VGM_USE_FFMPEG
-    init_vgmstream_mp4_aac_ffmpeg,
+    {META(init_vgmstream_mp4_aac_ffmpeg), "mp4,m4a,m4v,lmp4,bin,lbin,msd", 0x04, 4, 0x66747970},
 #endif
-    init_vgmstream_bik,
-    init_vgmstream_astb,
-    init_vgmstream_wwise,
-    init_vgmstream_ubi_raki,
-    init_vgmstream_pasx,
-    init_vgmstream_xma,
-    init_vgmstream_sxd,
-    init_vgmstream_ogl,
-    init_vgmstream_mc3,
-    init_vgmstream_ghs,
-    init_vgmstream_aac_triace,
-    init_vgmstream_va3,
-    init_vgmstream_mta2,
-    init_vgmstream_mta2_container,
-    init_vgmstream_xa_xa30,
-    init_vgmstream_xa_04sw,
-    init_vgmstream_ea_bnk,
-    init_vgmstream_ea_abk,
-    init_vgmstream_ea_hdr_dat,
-    init_vgmstream_ea_hdr_dat_v2,
-    init_vgmstream_ea_map_mus,
-    init_vgmstream_ea_mpf_mus,
-    init_vgmstream_ea_schl_fixed,
-    init_vgmstream_sk_aud,
-    init_vgmstream_stma,
-    init_vgmstream_ea_snu,
-    init_vgmstream_awc,
-    init_vgmstream_opus_std,
-    init_vgmstream_opus_n1,
-    init_vgmstream_opus_capcom,
-    init_vgmstream_opus_nop,
-    init_vgmstream_opus_shinen,
-    init_vgmstream_opus_nus3,
-    init_vgmstream_opus_sps_n1,
-    init_vgmstream_opus_nxa,
-    init_vgmstream_pc_ast,
-    init_vgmstream_naac,
-    init_vgmstream_ubi_sb,
-    init_vgmstream_ubi_sm,
-    init_vgmstream_ubi_bnm,
-    init_vgmstream_ubi_bnm_ps2,
-    init_vgmstream_ubi_dat,
-    init_vgmstream_ubi_blk,
-    init_vgmstream_ezw,
-    init_vgmstream_vxn,
-    init_vgmstream_ea_snr_sns,
-    init_vgmstream_ea_sps,
-    init_vgmstream_ea_abk_eaac,
-    init_vgmstream_ea_hdr_sth_dat,
-    init_vgmstream_ea_mpf_mus_eaac,
-    init_vgmstream_ea_tmx,
-    init_vgmstream_ea_sbr,
-    init_vgmstream_ea_sbr_harmony,
-    init_vgmstream_vid1,
-    init_vgmstream_flx,
-    init_vgmstream_mogg,
-    init_vgmstream_kma9,
-    init_vgmstream_xwc,
-    init_vgmstream_atsl,
-    init_vgmstream_sps_n1,
-    init_vgmstream_atx,
-    init_vgmstream_sqex_sead,
-    init_vgmstream_waf,
-    init_vgmstream_wave,
-    init_vgmstream_wave_segmented,
-    init_vgmstream_smv,
-    init_vgmstream_nxap,
-    init_vgmstream_ea_wve_au00,
-    init_vgmstream_ea_wve_ad10,
-    init_vgmstream_sthd,
-    init_vgmstream_pcm_sre,
-    init_vgmstream_dsp_mcadpcm,
-    init_vgmstream_ubi_lyn,
-    init_vgmstream_ubi_lyn_container,
-    init_vgmstream_msb_msh,
-    init_vgmstream_txtp,
-    init_vgmstream_smc_smh,
-    init_vgmstream_ppst,
-    init_vgmstream_sps_n1_segmented,
-    init_vgmstream_ubi_bao_pk,
-    init_vgmstream_ubi_bao_atomic,
-    init_vgmstream_dsp_switch_audio,
-    init_vgmstream_sadf,
-    init_vgmstream_h4m,
-    init_vgmstream_ads_container,
-    init_vgmstream_asf,
-    init_vgmstream_xmd,
-    init_vgmstream_cks,
-    init_vgmstream_ckb,
-    init_vgmstream_wv6,
-    init_vgmstream_str_wav,
-    init_vgmstream_wavebatch,
-    init_vgmstream_hd3_bd3,
-    init_vgmstream_bnk_sony,
-    init_vgmstream_nus3bank,
-    init_vgmstream_sscf,
-    init_vgmstream_dsp_sps_n1,
-    init_vgmstream_dsp_itl_ch,
-    init_vgmstream_a2m,
-    init_vgmstream_ahv,
-    init_vgmstream_msv,
-    init_vgmstream_sdf,
-    init_vgmstream_svg,
-    init_vgmstream_vis,
-    init_vgmstream_vai,
-    init_vgmstream_aif_asobo,
-    init_vgmstream_ao,
-    init_vgmstream_apc,
-    init_vgmstream_wv2,
-    init_vgmstream_xau_konami,
-    init_vgmstream_derf,
-    init_vgmstream_utk,
-    init_vgmstream_adpcm_capcom,
-    init_vgmstream_ue4opus,
-    init_vgmstream_xwma,
-    init_vgmstream_xopus,
-    init_vgmstream_vs_square,
-    init_vgmstream_msf_banpresto_wmsf,
-    init_vgmstream_msf_banpresto_2msf,
-    init_vgmstream_nwav,
-    init_vgmstream_xpcm,
-    init_vgmstream_msf_tamasoft,
-    init_vgmstream_xps_dat,
-    init_vgmstream_xps,
-    init_vgmstream_zsnd,
-    init_vgmstream_opus_opusx,
-    init_vgmstream_dsp_adpy,
-    init_vgmstream_dsp_adpx,
-    init_vgmstream_ogg_opus,
-    init_vgmstream_nus3audio,
-    init_vgmstream_imc,
-    init_vgmstream_imc_container,
-    init_vgmstream_smp,
-    init_vgmstream_gin,
-    init_vgmstream_dsf,
-    init_vgmstream_208,
-    init_vgmstream_dsp_ds2,
-    init_vgmstream_ffdl,
-    init_vgmstream_mus_vc,
-    init_vgmstream_strm_abylight,
-    init_vgmstream_sfh,
-    init_vgmstream_ea_schl_video,
-    init_vgmstream_msf_konami,
-    init_vgmstream_xwma_konami,
-    init_vgmstream_9tav,
-    init_vgmstream_fsb5_fev_bank,
-    init_vgmstream_bwav,
-    init_vgmstream_opus_prototype,
-    init_vgmstream_awb,
-    init_vgmstream_acb,
-    init_vgmstream_rad,
-    init_vgmstream_smk,
-    init_vgmstream_mzrt_v0,
-    init_vgmstream_xavs,
-    init_vgmstream_psf_single,
-    init_vgmstream_psf_segmented,
-    init_vgmstream_dsp_itl,
-    init_vgmstream_sch,
-    init_vgmstream_ima,
-    init_vgmstream_nub,
-    init_vgmstream_nub_wav,
-    init_vgmstream_nub_vag,
-    init_vgmstream_nub_at3,
-    init_vgmstream_nub_xma,
-    init_vgmstream_nub_idsp,
-    init_vgmstream_nub_is14,
-    init_vgmstream_xwv_valve,
-    init_vgmstream_ubi_hx,
-    init_vgmstream_bmp_konami,
-    init_vgmstream_opus_opusnx,
-    init_vgmstream_opus_sqex,
-    init_vgmstream_isb,
-    init_vgmstream_xssb,
-    init_vgmstream_xma_ue3,
-    init_vgmstream_csb,
-    init_vgmstream_fwse,
-    init_vgmstream_fda,
-    init_vgmstream_kwb,
-    init_vgmstream_lrmd,
-    init_vgmstream_bkhd,
-    init_vgmstream_bkhd_fx,
-    init_vgmstream_diva,
-    init_vgmstream_imuse,
-    init_vgmstream_ktsr,
-    init_vgmstream_mups,
-    init_vgmstream_kat,
-    init_vgmstream_pcm_success,
-    init_vgmstream_ktsc,
-    init_vgmstream_adp_konami,
-    init_vgmstream_zwv,
-    init_vgmstream_dsb,
-    init_vgmstream_bsf,
-    init_vgmstream_sdrh_new,
-    init_vgmstream_sdrh_old,
-    init_vgmstream_wady,
-    init_vgmstream_dsp_sqex,
-    init_vgmstream_dsp_wiivoice,
-    init_vgmstream_xws,
-    init_vgmstream_cpk,
-    init_vgmstream_opus_nsopus,
-    init_vgmstream_sbk,
-    init_vgmstream_dsp_wiiadpcm,
-    init_vgmstream_dsp_cwac,
-    init_vgmstream_ifs,
-    init_vgmstream_acx,
-    init_vgmstream_compresswave,
-    init_vgmstream_ktac,
-    init_vgmstream_mzrt_v1,
-    init_vgmstream_bsnf,
-    init_vgmstream_tac,
-    init_vgmstream_idsp_tose,
-    init_vgmstream_dsp_kwa,
-    init_vgmstream_ogv_3rdeye,
-    init_vgmstream_sspr,
-    init_vgmstream_piff_tpcm,
-    init_vgmstream_wxd_wxh,
-    init_vgmstream_bnk_relic,
-    init_vgmstream_xsh_xsd_xss,
-    init_vgmstream_psb,
-    init_vgmstream_lopu_fb,
-    init_vgmstream_lpcm_fb,
-    init_vgmstream_wbk,
-    init_vgmstream_wbk_nslb,
-    init_vgmstream_dsp_apex,
-    init_vgmstream_ubi_ckd_cwav,
-    init_vgmstream_sspf,
-    init_vgmstream_opus_rsnd,
-    init_vgmstream_s3v,
-    init_vgmstream_esf,
-    init_vgmstream_adm3,
-    init_vgmstream_tt_ad,
-    init_vgmstream_bw_mp3_riff,
-    init_vgmstream_bw_riff_mp3,
-    init_vgmstream_sndz,
-    init_vgmstream_vab,
-    init_vgmstream_bigrp,
-    init_vgmstream_sscf_encrypted,
-    init_vgmstream_s_p_sth,
-    init_vgmstream_utf_ahx,
-    init_vgmstream_ego_dic,
-    init_vgmstream_awd,
-    init_vgmstream_rws_809,
-    init_vgmstream_pwb,
+    {META(init_vgmstream_bik), "bik,bik2,bk2,ps3,xmv,xen,vid,bika"},
+    {META(init_vgmstream_astb), "ast", 0x00, 4, 0x41535442},
+    {META(init_vgmstream_wwise), "wem,wav,lwav,ogg,logg,xma,bnk"},
+    {META(init_vgmstream_ubi_raki), "rak,ckd"},
+    {META(init_vgmstream_pasx), "past,sgb", 0x00, 4, 0x50415358},
+    {META(init_vgmstream_xma), "xma,xma2,wav,lwav,nps,str,kmx", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_sxd), "sxd,sxd2,sxd3"},
+    {META(init_vgmstream_ogl), "ogl", 0x17, 4, 0x766F7262},
+    {META(init_vgmstream_mc3), "mc3", 0x00, 4, 0x4D504333},
+    {META(init_vgmstream_ghs), "gtd", 0x00, 4, 0x47485320},
+    {META(init_vgmstream_aac_triace), "aac,laac"},
+    {META(init_vgmstream_va3), "va3", 0x00, 4, 0x21334156},
+    {META(init_vgmstream_mta2), "mta2", 0x00, 4, 0x4D544132},
+    {META(init_vgmstream_mta2_container), "dbm,bgm,mta2"},
+    {META(init_vgmstream_xa_xa30), "xa,xa30,e4x"},
+    {META(init_vgmstream_xa_04sw), "xa", 0x00, 4, 0x30345357},
+    {META(init_vgmstream_ea_bnk), "bnk,sdt,hdt,ldt,abk,ast"},
+    {META(init_vgmstream_ea_abk), "abk", 0x00, 4, 0x41424B43},
+    {META(init_vgmstream_ea_hdr_dat), "hdr"},
+    {META(init_vgmstream_ea_hdr_dat_v2), "hdr"},
+    {META(init_vgmstream_ea_map_mus), "map,lin,mpf", 0x00, 4, 0x50464478},
+    {META(init_vgmstream_ea_mpf_mus), "mpf"},
+    {META(init_vgmstream_ea_schl_fixed), "asf,lasf,cnk", 0x00, 4, 0x5343486C},
+    {META(init_vgmstream_sk_aud), "aud", 0x00, 4, 0x11534B10},
+    {META(init_vgmstream_stma), "stm,lstm"},
+    {META(init_vgmstream_ea_snu), "snu"},
+    {META(init_vgmstream_awc), "awc"},
+    {META(init_vgmstream_opus_std), "opus,lopus,bgm,opu", 0x00, 4, 0x01000080},
+    {META(init_vgmstream_opus_n1), "opus,lopus"},
+    {META(init_vgmstream_opus_capcom), "opus,lopus"},
+    {META(init_vgmstream_opus_nop), "nop"},
+    {META(init_vgmstream_opus_shinen), "opus,lopus", 0x08, 4, 0x01000080},
+    {META(init_vgmstream_opus_nus3), "opus,lopus", 0x00, 4, 0x4F505553},
+    {META(init_vgmstream_opus_sps_n1), "sps,nlsd,at9,opus,lopus", 0x00, 4, 0x09000000},
+    {META(init_vgmstream_opus_nxa), "nxa", 0x00, 4, 0x4E584131},
+    {META(init_vgmstream_pc_ast), "ast", 0x00, 4, 0x4153544C},
+    {META(init_vgmstream_naac), "naac", 0x00, 4, 0x41414320},
+    {META(init_vgmstream_ubi_sb), "sb0,sb1,sb2,sb3,sb4,sb5,sb6,sb7"},
+    {META(init_vgmstream_ubi_sm), "sm0,sm1,sm2,sm3,sm4,sm5,sm6,sm7,lm0,lm1,lm2,lm3,lm4,lm5,lm6,lm7"},
+    {META(init_vgmstream_ubi_bnm), "bnm"},
+    {META(init_vgmstream_ubi_bnm_ps2), "bnm"},
+    {META(init_vgmstream_ubi_dat), "dat"},
+    {META(init_vgmstream_ubi_blk), "blk"},
+    {META(init_vgmstream_ezw), "ezw"},
+    {META(init_vgmstream_vxn), "vxn", 0x00, 4, 0x566F784E},
+    {META(init_vgmstream_ea_snr_sns), "snr"},
+    {META(init_vgmstream_ea_sps), "sps"},
+    {META(init_vgmstream_ea_abk_eaac), "abk", 0x00, 4, 0x41424B43},
+    {META(init_vgmstream_ea_hdr_sth_dat), "hdr"},
+    {META(init_vgmstream_ea_mpf_mus_eaac), "mpf"},
+    {META(init_vgmstream_ea_tmx), "tmx"},
+    {META(init_vgmstream_ea_sbr), "sbr", 0x00, 4, 0x53424B52},
+    {META(init_vgmstream_ea_sbr_harmony), "sbr"},
+    {META(init_vgmstream_vid1), "vid,ogg,logg"},
+    {META(init_vgmstream_flx), "flx"},
+    {META(init_vgmstream_mogg), "mogg", 0x00, 4, 0x0A000000},
+    {META(init_vgmstream_kma9), "km9", 0x00, 4, 0x4B4D4139},
+    {META(init_vgmstream_xwc), "xwc"},
+    {META(init_vgmstream_atsl), "atsl,atsl3,atsl4,atslx", 0x00, 4, 0x4154534C},
+    {META(init_vgmstream_sps_n1), "sps"},
+    {META(init_vgmstream_atx), "atx", 0x00, 4, 0x41504133},
+    {META(init_vgmstream_sqex_sead), "sab,mab,sbin"},
+    {META(init_vgmstream_waf), "waf", 0x00, 4, 0x57414600},
+    {META(init_vgmstream_wave), "wave", 0x1e, 1, 0x00},
+    {META(init_vgmstream_wave_segmented), "wave", 0x04, 1, 0x01},
+    {META(init_vgmstream_smv), "smv"},
+    {META(init_vgmstream_nxap), "adp", 0x00, 4, 0x4E584150},
+    {META(init_vgmstream_ea_wve_au00), "wve,fsv", 0x00, 4, 0x564C4330},
+    {META(init_vgmstream_ea_wve_ad10), "wve,mov"},
+    {META(init_vgmstream_sthd), "stx", 0x00, 4, 0x53544844},
+    {META(init_vgmstream_pcm_sre), "pcm"},
+    {META(init_vgmstream_dsp_mcadpcm), "mcadpcm"},
+    {META(init_vgmstream_ubi_lyn), "sns,wav,lwav,son", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_ubi_lyn_container), "sns,wav,lwav,son"},
+    {META(init_vgmstream_msb_msh), "msb"},
+    {META(init_vgmstream_txtp), "txtp"},
+    {META(init_vgmstream_smc_smh), "smc"},
+    {META(init_vgmstream_ppst), "sng", 0x00, 4, 0x50505354},
+    {META(init_vgmstream_sps_n1_segmented), "at9,nlsd"},
+    {META(init_vgmstream_ubi_bao_pk), "pk,lpk,cpk", 0x00, 1, 0x01},
+    {META(init_vgmstream_ubi_bao_atomic), "bao,"},
+    {META(init_vgmstream_dsp_switch_audio), "switch_audio,dsp"},
+    {META(init_vgmstream_sadf), "sad,nop,", 0x00, 4, 0x73616466},
+    {META(init_vgmstream_h4m), "h4m,hvqm"},
+    {META(init_vgmstream_ads_container)},
+    {META(init_vgmstream_asf), "asf,lasf", 0x00, 4, 0x41534600},
+    {META(init_vgmstream_xmd), "xmd"},
+    {META(init_vgmstream_cks), "cks", 0x00, 4, 0x636B6D6B},
+    {META(init_vgmstream_ckb), "ckb", 0x00, 4, 0x636B6D6B},
+    {META(init_vgmstream_wv6), "wv6"},
+    {META(init_vgmstream_str_wav), "str,data"},
+    {META(init_vgmstream_wavebatch), "wavebatch", 0x00, 4, 0x54414257},
+    {META(init_vgmstream_hd3_bd3), "hd3", 0x00, 4, 0x50334844},
+    {META(init_vgmstream_bnk_sony), "bnk"},
+    {META(init_vgmstream_nus3bank), "nub2,nus3bank", 0x00, 4, 0x4E555333},
+    {META(init_vgmstream_sscf), "scd", 0x00, 4, 0x53534346},
+    {META(init_vgmstream_dsp_sps_n1), "vag,nlsd", 0x00, 4, 0x08000000},
+    {META(init_vgmstream_dsp_itl_ch), "itl"},
+    {META(init_vgmstream_a2m), "int", 0x00, 4, 0x41324D00},
+    {META(init_vgmstream_ahv), "ahv", 0x00, 4, 0x41485600},
+    {META(init_vgmstream_msv), "msv,msvp", 0x00, 4, 0x4D535670},
+    {META(init_vgmstream_sdf), "sdf", 0x00, 4, 0x53444600},
+    {META(init_vgmstream_svg), "svg", 0x00, 4, 0x53564770},
+    {META(init_vgmstream_vis), "vis", 0x00, 4, 0x56495341},
+    {META(init_vgmstream_vai), "vai"},
+    {META(init_vgmstream_aif_asobo), "aif,laif", 0x00, 2, 0x6900},
+    {META(init_vgmstream_ao), "ao"},
+    {META(init_vgmstream_apc), "apc", 0x00, 4, 0x4352594F},
+    {META(init_vgmstream_wv2), "wv2", 0x00, 4, 0x57415632},
+    {META(init_vgmstream_xau_konami), "xau", 0x00, 4, 0x53465842},
+    {META(init_vgmstream_derf), "adp", 0x00, 4, 0x44455246},
+    {META(init_vgmstream_utk), "utk", 0x00, 4, 0x55544D30},
+    {META(init_vgmstream_adpcm_capcom), "adpcm,mca", 0x00, 4, 0x02000000},
+    {META(init_vgmstream_ue4opus), "opus,lopus,ue4opus"},
+    {META(init_vgmstream_xwma), "xwma,xwm,xma,wma,lwma", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_xopus), "xopus", 0x00, 4, 0x584F7075},
+    {META(init_vgmstream_vs_square), "vs", 0x00, 4, 0x56530000},
+    {META(init_vgmstream_msf_banpresto_wmsf), "msf", 0x00, 4, 0x574D5346},
+    {META(init_vgmstream_msf_banpresto_2msf), "at9", 0x00, 4, 0x324D5346},
+    {META(init_vgmstream_nwav), "nwav,", 0x00, 4, 0x4E574156},
+    {META(init_vgmstream_xpcm), "pcm", 0x00, 4, 0x5850434D},
+    {META(init_vgmstream_msf_tamasoft), "msf", 0x00, 4, 0x4D534620},
+    {META(init_vgmstream_xps_dat), "xps", 0x0c, 4, 0x64696666},
+    {META(init_vgmstream_xps), "xps", 0x0c, 4, 0x64696666},
+    {META(init_vgmstream_zsnd), "zss,zsm,ens,enm,zsd", 0x00, 4, 0x5A534E44},
+    {META(init_vgmstream_opus_opusx), "opusx", 0x00, 4, 0x4F505553},
+    {META(init_vgmstream_dsp_adpy), "adpcmx", 0x00, 4, 0x41445059},
+    {META(init_vgmstream_dsp_adpx), "adpcmx", 0x00, 4, 0x41445058},
+    {META(init_vgmstream_ogg_opus), "opus,lopus,ogg,logg,bgm", 0x00, 4, 0x4F676753},
+    {META(init_vgmstream_nus3audio), "nus3audio", 0x00, 4, 0x4E555333},
+    {META(init_vgmstream_imc), "imc"},
+    {META(init_vgmstream_imc_container), "imc"},
+    {META(init_vgmstream_smp), "smp,snb"},
+    {META(init_vgmstream_gin), "gin"},
+    {META(init_vgmstream_dsf), "dsf"},
+    {META(init_vgmstream_208), "208"},
+    {META(init_vgmstream_dsp_ds2), "ds2,dsp"},
+    {META(init_vgmstream_ffdl), "ogg,logg,mp4,lmp4,bin,"},
+    {META(init_vgmstream_mus_vc), "mus"},
+    {META(init_vgmstream_strm_abylight), "strm", 0x00, 4, 0x5354524D},
+    {META(init_vgmstream_sfh), "at3,sspr", 0x00, 4, 0x00534648},
+    {META(init_vgmstream_ea_schl_video)},
+    {META(init_vgmstream_msf_konami), "msf", 0x00, 4, 0x4D534643},
+    {META(init_vgmstream_xwma_konami), "xwma", 0x00, 4, 0x58574D41},
+    {META(init_vgmstream_9tav), "9tav", 0x00, 4, 0x39544156},
+    {META(init_vgmstream_fsb5_fev_bank), "bank", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_bwav), "bwav", 0x00, 4, 0x42574156},
+    {META(init_vgmstream_opus_prototype), "opus,lopus", 0x00, 4, 0x4F505553},
+    {META(init_vgmstream_awb), "awb,afs2", 0x00, 4, 0x41465332},
+    {META(init_vgmstream_acb), "acb", 0x00, 4, 0x40555446},
+    {META(init_vgmstream_rad), "rad"},
+    {META(init_vgmstream_smk), "smk"},
+    {META(init_vgmstream_mzrt_v0), "idwav,idmsf,idxma", 0x00, 4, 0x6D7A7274},
+    {META(init_vgmstream_xavs), "xav", 0x00, 4, 0x58415653},
+    {META(init_vgmstream_psf_single), "psf,swd"},
+    {META(init_vgmstream_psf_segmented), "psf,swd"},
+    {META(init_vgmstream_dsp_itl), "itl,dsp"},
+    {META(init_vgmstream_sch), "sch"},
+    {META(init_vgmstream_ima), "ima", 0x00, 4, 0x02000000},
+    {META(init_vgmstream_nub), "nub,nub2", 0x04, 4, 0x00000000},
+    {META(init_vgmstream_nub_wav), "wav,lwav", 0x00, 4, 0x77617600},
+    {META(init_vgmstream_nub_vag), "vag", 0x00, 4, 0x76616700},
+    {META(init_vgmstream_nub_at3), "at3", 0x00, 4, 0x61743300},
+    {META(init_vgmstream_nub_xma), "xma"},
+    {META(init_vgmstream_nub_idsp), "idsp", 0x00, 4, 0x69647370},
+    {META(init_vgmstream_nub_is14), "is14", 0x00, 4, 0x69733134},
+    {META(init_vgmstream_xwv_valve), "wav,lwav", 0x00, 4, 0x58575620},
+    {META(init_vgmstream_ubi_hx), "hxd,hxc,hx2,hxg,hxx,hx3"},
+    {META(init_vgmstream_bmp_konami), "bin,lbin", 0x00, 4, 0x424D5000},
+    {META(init_vgmstream_opus_opusnx), "opus,lopus"},
+    {META(init_vgmstream_opus_sqex), "wav,lwav", 0x00, 4, 0x01000000},
+    {META(init_vgmstream_isb), "isb"},
+    {META(init_vgmstream_xssb), "bin,lbin", 0x00, 4, 0x58535342},
+    {META(init_vgmstream_xma_ue3), "xma,x360audio,"},
+    {META(init_vgmstream_csb), "csb", 0x00, 4, 0x40555446},
+    {META(init_vgmstream_fwse), "fwse"},
+    {META(init_vgmstream_fda), "fda"},
+    {META(init_vgmstream_kwb), "wbd,wb2,sed"},
+    {META(init_vgmstream_lrmd), "lrmh", 0x00, 4, 0x4C524D44},
+    {META(init_vgmstream_bkhd), "bnk"},
+    {META(init_vgmstream_bkhd_fx), "wem,bnk"},
+    {META(init_vgmstream_diva), "diva", 0x00, 4, 0x44495641},
+    {META(init_vgmstream_imuse), "imx,imc,wav,lwav"},
+    {META(init_vgmstream_ktsr), "ktsl2asbin,asbin", 0x00, 4, 0x4B545352},
+    {META(init_vgmstream_mups), "mups,", 0x00, 4, 0x4D555053},
+    {META(init_vgmstream_kat), "kat"},
+    {META(init_vgmstream_pcm_success), "pcm", 0x00, 4, 0x50434D20},
+    {META(init_vgmstream_ktsc), "ktsl2asbin,asbin", 0x00, 4, 0x4B545343},
+    {META(init_vgmstream_adp_konami), "adp", 0x00, 4, 0x41445002},
+    {META(init_vgmstream_zwv), "zwv", 0x00, 4, 0x77617665},
+    {META(init_vgmstream_dsb), "dsb", 0x00, 4, 0x44535342},
+    {META(init_vgmstream_bsf), "bsf", 0x00, 4, 0x48465342},
+    {META(init_vgmstream_sdrh_new), "xse", 0x00, 4, 0x48524453},
+    {META(init_vgmstream_sdrh_old), "xse", 0x00, 4, 0x53445248},
+    {META(init_vgmstream_wady), "way,", 0x00, 4, 0x57414459},
+    {META(init_vgmstream_dsp_sqex), "wav,lwav", 0x00, 4, 0x00000000},
+    {META(init_vgmstream_dsp_wiivoice), "dsp"},
+    {META(init_vgmstream_xws), "xws"},
+    {META(init_vgmstream_cpk), "awb", 0x00, 4, 0x43504B20},
+    {META(init_vgmstream_opus_nsopus), "nsopus", 0x00, 4, 0x45574E4F},
+    {META(init_vgmstream_sbk), "sbk", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_dsp_wiiadpcm), "adpcm"},
+    {META(init_vgmstream_dsp_cwac), "dsp", 0x00, 4, 0x43574143},
+    {META(init_vgmstream_ifs), "ifs", 0x00, 4, 0x6CAD8F89},
+    {META(init_vgmstream_acx), "acx", 0x00, 4, 0x00000000},
+    {META(init_vgmstream_compresswave), "cwav"},
+    {META(init_vgmstream_ktac)},
+    {META(init_vgmstream_mzrt_v1), "idmsf", 0x00, 4, 0x6D7A7274},
+    {META(init_vgmstream_bsnf), "bsnd", 0x00, 4, 0x62736E66},
+    {META(init_vgmstream_tac), ",aac,laac"},
+    {META(init_vgmstream_idsp_tose), "idsp"},
+    {META(init_vgmstream_dsp_kwa), "kwa"},
+    {META(init_vgmstream_ogv_3rdeye), "ogv", 0x00, 4, 0x4F475600},
+    {META(init_vgmstream_sspr), "sspr", 0x00, 4, 0x53535052},
+    {META(init_vgmstream_piff_tpcm), "tad", 0x38, 4, 0x424F4459},
+    {META(init_vgmstream_wxd_wxh), "wxd", 0x00, 4, 0x57584431},
+    {META(init_vgmstream_bnk_relic), "bnk", 0x00, 4, 0x424E4B30},
+    {META(init_vgmstream_xsh_xsd_xss), "xsh"},
+    {META(init_vgmstream_psb), "psb", 0x00, 4, 0x50534200},
+    {META(init_vgmstream_lopu_fb), "lopus", 0x00, 4, 0x4C4F5055},
+    {META(init_vgmstream_lpcm_fb), "ladpcm", 0x00, 4, 0x4C50434D},
+    {META(init_vgmstream_wbk), "wbk"},
+    {META(init_vgmstream_wbk_nslb), "wbk", 0x00, 4, 0x4E534C42},
+    {META(init_vgmstream_dsp_apex), "dsp", 0x00, 4, 0x41504558},
+    {META(init_vgmstream_ubi_ckd_cwav), "wav,lwav", 0x00, 4, 0x52494646},
+    {META(init_vgmstream_sspf), "ssp", 0x00, 4, 0x53535046},
+    {META(init_vgmstream_opus_rsnd), "rsnd", 0x00, 4, 0x52534E44},
+    {META(init_vgmstream_s3v), "s3v", 0x00, 4, 0x53335630},
+    {META(init_vgmstream_esf), "esf"},
+    {META(init_vgmstream_adm3), "wem", 0x00, 4, 0x41444D33},
+    {META(init_vgmstream_tt_ad), "audio_data", 0x00, 4, 0x464D5420},
+    {META(init_vgmstream_bw_mp3_riff), NULL, 0x00, 4, 0xFFF360C4},
+    {META(init_vgmstream_bw_riff_mp3), NULL, 0x00, 4, 0x52494646},
+    {META(init_vgmstream_sndz), "szd1,szd,szd3", 0x00, 4, 0x534E445A},
+    {META(init_vgmstream_vab), NULL, 0x00, 4, 0x70424156},
+    {META(init_vgmstream_bigrp), "bigrp"},
+    {META(init_vgmstream_sscf_encrypted), "scd", 0x00, 4, 0x53534346},
+    {META(init_vgmstream_s_p_sth), "gtd"},
+    {META(init_vgmstream_utf_ahx), "aax,", 0x00, 4, 0x40555446},
+    {META(init_vgmstream_ego_dic), "dic", 0x00, 4, 0x44494331},
+    {META(init_vgmstream_awd), "awd,hwd,lwd"},
+    {META(init_vgmstream_rws_809), "rws", 0x00, 4, 0x09080000},
+    {META(init_vgmstream_pwb), "pwb"},
 
     /* lower priority metas (no clean header identity, somewhat ambiguous, or need extension/companion file to identify) */
-    init_vgmstream_scd_pcm,
-    init_vgmstream_agsc,
-    init_vgmstream_ps2_wmus,
-    init_vgmstream_mib_mih,
-    init_vgmstream_mjb_mjh,
-    init_vgmstream_mic_koei,
-    init_vgmstream_seb,
-    init_vgmstream_tgc,
+    {META(init_vgmstream_scd_pcm), "pcm"},
+    {META(init_vgmstream_agsc), "agsc"},
+    {META(init_vgmstream_ps2_wmus), "wmus"},
+    {META(init_vgmstream_mib_mih), "mib"},
+    {META(init_vgmstream_mjb_mjh), "mjb"},
+    {META(init_vgmstream_mic_koei), "mic"},
+    {META(init_vgmstream_seb), "seb,gms,"},
+    {META(init_vgmstream_tgc), "4"},
     /* need companion files */
-    init_vgmstream_pos,
-    init_vgmstream_sli_loops,
+    {META(init_vgmstream_pos), "pos"},
+    {META(init_vgmstream_sli_loops), "sli"},
 
     /* lowest priority metas (should go after all metas, and TXTH should go before raw formats) */
-    init_vgmstream_txth,            /* proper parsers should supersede TXTH, once added */
-    init_vgmstream_dtk,             /* semi-raw GC streamed files */
-    init_vgmstream_mpeg,            /* semi-raw MP3 */
-    init_vgmstream_btsnd,           /* semi-headerless */
-    init_vgmstream_fsb_encrypted,
-    init_vgmstream_nus3bank_encrypted,
-    init_vgmstream_encrypted,       /* encrypted stuff */
-    init_vgmstream_raw_rsf,         /* raw GC streamed files */
-    init_vgmstream_raw_int,         /* .int raw PCM */
-    init_vgmstream_ps_headerless,   /* tries to detect a bunch of PS-ADPCM formats */
-    init_vgmstream_raw_snds,        /* .snds raw SNDS IMA */
-    init_vgmstream_raw_wavm,        /* .wavm raw xbox */
-    init_vgmstream_raw_pcm,         /* .raw raw PCM */
-    init_vgmstream_raw_s14_sss,     /* .s14/sss raw siren14 */
-    init_vgmstream_exakt_sc,        /* .sc raw PCM */
-    init_vgmstream_zwdsp,           /* fake format */
-    init_vgmstream_ps2_adm,         /* weird non-constant PSX blocks */
-    init_vgmstream_rwsd,            /* crap, to be removed */
+    {META(init_vgmstream_txth)},          /* proper parsers should supersede TXTH, once added */
+    {META(init_vgmstream_dtk), "dtk,adp,trk,wav,lwav"}, /* semi-raw GC streamed files */
+    {META(init_vgmstream_mpeg)},          /* semi-raw MP3 */
+    {META(init_vgmstream_btsnd), "btsnd", 0x00, 4, 0x00000002}, /* semi-headerless */
+    {META(init_vgmstream_fsb_encrypted), "fsb,ps3,xen"},
+    {META(init_vgmstream_nus3bank_encrypted), "nus3bank,xma", 0x00, 4, 0x552AAF17},
+    {META(init_vgmstream_encrypted)},     /* encrypted stuff */
+    {META(init_vgmstream_raw_rsf), "rsf"}, /* raw GC streamed files */
+    {META(init_vgmstream_raw_int), "int,wp2"}, /* .int raw PCM */
+    {META(init_vgmstream_ps_headerless), "mib,mi4"}, /* tries to detect a bunch of PS-ADPCM formats */
+    {META(init_vgmstream_raw_snds), "snds"}, /* .snds raw SNDS IMA */
+    {META(init_vgmstream_raw_wavm), "wavm"}, /* .wavm raw xbox */
+    {META(init_vgmstream_raw_pcm), "raw"}, /* .raw raw PCM */
+    {META(init_vgmstream_raw_s14_sss)},   /* .s14/sss raw siren14 */
+    {META(init_vgmstream_exakt_sc), "sc"}, /* .sc raw PCM */
+    {META(init_vgmstream_zwdsp), "zwdsp", 0x00, 4, 0x00000000}, /* fake format */
+    {META(init_vgmstream_ps2_adm), "adm"}, /* weird non-constant PSX blocks */
+    {META(init_vgmstream_rwsd), "brwsd,rwsd", 0x00, 4, 0x52575344}, /* crap, to be removed */
 #ifdef VGM_USE_FFMPEG
-    init_vgmstream_ffmpeg,          /* may play anything incorrectly, since FFmpeg doesn't check extensions */
+    {META(init_vgmstream_ffmpeg)},        /* may play anything incorrectly, since FFmpeg doesn't check extensions */
 #endif
 };
 
@@ -568,106 +586,208 @@ static const int init_vgmstream_count = LOCAL_ARRAY_LENGTH(init_vgmstream_functi
 /* INIT/META                                                                 */
 /*****************************************************************************/
 
-/* internal version with all parameters */
-static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf) {
-    if (!sf)
-        return NULL;
+#define META_HEADER_SIZE  0x40
+/* most metas only check values around the header or footer, so detection reads them once */
+#define META_SNAPSHOT_HEAD_SIZE  0x10000
+#define META_SNAPSHOT_TAIL_SIZE  0x1000
 
-    /* try a series of formats, see which works */
-    for (int i = 0; i < init_vgmstream_count; i++) {
-        init_vgmstream_t init_vgmstream_function = init_vgmstream_functions[i];
-    
+/* Checks if a meta may accept the file, using the meta's required ext and magic (no reads) */
+static int meta_may_accept(const meta_entry_t* meta, const char* ext, const uint8_t* head, size_t head_size) {
+    uint32_t value;
 
-        /* call init function and see if valid VGMSTREAM was returned */
-        VGMSTREAM* vgmstream = init_vgmstream_function(sf);
-        if (!vgmstream)
-            continue;
-
-        /* fail if there is nothing/too much to play (<=0 generates empty files, >N writes GBs of garbage) */
-        if (vgmstream->num_samples <= 0 || vgmstream->num_samples > VGMSTREAM_MAX_NUM_SAMPLES) {
-            VGM_LOG("VGMSTREAM: wrong num_samples %i\n", vgmstream->num_samples);
-            close_vgmstream(vgmstream);
-            continue;
-        }
+    if (meta->exts && !check_extension_list(ext, meta->exts))
+        return 0;
 
-        /* everything should have a reasonable sample rate */
-        if (vgmstream->sample_rate < VGMSTREAM_MIN_SAMPLE_RATE || vgmstream->sample_rate > VGMSTREAM_MAX_SAMPLE_RATE) {
-            VGM_LOG("VGMSTREAM: wrong sample_rate %i\n", vgmstream->sample_rate);
-            close_vgmstream(vgmstream);
-            continue;
+    if (meta->magic_size) {
+        if (meta->magic_offset + meta->magic_size > head_size) {
+            value = 0xFFFFFFFF; /* same as failed reads */
         }
-
-        /* sanify loops and remove bad metadata */
-        if (vgmstream->loop_flag) {
-            if (vgmstream->loop_end_sample <= vgmstream->loop_start_sample
-                    || vgmstream->loop_end_sample > vgmstream->num_samples
-                    || vgmstream->loop_start_sample < 0) {
-                VGM_LOG("VGMSTREAM: wrong loops ignored (lss=%i, lse=%i, ns=%i)\n",
-                        vgmstream->loop_start_sample, vgmstream->loop_end_sample, vgmstream->num_samples);
-                vgmstream->loop_flag = 0;
-                vgmstream->loop_start_sample = 0;
-                vgmstream->loop_end_sample = 0;
+        else {
+            switch(meta->magic_size) {
+                case 1: value = head[meta->magic_offset]; break;
+                case 2: value = get_u16be(head + meta->magic_offset); break;
+                default: value = get_u32be(head + meta->magic_offset); break;
             }
         }
 
-        /* test if candidate for dual stereo */
-        if (vgmstream->channels == 1 && vgmstream->allow_dual_stereo == 1) {
-            try_dual_file_stereo(vgmstream, sf, init_vgmstream_function);
-        }
+        if (meta->magic_size < 4)
+            value &= (1U << (meta->magic_size * 8)) - 1;
+        if (value != meta->magic)
+            return 0;
+    }
+
+    return 1;
+}
+
+#ifdef VGM_DEBUG_OUTPUT
+/* Calls a meta that was skipped, to catch table entries that got out of sync with the meta's checks
+ * (otherwise the meta is silently never tried). Same as calling all metas, so only done in debug builds. */
+static void meta_check_skipped(const meta_entry_t* meta, int index, STREAMFILE* sf) {
+    VGMSTREAM* vgmstream = meta->init(sf);
+    if (!vgmstream)
+        return;
+
+    VGM_LOG("VGMSTREAM: meta %i accepts file but was skipped (wrong exts/magic in init list?)\n", index);
+    close_vgmstream(vgmstream);
+}
+#endif
 
-        /* clean as loops are readable metadata but loop fields may contain garbage
-         * (done *after* dual stereo as it needs loop fields to match) */
-        if (!vgmstream->loop_flag) {
+/* Calls a meta through a counting SF to register its time and IO (opened SFs must be reopened from
+ * the passed SF as usual, so it can be closed once done). */
+static VGMSTREAM* init_vgmstream_profiled(const meta_entry_t* meta, int index, STREAMFILE* sf) {
+    VGMSTREAM* vgmstream;
+    STREAMFILE* sf_stats;
+    double start;
+
+    sf_stats = open_stats_streamfile_f(open_wrap_streamfile(sf));
+    if (!sf_stats) /* shouldn't happen */
+        return meta->init(sf);
+
+    start = meta_profile_get_time();
+    vgmstream = meta->init(sf_stats);
+    meta_profile_add(index, meta->name, meta->exts, vgmstream, meta_profile_get_time() - start, sf_stats);
+
+    /* SFs opened by the meta are counting SFs too, that now just pass reads for playback */
+    stop_streamfile_stats(sf_stats);
+    close_streamfile(sf_stats);
+    return vgmstream;
+}
+
+/* tries a meta with a SF, and validates the result */
+static VGMSTREAM* init_vgmstream_meta(STREAMFILE* sf, int index) {
+    const meta_entry_t* meta = &init_vgmstream_functions[index];
+    VGMSTREAM* vgmstream;
+
+    /* call init function and see if valid VGMSTREAM was returned */
+    if (meta_profile_is_enabled())
+        vgmstream = init_vgmstream_profiled(meta, index, sf);
+    else
+        vgmstream = meta->init(sf);
+    if (!vgmstream)
+        return NULL;
+
+    /* fail if there is nothing/too much to play (<=0 generates empty files, >N writes GBs of garbage) */
+    if (vgmstream->num_samples <= 0 || vgmstream->num_samples > VGMSTREAM_MAX_NUM_SAMPLES) {
+        VGM_LOG("VGMSTREAM: wrong num_samples %i\n", vgmstream->num_samples);
+        close_vgmstream(vgmstream);
+        return NULL;
+    }
+
+    /* everything should have a reasonable sample rate */
+    if (vgmstream->sample_rate < VGMSTREAM_MIN_SAMPLE_RATE || vgmstream->sample_rate > VGMSTREAM_MAX_SAMPLE_RATE) {
+        VGM_LOG("VGMSTREAM: wrong sample_rate %i\n", vgmstream->sample_rate);
+        close_vgmstream(vgmstream);
+        return NULL;
+    }
+
+    /* sanify loops and remove bad metadata */
+    if (vgmstream->loop_flag) {
+        if (vgmstream->loop_end_sample <= vgmstream->loop_start_sample
+                || vgmstream->loop_end_sample > vgmstream->num_samples
+                || vgmstream->loop_start_sample < 0) {
+            VGM_LOG("VGMSTREAM: wrong loops ignored (lss=%i, lse=%i, ns=%i)\n",
+                    vgmstream->loop_start_sample, vgmstream->loop_end_sample, vgmstream->num_samples);
+            vgmstream->loop_flag = 0;
             vgmstream->loop_start_sample = 0;
             vgmstream->loop_end_sample = 0;
         }
+    }
+
+    /* test if candidate for dual stereo */
+    if (vgmstream->channels == 1 && vgmstream->allow_dual_stereo == 1) {
+        try_dual_file_stereo(vgmstream, sf, meta->init);
+    }
+
+    /* clean as loops are readable metadata but loop fields may contain garbage
+     * (done *after* dual stereo as it needs loop fields to match) */
+    if (!vgmstream->loop_flag) {
+        vgmstream->loop_start_sample = 0;
+        vgmstream->loop_end_sample = 0;
+    }
 
 #ifdef VGM_USE_FFMPEG
-        /* check FFmpeg streams here, for lack of a better place */
-        if (vgmstream->coding_type == coding_FFmpeg) {
-            int ffmpeg_subsongs = ffmpeg_get_subsong_count(vgmstream->codec_data);
-            if (ffmpeg_subsongs && !vgmstream->num_streams) {
-                vgmstream->num_streams = ffmpeg_subsongs;
-            }
+    /* check FFmpeg streams here, for lack of a better place */
+    if (vgmstream->coding_type == coding_FFmpeg) {
+        int ffmpeg_subsongs = ffmpeg_get_subsong_count(vgmstream->codec_data);
+        if (ffmpeg_subsongs && !vgmstream->num_streams) {
+            vgmstream->num_streams = ffmpeg_subsongs;
         }
+    }
 #endif
 
-        /* some players are picky with incorrect channel layouts */
-        if (vgmstream->channel_layout > 0) {
-            int output_channels = vgmstream->channels;
-            int ch, count = 0, max_ch = 32;
-            for (ch = 0; ch < max_ch; ch++) {
-                int bit = (vgmstream->channel_layout >> ch) & 1;
-                if (ch > 17 && bit) {
-                    VGM_LOG("VGMSTREAM: wrong bit %i in channel_layout %x\n", ch, vgmstream->channel_layout);
-                    vgmstream->channel_layout = 0;
-                    break;
-                }
-                count += bit;
-            }
-
-            if (count > output_channels) {
-                VGM_LOG("VGMSTREAM: wrong totals %i in channel_layout %x\n", count, vgmstream->channel_layout);
+    /* some players are picky with incorrect channel layouts */
+    if (vgmstream->channel_layout > 0) {
+        int output_channels = vgmstream->channels;
+        int ch, count = 0, max_ch = 32;
+        for (ch = 0; ch < max_ch; ch++) {
+            int bit = (vgmstream->channel_layout >> ch) & 1;
+            if (ch > 17 && bit) {
+                VGM_LOG("VGMSTREAM: wrong bit %i in channel_layout %x\n", ch, vgmstream->channel_layout);
                 vgmstream->channel_layout = 0;
+                break;
             }
+            count += bit;
         }
 
-        /* files can have thousands subsongs, but let's put a limit */
-        if (vgmstream->num_streams < 0 || vgmstream->num_streams > VGMSTREAM_MAX_SUBSONGS) {
-            VGM_LOG("VGMSTREAM: wrong num_streams (ns=%i)\n", vgmstream->num_streams);
-            close_vgmstream(vgmstream);
-            continue;
+        if (count > output_channels) {
+            VGM_LOG("VGMSTREAM: wrong totals %i in channel_layout %x\n", count, vgmstream->channel_layout);
+            vgmstream->channel_layout = 0;
         }
+    }
 
-        /* save info */
-        /* stream_index 0 may be used by plugins to signal "vgmstream default" (IOW don't force to 1) */
-        if (vgmstream->stream_index == 0) {
-            vgmstream->stream_index = sf->stream_index;
-        }
+    /* files can have thousands subsongs, but let's put a limit */
+    if (vgmstream->num_streams < 0 || vgmstream->num_streams > VGMSTREAM_MAX_SUBSONGS) {
+        VGM_LOG("VGMSTREAM: wrong num_streams (ns=%i)\n", vgmstream->num_streams);
+        close_vgmstream(vgmstream);
+        return NULL;
+    }
+
+    /* save info */
+    /* stream_index 0 may be used by plugins to signal "vgmstream default" (IOW don't force to 1) */
+    if (vgmstream->stream_index == 0) {
+        vgmstream->stream_index = sf->stream_index;
+    }
+
+
+    setup_vgmstream(vgmstream); /* final setup */
+
+    return vgmstream;
+}
+
+/* tries all metas with a SF, and sets the index of the one that worked (if p_meta is set) */
+static VGMSTREAM* init_vgmstream_metas(STREAMFILE* sf, int* p_meta) {
+    char filename[PATH_LIMIT];
+    const char* ext;
+    uint8_t head[META_HEADER_SIZE];
+    size_t head_size;
+    int profile;
+
+    profile = meta_profile_is_enabled();
+
+    /* read what metas check first just once */
+    get_streamfile_name(sf, filename, sizeof(filename));
+    ext = filename_extension(filename);
+    head_size = read_streamfile(head, 0x00, sizeof(head), sf);
 
+    /* try a series of formats, see which works */
+    for (int i = 0; i < init_vgmstream_count; i++) {
+        VGMSTREAM* vgmstream;
+
+        if (!meta_may_accept(&init_vgmstream_functions[i], ext, head, head_size)) {
+            if (profile)
+                meta_profile_skip(i, init_vgmstream_functions[i].name, init_vgmstream_functions[i].exts);
+#ifdef VGM_DEBUG_OUTPUT
+            meta_check_skipped(&init_vgmstream_functions[i], i, sf);
+#endif
+            continue;
+        }
 
-        setup_vgmstream(vgmstream); /* final setup */
+        vgmstream = init_vgmstream_meta(sf, i);
+        if (!vgmstream)
+            continue;
 
+        if (p_meta)
+            *p_meta = i;
         return vgmstream;
     }
 
@@ -675,6 +795,36 @@ static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf) {
     return NULL;
 }
 
+/* internal version with all parameters */
+static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf, int* p_meta) {
+    VGMSTREAM* vgmstream;
+    STREAMFILE* sf_snap;
+
+    if (!sf)
+        return NULL;
+
+    /* known meta (same file opened again) is tried first, without detection */
+    if (p_meta && *p_meta >= 0 && *p_meta < init_vgmstream_count) {
+        vgmstream = init_vgmstream_meta(sf, *p_meta);
+        if (vgmstream)
+            return vgmstream;
+    }
+
+    /* nested inits (like metas calling init_vgmstream_from_STREAMFILE with a subfile) read from one already */
+    if (is_snapshot_streamfile(sf))
+        return init_vgmstream_metas(sf, p_meta);
+
+    /* metas must reopen SFs they need once done (as usual), so snapshot can be discarded */
+    sf_snap = open_snapshot_streamfile(sf, META_SNAPSHOT_HEAD_SIZE, META_SNAPSHOT_TAIL_SIZE);
+    if (!sf_snap) /* shouldn't happen */
+        return init_vgmstream_metas(sf, p_meta);
+
+    vgmstream = init_vgmstream_metas(sf_snap, p_meta);
+
+    close_streamfile(sf_snap);
+    return vgmstream;
+}
+
 void setup_vgmstream(VGMSTREAM* vgmstream) {
 
     /* save start things so we can restart when seeking */
@@ -698,7 +848,11 @@ VGMSTREAM* init_vgmstream(const char* const filename) {
 }
 
 VGMSTREAM* init_vgmstream_from_STREAMFILE(STREAMFILE* sf) {
-    return init_vgmstream_internal(sf);
+    return init_vgmstream_internal(sf, NULL);
+}
+
+VGMSTREAM* init_vgmstream_from_STREAMFILE_meta(STREAMFILE* sf, int* p_meta) {
+    return init_vgmstream_internal(sf, p_meta);
 }
 
 /* Reset a VGMSTREAM to its state at the start of playback (when a plugin seeks back to zero). */
@@ -250,6 +250,9 @@ typedef struct {
     int loop_target;                /* max loops before continuing with the stream end (loops forever if not set) */
     sample_t* tmpbuf;               /* garbage buffer used for seeking/trimming */
     size_t tmpbuf_size;             /* for all channels (samples = tmpbuf_size / channels) */
+    int32_t planar_size;            /* samples per channel plane while rendering planar (0 = interleaved) */
+    void* decode_threads;           /* optional pool to decode groups of channels in parallel (see decode.c) */
+    void* seek_table;               /* optional saved decoder states for faster seeks (see seek_table.c) */
 
 } VGMSTREAM;
 
@@ -260,9 +263,21 @@ typedef struct {
     VGMSTREAM** segments;
     int current_segment;
     sample_t* buffer;
+    float* buffer_f32;      /* same, for float renders */
     int input_channels;     /* internal buffer channels */
     int output_channels;    /* resulting channels (after mixing, if applied) */
     int mixed_channels;     /* segments have different number of channels */
+    int32_t* segment_starts; /* first sample of each segment (+1 entry with total), for seeking */
+
+    /* deferred mode: segments are opened when reached and closed after use (NULL while closed) */
+    VGMSTREAM* (*open_segment)(void* open_data, int segment);
+    void (*free_open_data)(void* open_data);
+    void* open_data;
+    int decode_threads;     /* applied to segments as they are opened */
+    int32_t seek_interval;  /* same, for seek tables */
+    int sample_rate;        /* info of closed segments, for allocate_segmented_vgmstream */
+    int channel_layout;
+    coding_t coding_type;
 } segmented_layout_data;
 
 /* for files made of "parallel" layers, one per group of channels (using a complete sub-VGMSTREAM) */
@@ -270,9 +285,14 @@ typedef struct {
     int layer_count;
     VGMSTREAM** layers;
     sample_t* buffer;
+    float* buffer_f32;      /* same, for float renders */
     int input_channels;     /* internal buffer channels */
     int output_channels;    /* resulting channels (after mixing, if applied) */
     int external_looping;   /* don't loop using per-layer loops, but layout's own looping */
+
+    void* threads;                  /* optional pool to render layers in parallel (see layered.c) */
+    sample_t** layer_buffers;       /* per-layer buffers when using threads */
+    float** layer_buffers_f32;
 } layered_layout_data;
 
 
@@ -337,6 +357,10 @@ VGMSTREAM* init_vgmstream(const char* const filename);
 /* init with custom IO via streamfile */
 VGMSTREAM* init_vgmstream_from_STREAMFILE(STREAMFILE* sf);
 
+/* same, but tries the meta in *p_meta first (-1 = none) and sets the one that worked, so reopening
+ * the same file later can skip format detection */
+VGMSTREAM* init_vgmstream_from_STREAMFILE_meta(STREAMFILE* sf, int* p_meta);
+
 /* reset a VGMSTREAM to start of stream */
 void reset_vgmstream(VGMSTREAM* vgmstream);
 
@@ -349,6 +373,14 @@ int32_t get_vgmstream_play_samples(double looptimes, double fadeseconds, double
 /* Decode data into sample buffer. Returns < sample_count on stream end */
 int render_vgmstream(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
 
+/* Same, but buffer is split into output_channels planes of sample_count samples (channel N starts at
+ * buffer + N * sample_count), for callers that work with planar audio. */
+int render_vgmstream_planar(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+
+/* Same, but buffer gets interleaved float samples in the -1.0..1.0 range (not clipped, so mixing
+ * may go past it). Buffer must fit max(input, output) channels, like render_vgmstream. */
+int render_vgmstream_f32(float* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+
 /* Seek to sample position (next render starts from that point). Use only after config is set (vgmstream_apply_config) */
 void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample);
 